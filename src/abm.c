@@ -0,0 +1,203 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "throughput.h"
+#include "abm.h"
+
+//***********************************************
+//************EMULATED_INSTRUCTIONS**************
+//***********************************************
+
+uint64_t emulated_popcnt(uint64_t val) {
+    const uint64_t c1  = 0x5555555555555555;
+    const uint64_t c2  = 0x3333333333333333;
+    const uint64_t c4  = 0x0f0f0f0f0f0f0f0f;
+    const uint64_t h01 = 0x0101010101010101;
+
+    val -= (val >> 1) & c1;
+    val = (val & c2) + ((val >> 2) & c2);
+    val = (val + (val >> 4)) & c4;
+    return (val * h01) >> 56;
+}
+
+uint64_t emulated_lzcnt(uint64_t val) {
+    int64_t signed_val = (int64_t) val;
+    uint64_t zero_cnt = 0;
+    const uint64_t bits = sizeof(signed_val) * 8;
+    for (uint64_t i = bits; i--; ) {
+        if (signed_val < 0) break;
+        zero_cnt++;
+        signed_val <<= 1;
+    }
+    return zero_cnt;
+}
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+static struct abm_ctx *abm_ctx_new(const struct bench_env *env) {
+    struct abm_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    if(ctx == NULL) {
+        return NULL;
+    }
+    ctx->fir_corpus = corpus_u64(env->corpus, ABM_CORPUS_CNT);
+    ctx->sec_corpus = corpus_u64(env->corpus, ABM_CORPUS_CNT);
+    ctx->cursor = 0;
+    if(ctx->fir_corpus == NULL || ctx->sec_corpus == NULL) {
+        return NULL;
+    }
+    return ctx;
+}
+
+//instructions used: POPCNT; LZCNT
+void *abm_setup(const struct bench_env *env, uint64_t *ops) {
+    *ops = ABM_STRING_CNT * ABM_OPS_PER_ROUND;
+    return abm_ctx_new(env);
+}
+
+//instructions used: POPCNT
+void *popcnt_setup(const struct bench_env *env, uint64_t *ops) {
+    *ops = ABM_STRING_CNT * POPCNT_OPS_PER_ROUND;
+    return abm_ctx_new(env);
+}
+
+//moves the operand window of the next sample through the corpus (not timed)
+void abm_prepare(void *arg) {
+    struct abm_ctx *ctx = arg;
+
+    ctx->fir_str_num = ctx->fir_corpus + ctx->cursor;
+    ctx->sec_str_num = ctx->sec_corpus + ctx->cursor;
+    ctx->cursor = (ctx->cursor + ABM_STRING_CNT) % ABM_CORPUS_CNT;
+}
+
+void popcnt_run_emulated(void *arg) {
+    struct abm_ctx *ctx = arg;
+
+    for(uint8_t h=0; h<ABM_STRING_CNT; h++) {
+        //Hamming Weight calculation
+        ctx->fir_str_hw[h] = emulated_popcnt(ctx->fir_str_num[h]); //Hamming Weight of first string
+        ctx->sec_str_hw[h] = emulated_popcnt(ctx->sec_str_num[h]); //Hamming Wight of second string
+
+        //Hamming Distance of first string and second string
+        //Hamming Distance calculation HammingDistance(bitstring, bitstring2) == HammingWeight(bitstring ^ bitstring2)
+        ctx->temp[h] = ctx->fir_str_num[h] ^ ctx->sec_str_num[h];
+        ctx->hamming_distance[h] = emulated_popcnt(ctx->temp[h]);
+    }
+}
+
+void abm_run_emulated(void *arg) {
+    struct abm_ctx *ctx = arg;
+
+    popcnt_run_emulated(ctx);
+    for(uint8_t h=0; h<ABM_STRING_CNT; h++) {
+        //calculation of leading zeros with LZCNT
+        ctx->fir_str_lz[h] = emulated_lzcnt(ctx->fir_str_num[h]); //leading zeros count of first string bitstring
+        ctx->sec_str_lz[h] = emulated_lzcnt(ctx->sec_str_num[h]); //leading zeros count of second string bitstring
+        ctx->hamming_distance_lz[h] = emulated_lzcnt(ctx->hamming_distance[h]); //leading zeros count of hamming distance
+    }
+}
+
+//***********************************************
+//*****************BULK_KERNELS******************
+//***********************************************
+
+uint64_t popcnt_throughput_emulated(const uint64_t *data, size_t cnt) {
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t i = 0;
+
+    for(; i + 4 <= cnt; i += 4) {
+        acc0 += emulated_popcnt(data[i]);
+        acc1 += emulated_popcnt(data[i + 1]);
+        acc2 += emulated_popcnt(data[i + 2]);
+        acc3 += emulated_popcnt(data[i + 3]);
+    }
+    for(; i < cnt; i++) {
+        acc0 += emulated_popcnt(data[i]);
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+uint64_t lzcnt_throughput_emulated(const uint64_t *data, size_t cnt) {
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t i = 0;
+
+    for(; i + 4 <= cnt; i += 4) {
+        acc0 += emulated_lzcnt(data[i]);
+        acc1 += emulated_lzcnt(data[i + 1]);
+        acc2 += emulated_lzcnt(data[i + 2]);
+        acc3 += emulated_lzcnt(data[i + 3]);
+    }
+    for(; i < cnt; i++) {
+        acc0 += emulated_lzcnt(data[i]);
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+//the xor with fresh data keeps the operands realistic, it adds one cycle to every link of the chain
+uint64_t popcnt_latency_emulated(const uint64_t *data, size_t cnt) {
+    uint64_t x = 0;
+
+    for(size_t i=0; i<cnt; i++) {
+        x = emulated_popcnt(x ^ data[i]);
+    }
+    return x;
+}
+
+uint64_t lzcnt_latency_emulated(const uint64_t *data, size_t cnt) {
+    uint64_t x = 0;
+
+    for(size_t i=0; i<cnt; i++) {
+        x = emulated_lzcnt(x ^ data[i]);
+    }
+    return x;
+}
+
+//***********************************************
+//********************SUITES*********************
+//***********************************************
+
+//POPCNT/LZCNT and their emulations over buffers from L1 to DRAM size
+int abm_throughput_suite(const struct bench_env *env) {
+    const struct bulk_kernel kernels[] = {
+        {"popcnt", popcnt_throughput, dispatch_supported(env->cpu_info, REQUIRES(ISA(POPCNT)))},
+        {"popcnt (emulated)", popcnt_throughput_emulated, true},
+        {"lzcnt", lzcnt_throughput, dispatch_supported(env->cpu_info, REQUIRES(ISA(ABM)))},
+        {"lzcnt (emulated)", lzcnt_throughput_emulated, true},
+    };
+
+    const uint64_t *data = corpus_u64(env->corpus, THROUGHPUT_MAX_BYTES / sizeof(uint64_t));
+    if(data == NULL) {
+        return -1;
+    }
+    return throughput_sweep(kernels, sizeof(kernels) / sizeof(kernels[0]), data, THROUGHPUT_MAX_BYTES, env->config);
+}
+
+//dependency chains of POPCNT/LZCNT and their emulations
+int abm_latency_suite(const struct bench_env *env) {
+    const struct bulk_kernel kernels[] = {
+        {"popcnt", popcnt_latency, dispatch_supported(env->cpu_info, REQUIRES(ISA(POPCNT)))},
+        {"popcnt (emulated)", popcnt_latency_emulated, true},
+        {"lzcnt", lzcnt_latency, dispatch_supported(env->cpu_info, REQUIRES(ISA(ABM)))},
+        {"lzcnt (emulated)", lzcnt_latency_emulated, true},
+    };
+
+    const uint64_t *data = corpus_u64(env->corpus, LATENCY_BYTES / sizeof(uint64_t));
+    if(data == NULL) {
+        return -1;
+    }
+    return latency_report(kernels, sizeof(kernels) / sizeof(kernels[0]), data, env->config);
+}
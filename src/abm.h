@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef ABM_INSTRUCTIONS
+#define ABM_INSTRUCTIONS
+#include <stdint.h>
+#include <stddef.h>
+
+uint64_t emulated_popcnt(uint64_t val);
+uint64_t emulated_lzcnt(uint64_t val);
+
+#define ABM_STRING_CNT 8     //operand pairs per timed region
+#define ABM_CORPUS_CNT 4096  //operand pairs the per-op benches stream over
+#define ABM_OPS_PER_ROUND 6  //3x POPCNT + 3x LZCNT per operand pair
+#define POPCNT_OPS_PER_ROUND 3
+
+struct abm_ctx {
+    const uint64_t *fir_corpus;  //ABM_CORPUS_CNT first operands
+    const uint64_t *sec_corpus;  //ABM_CORPUS_CNT second operands
+    size_t cursor;
+    const uint64_t *fir_str_num; //ABM_STRING_CNT operands of the current sample
+    const uint64_t *sec_str_num;
+    uint64_t fir_str_hw[ABM_STRING_CNT];
+    uint64_t sec_str_hw[ABM_STRING_CNT];
+    uint64_t fir_str_lz[ABM_STRING_CNT];
+    uint64_t sec_str_lz[ABM_STRING_CNT];
+    uint64_t hamming_distance[ABM_STRING_CNT];
+    uint64_t hamming_distance_lz[ABM_STRING_CNT];
+    uint64_t temp[ABM_STRING_CNT];
+};
+
+//per-op benches for the registry, the ctx lives in the corpus arena and needs no teardown
+//the non-emulated kernels live in popcnt_hw.c (built for POPCNT) and abm_hw.c (built for LZCNT)
+//and may only run after dispatch
+struct bench_env;
+void *abm_setup(const struct bench_env *env, uint64_t *ops);
+void *popcnt_setup(const struct bench_env *env, uint64_t *ops);
+void abm_prepare(void *ctx);
+void abm_run(void *ctx);
+void abm_run_emulated(void *ctx);
+void popcnt_run(void *ctx);
+void popcnt_run_emulated(void *ctx);
+
+//bulk kernels return a checksum of their results, so the work can not be optimized away
+//throughput: every element is independent, spread over four accumulators
+uint64_t popcnt_throughput(const uint64_t *data, size_t cnt);
+uint64_t popcnt_throughput_emulated(const uint64_t *data, size_t cnt);
+uint64_t lzcnt_throughput(const uint64_t *data, size_t cnt);
+uint64_t lzcnt_throughput_emulated(const uint64_t *data, size_t cnt);
+
+//latency: every result feeds the next operation (x = op(x ^ data[i]))
+uint64_t popcnt_latency(const uint64_t *data, size_t cnt);
+uint64_t popcnt_latency_emulated(const uint64_t *data, size_t cnt);
+uint64_t lzcnt_latency(const uint64_t *data, size_t cnt);
+uint64_t lzcnt_latency_emulated(const uint64_t *data, size_t cnt);
+
+int abm_throughput_suite(const struct bench_env *env);
+int abm_latency_suite(const struct bench_env *env);
+
+#endif
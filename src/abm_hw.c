@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//LZCNT variants of the ABM kernels, this translation unit is compiled for LZCNT
+//nothing in here may be called unless dispatch_supported() confirmed ABM; abm_run also
+//needs POPCNT for popcnt_run (popcnt_hw.c)
+#pragma GCC target("lzcnt")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "abm.h"
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+//popcnt_run plus leading zeros of both operands and of their Hamming distance with LZCNT
+void abm_run(void *arg) {
+    struct abm_ctx *ctx = arg;
+
+    popcnt_run(ctx);
+    for(uint8_t h=0; h<ABM_STRING_CNT; h++) {
+        //leading zeros calculation with LZCNT
+        __asm__ volatile ("lzcntq %3, %0 \n\t"
+                          "lzcntq %4, %1 \n\t"
+                          "lzcntq %5, %2 \n\t"
+            :"=&r"(ctx->fir_str_lz[h]), "=&r"(ctx->sec_str_lz[h]), "=r"(ctx->hamming_distance_lz[h])
+            :"r"(ctx->fir_str_num[h]), "r"(ctx->sec_str_num[h]), "r" (ctx->hamming_distance[h])
+            :
+        );
+    }
+}
+
+//***********************************************
+//*****************BULK_KERNELS******************
+//***********************************************
+
+uint64_t lzcnt_throughput(const uint64_t *data, size_t cnt) {
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t i = 0;
+
+    for(; i + 4 <= cnt; i += 4) {
+        acc0 += _lzcnt_u64(data[i]);
+        acc1 += _lzcnt_u64(data[i + 1]);
+        acc2 += _lzcnt_u64(data[i + 2]);
+        acc3 += _lzcnt_u64(data[i + 3]);
+    }
+    for(; i < cnt; i++) {
+        acc0 += _lzcnt_u64(data[i]);
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+//the xor with fresh data keeps the operands realistic, it adds one cycle to every link of the chain
+uint64_t lzcnt_latency(const uint64_t *data, size_t cnt) {
+    uint64_t x = 0;
+
+    for(size_t i=0; i<cnt; i++) {
+        x = _lzcnt_u64(x ^ data[i]);
+    }
+    return x;
+}
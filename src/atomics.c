@@ -0,0 +1,260 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//atomic read-modify-write instructions and locks under contention, every thread count runs with
+//all threads on one cell, on neighbouring cells of the same line (false sharing) and on padded cells
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "cpuinfo.h"
+#include "corpus.h"
+#include "registry.h"
+#include "parallel.h"
+#include "atomics.h"
+
+#define LAYOUT_CNT (sizeof(layouts) / sizeof(layouts[0]))
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+static void xadd_run(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    volatile uint64_t *value = (volatile uint64_t *) &ctx->cell->value;
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        uint64_t one = 1;
+        //the compiler turns a fetch_add with unused result into lock add, so the instruction is spelled out
+        __asm__ volatile ("lock xaddq %0, %1"
+            :"+r"(one), "+m"(*value)
+            :
+            :"memory"
+        );
+    }
+}
+
+//increment by compare and swap, a failed lock cmpxchg returns the current value for the next attempt
+static void cmpxchg_run(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    uint64_t old = atomic_load_explicit(&ctx->cell->value, memory_order_relaxed);
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        while(!atomic_compare_exchange_weak_explicit(&ctx->cell->value, &old, old + 1,
+                                                     memory_order_acq_rel, memory_order_relaxed)) {
+        }
+        old++;
+    }
+}
+
+//128 bit compare and swap of value and lock/owner, on failure *lo and *hi hold the current contents
+static inline bool cas16(struct atomics_cell *cell, uint64_t *lo, uint64_t *hi, uint64_t new_lo, uint64_t new_hi) {
+    bool ok;
+    __asm__ volatile ("lock cmpxchg16b %1"
+        :"=@ccz"(ok), "+m"(*(volatile unsigned __int128 *) cell), "+a"(*lo), "+d"(*hi)
+        :"b"(new_lo), "c"(new_hi)
+        :"memory"
+    );
+    return ok;
+}
+
+//increments both halves of the cell like a lock-free queue bumps its pointer and ABA tag
+//instructions used: CMPXCHG16B
+void cx16_run(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    struct atomics_cell *cell = ctx->cell;
+    uint64_t lo = atomic_load_explicit(&cell->value, memory_order_relaxed);
+    uint64_t hi = atomic_load_explicit(&cell->lock, memory_order_relaxed) |
+                  (uint64_t) atomic_load_explicit(&cell->owner, memory_order_relaxed) << 32;
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        while(!cas16(cell, &lo, &hi, lo + 1, hi + 1)) {
+        }
+        lo++;
+        hi++;
+    }
+}
+
+void cx16_run_emulated(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    struct atomics_cell *cell = ctx->cell;
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        ttas_lock(cell);
+        atomic_store_explicit(&cell->value, atomic_load_explicit(&cell->value, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        atomic_store_explicit(&cell->owner, atomic_load_explicit(&cell->owner, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        ttas_unlock(cell);
+    }
+}
+
+//test-and-test-and-set: waiters spin on a plain load and only try the xchg once the lock looks free
+void ttas_run(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    struct atomics_cell *cell = ctx->cell;
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        ttas_lock(cell);
+        atomic_store_explicit(&cell->value, atomic_load_explicit(&cell->value, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        ttas_unlock(cell);
+    }
+}
+
+//FIFO lock: lock xadd draws a ticket, the holder passes the lock on by bumping owner
+static void ticket_run(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    struct atomics_cell *cell = ctx->cell;
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        uint32_t ticket = atomic_fetch_add_explicit(&cell->lock, 1, memory_order_relaxed);
+        while(atomic_load_explicit(&cell->owner, memory_order_acquire) != ticket) {
+            __builtin_ia32_pause();
+        }
+        atomic_store_explicit(&cell->value, atomic_load_explicit(&cell->value, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        atomic_store_explicit(&cell->owner, ticket + 1, memory_order_release);
+    }
+}
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+//uncontended cell of the cx16 and rtm entries, with --threads every worker gets a cell of its own
+void *atomics_setup(const struct bench_env *env, uint64_t *ops) {
+    struct atomics_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    struct atomics_cell *cell = arena_alloc(&env->corpus->arena, sizeof(*cell));
+    if(ctx == NULL || cell == NULL) {
+        return NULL;
+    }
+    memset(cell, 0, sizeof(*cell));
+    ctx->cell = cell;
+    ctx->aborts = 0;
+    *ops = ATOMICS_BATCH;
+    return ctx;
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+struct atomics_op {
+    const char *name;
+    void (*run)(void *ctx);
+    bool supported;
+};
+
+//bytes between the cells of two threads, 0 puts all of them on the same cell
+struct atomics_layout {
+    const char *name;
+    size_t stride;
+};
+
+static const struct atomics_layout layouts[] = {
+    {"shared", 0},
+    {"false sharing", ATOMICS_CELL},
+    {"padded", ATOMICS_PAD},
+};
+
+//one thread count of one operation in every layout: Mops/s of all threads together and fairness,
+//the slowest thread's share relative to the fastest one (1.00: every thread got the same)
+static int atomics_row(const struct atomics_op *op, struct worker *workers, struct atomics_ctx *ctxs,
+                       uint8_t *cells, uint32_t threads, const struct cpu_topology *topology, const uint32_t *order,
+                       bool transactional) {
+    struct parallel_result result;
+
+    printf("%7u", threads);
+    for(size_t l=0; l<LAYOUT_CNT; l++) {
+        memset(cells, 0, (size_t) threads * ATOMICS_PAD);
+        for(uint32_t i=0; i<threads; i++) {
+            ctxs[i].cell = (struct atomics_cell *) (cells + i * layouts[l].stride);
+            ctxs[i].aborts = 0;
+            workers[i].run = op->run;
+            workers[i].prepare = NULL;
+            workers[i].ctx = &ctxs[i];
+            workers[i].ops = ATOMICS_BATCH;
+        }
+        if(parallel_measure(workers, threads, topology, order, &result) != 0) {
+            printf("\r\n");
+            return -1;
+        }
+        printf(" %14.1f %6.2f", result.total, result.max > 0.0 ? result.min / result.max : 0.0);
+        if(transactional) {
+            uint64_t aborts = 0, done = 0;
+            for(uint32_t i=0; i<threads; i++) {
+                aborts += ctxs[i].aborts;
+                done += workers[i].done;
+            }
+            printf(" %6.1f%%", done ? 100.0 * aborts / done : 0.0);
+        }
+    }
+    printf("\r\n");
+    fflush(stdout);
+    return 0;
+}
+
+//lock xadd, lock cmpxchg, cmpxchg16b, TTAS and ticket lock, RTM elided TTAS lock over 1, 2, 4, ... threads
+int atomics_suite(const struct bench_env *env) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    const uint32_t cpu_cnt = topology->cpu_cnt;
+    const bool rtm = env->cpu_info->RTM && rtm_commits();
+    const struct atomics_op ops[] = {
+        {"lock xadd", xadd_run, true},
+        {"lock cmpxchg", cmpxchg_run, true},
+        {"lock cmpxchg16b", cx16_run, env->cpu_info->CX16},
+        {"TTAS spinlock", ttas_run, true},
+        {"ticket lock", ticket_run, true},
+        {"RTM elided TTAS spinlock", rtm_elided_run, rtm},
+    };
+
+    struct worker *workers = calloc(cpu_cnt, sizeof(*workers));
+    struct atomics_ctx *ctxs = calloc(cpu_cnt, sizeof(*ctxs));
+    uint32_t *order = calloc(cpu_cnt, sizeof(*order));
+    uint8_t *cells = aligned_alloc(ATOMICS_PAD, (size_t) cpu_cnt * ATOMICS_PAD);
+    int status = 0;
+    if(workers == NULL || ctxs == NULL || order == NULL || cells == NULL) {
+        status = -1;
+        goto out;
+    }
+    placement_order(topology, PLACEMENT_SPREAD, order);
+
+    printf("Mops/s of all threads together, fair: slowest thread / fastest thread, one thread per core first\r\n");
+    if(!env->cpu_info->RTM) {
+        printf("RTM not supported, no transactional elision\r\n");
+    } else if(!rtm) {
+        printf("RTM reported but every transaction aborts (disabled by microcode), no transactional elision\r\n");
+    }
+    for(size_t o=0; o<sizeof(ops) / sizeof(ops[0]) && status==0; o++) {
+        const bool transactional = ops[o].run == rtm_elided_run;
+        if(!ops[o].supported) {
+            continue;
+        }
+        printf("%s\r\n%7s", ops[o].name, "threads");
+        for(size_t l=0; l<LAYOUT_CNT; l++) {
+            printf(" %14s %6s%s", layouts[l].name, "fair", transactional ? "  abort" : "");
+        }
+        printf("\r\n");
+        for(uint32_t threads=1; threads!=0 && status==0; threads=parallel_next_threads(threads, cpu_cnt)) {
+            status = atomics_row(&ops[o], workers, ctxs, cells, threads, topology, order, transactional);
+        }
+    }
+
+out:
+    free(workers);
+    free(ctxs);
+    free(order);
+    free(cells);
+    return status;
+}
@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef ATOMICS
+#define ATOMICS
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define ATOMICS_BATCH 64            //operations per call of a kernel
+#define ATOMICS_PAD 128             //stride of the padded layout, two lines keep the adjacent line prefetcher out
+#define ATOMICS_CELL 16             //stride of the false sharing layout, four threads per cache line
+
+//what one thread operates on; value is the counter (or the data protected by the lock), lock/owner
+//are the TTAS flag or the ticket counters; cmpxchg16b updates value and lock/owner as one 128 bit word
+struct atomics_cell {
+    _Atomic uint64_t value;
+    _Atomic uint32_t lock;   //TTAS: 1 while held; ticket lock: next ticket
+    _Atomic uint32_t owner;  //ticket lock: ticket being served
+} __attribute__((aligned(16)));
+
+struct atomics_ctx {
+    struct atomics_cell *cell;
+    uint64_t aborts;         //RTM transactions that fell back to the lock
+};
+
+//transactional elision of the TTAS lock, this translation unit is compiled for RTM
+//nothing in atomics_rtm.c may be called unless cpu_info.RTM is set
+bool rtm_commits(void);
+void rtm_elided_run(void *ctx);
+
+//TTAS lock shared with atomics_rtm.c, it is the fallback path of the elided lock
+static inline void ttas_lock(struct atomics_cell *cell) {
+    while(atomic_exchange_explicit(&cell->lock, 1, memory_order_acquire)) {
+        while(atomic_load_explicit(&cell->lock, memory_order_relaxed)) {
+            __builtin_ia32_pause();
+        }
+    }
+}
+
+static inline void ttas_unlock(struct atomics_cell *cell) {
+    atomic_store_explicit(&cell->lock, 0, memory_order_release);
+}
+
+//cmpxchg16b registry entry, the emulation takes the TTAS lock around a 16 byte update like libatomic does;
+//the rtm entry elides the TTAS lock, which is its emulation as well
+struct bench_env;
+void *atomics_setup(const struct bench_env *env, uint64_t *ops);
+void cx16_run(void *ctx);
+void cx16_run_emulated(void *ctx);
+void ttas_run(void *ctx);
+
+int atomics_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,56 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//transactional lock elision, this translation unit is compiled for RTM
+//nothing in here may be called unless cpu_info.RTM is set
+#pragma GCC target("rtm")
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <immintrin.h>
+#include "atomics.h"
+
+#define RTM_PROBES 64
+
+//CPUID may still report RTM while microcode aborts every transaction (TSX_FORCE_ABORT, TAA mitigations)
+bool rtm_commits(void) {
+    for(uint32_t i=0; i<RTM_PROBES; i++) {
+        if(_xbegin() == _XBEGIN_STARTED) {
+            _xend();
+            return true;
+        }
+    }
+    return false;
+}
+
+//one attempt per operation: the transaction reads the lock word, so a thread that takes the lock
+//for real aborts all running transactions; an aborted attempt takes the TTAS lock instead of retrying
+void rtm_elided_run(void *arg) {
+    struct atomics_ctx *ctx = arg;
+    struct atomics_cell *cell = ctx->cell;
+
+    for(uint32_t i=0; i<ATOMICS_BATCH; i++) {
+        if(_xbegin() == _XBEGIN_STARTED) {
+            if(atomic_load_explicit(&cell->lock, memory_order_relaxed)) {
+                _xabort(0xff);
+            }
+            atomic_store_explicit(&cell->value, atomic_load_explicit(&cell->value, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
+            _xend();
+        } else {
+            ctx->aborts++;
+            ttas_lock(cell);
+            atomic_store_explicit(&cell->value, atomic_load_explicit(&cell->value, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
+            ttas_unlock(cell);
+        }
+    }
+}
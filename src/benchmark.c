@@ -13,11 +13,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <immintrin.h>
-#include <sys/time.h>
-#include <errno.h>
+#include <string.h>
 #include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "parallel.h"
+#include "counters.h"
+#include "daemon.h"
+#include "report.h"
 
-#define MEASUREMENT_ITERATIONS 10000
+#define CORPUS_SIZE ((size_t) 4 << 30) //reserved address space for benchmark input
 #define STARTUP_PROMPT_ROWS 5
 #define STARTUP_PROMPT_COLUMNS 81
 
@@ -31,159 +38,64 @@ char startup_prompt[STARTUP_PROMPT_ROWS][STARTUP_PROMPT_COLUMNS] = {
 "/ /___/ ____/ /_/ /_____/ /_/ /  __/ / / / /__/ / / / / / / / / /_/ / /  / ,<",
 "\\____/_/    \\____/     /_____/\\___/_/ /_/\\___/_/ /_/_/ /_/ /_/\\__,_/_/  /_/|_|"};
 
-//***********************************************
-//************HELPER_FUNCTIONS**************
-//***********************************************
-
-static char *random_string(char *str, size_t size) {
-    const char charset[] = "0123456789";
-    if(size) {
-        --size;
-        for (size_t i=0; i<size; i++) {
-            int symbol = rand() % (int) (sizeof charset - 1);
-            str[i] = charset[symbol];
+static void print_topology(const struct cpu_info *cpu_info) {
+    printf("CPU: %s %s (family 0x%x, model 0x%x, stepping %u, microcode 0x%llx)\r\n", cpu_info->VENDOR,
+           cpu_info->BRAND, cpu_info->FAMILY, cpu_info->MODEL, cpu_info->STEPPING,
+           (unsigned long long) cpu_info->MICROCODE);
+    printf("Topology: %u package(s), %u cores, %u logical CPUs, %u NUMA node(s)\r\n",
+           cpu_info->PACKAGES, cpu_info->CORES_PHYSICAL, cpu_info->CORES_LOGICAL, cpu_info->topology.node_cnt);
+    //hybrid CPUs only, the benchmarks run once per core type
+    const struct cpu_topology *topology = &cpu_info->topology;
+    for(uint32_t i=0; i<topology->core_type_cnt; i++) {
+        const uint8_t type = topology->core_types[i];
+        printf("%s: %u logical CPUs", topology_core_type_name(type), topology_core_type_cpus(topology, type));
+        if(topology->core_type_cnt > 1) {
+            printf(", benchmarks pinned to cpu %d", topology_core_type_cpu(topology, type));
         }
-        str[size] = '\0';
+        printf("\r\n");
+    }
+    for(uint32_t i=0; i<cpu_info->topology.cache_cnt; i++) {
+        const struct cache_info *cache = &cpu_info->topology.caches[i];
+        printf("L%u%s: %u KiB, %u-way, %u B lines, shared by %u logical CPUs\r\n", cache->level,
+               cache->type == 1 ? "d" : (cache->type == 2 ? "i" : ""), cache->size >> 10, cache->ways,
+               cache->line, cache->shared_by);
     }
-    return str;
-}
-
-//***********************************************
-//************EMULATED_INSTRUCTIONS**************
-//***********************************************
-
-uint64_t emulated_popcnt(uint64_t val) {
-    const uint64_t c1  = 0x5555555555555555;
-    const uint64_t c2  = 0x3333333333333333;
-    const uint64_t c4  = 0x0f0f0f0f0f0f0f0f;
-    const uint64_t h01 = 0x0101010101010101;
-
-    val -= (val >> 1) & c1;
-    val = (val & c2) + ((val >> 2) & c2);
-    val = (val + (val >> 4)) & c4;
-    return (val * h01) >> 56;
 }
 
-uint64_t emulated_lzcnt(uint64_t val) {
-    int64_t signed_val = (int64_t) val;
-    uint64_t zero_cnt = 0;
-    const uint64_t bits = sizeof(signed_val) * 8;
-    for (uint64_t i = bits; --i; ) {
-        if (signed_val < 0) break;
-        zero_cnt++;
-        signed_val <<= 1;
-    }
-    return zero_cnt;
+//parses the value of option argv[*i] into *value, returns false if it is missing or malformed
+static bool parse_number(int argc, char *argv[], int *i, double *value) {
+    char *end;
+    if(*i + 1 >= argc) {
+        return false;
+    }
+    *value = strtod(argv[++*i], &end);
+    return *end == '\0';
 }
 
-//***********************************************
-//**************EXTENSIONS_BENCHES*+*************
-//***********************************************
-
-//returns execution time of ABM instructions (if not supported its emulated by an algorithm)
-//instructions used: POPCNT; LZCNT
-double abm_bench(bool abm_supported, bool popcnt_supported) {
-    double time_sum = 0.0;
-    struct timeval start_time, end_time;
-    const size_t string_cnt = 8;
-    const size_t string_len = 16;
-    uint64_t fir_str_num[string_cnt];
-    uint64_t sec_str_num[string_cnt];
-    uint64_t fir_str_hw[string_cnt];
-    uint64_t sec_str_hw[string_cnt];
-    uint64_t fir_str_lz[string_cnt];
-    uint64_t sec_str_lz[string_cnt];
-    uint64_t hamming_distance[string_cnt];
-    uint64_t hamming_distance_lz[string_cnt];
-    uint64_t temp[string_cnt];
-
-    for(uint32_t i=0; i<MEASUREMENT_ITERATIONS; i++) {
-        const char fir_str[string_cnt][string_len];
-        const char sec_str[string_cnt][string_len];
-        for(uint8_t k=0; k<string_cnt; k++) {
-            random_string((char *)&fir_str[k], string_len);
-            random_string((char *)&sec_str[k], string_len);
-
-            fir_str_num[k] = strtol(fir_str[k], NULL, 10);
-            if(fir_str_num[k] == 0) {
-                if(errno == EINVAL) {
-                    printf("Conversion error occurred: %d\n", errno);
-                }
-                if (errno == ERANGE) {
-                    printf("The value provided was out of range\n");
-                }
-            }
-            sec_str_num[k] = strtol(sec_str[k], NULL, 10);
-            if(sec_str_num[k] == 0) {
-                if(errno == EINVAL) {
-                    printf("Conversion error occurred: %d\n", errno);
-                }
-                if (errno == ERANGE) {
-                    printf("The value provided was out of range\n");
-                }
-            }
-        }
-
-        for(uint8_t h=0; h<string_cnt; h++) {
-            gettimeofday(&start_time, NULL);
-
-            if(abm_supported || popcnt_supported) {
-                //Hamming Weight calculation
-                __asm__ volatile ("popcntq %2, %0 \n\t"  //Hamming Weight of first string
-                                  "popcntq %3, %1 \n\t" //Hamming Weight of second string
-                    :"=r"(fir_str_hw[h]), "=r"(sec_str_hw[h])
-                    :"r"(fir_str_num[h]), "r"(sec_str_num[h])
-                    :
-                );
-
-                __asm__ volatile ("popcntq %1, %0"  //Hamming Wight of second string
-                    :"=r"(sec_str_hw[h])
-                    :"r"(sec_str_num[h])
-                    :
-                );
-
-                //Hamming Distance of first string and second string
-                //Hamming Distance calculation HammingDistance(bitstring, bitstring2) == HammingWeight(bitstring ^ bitstring2)
-                temp[h] = fir_str_num[h] ^ sec_str_num[h];
-                __asm__ volatile ("popcntq %1, %0"
-                    :"=r"(hamming_distance[h])
-                    :"r"(temp[h])
-                    :
-                );
-            } else {
-                //Hamming Weight calculation
-                fir_str_hw[h] = emulated_popcnt(fir_str_num[h]); //Hamming Weight of first string
-                sec_str_hw[h] = emulated_popcnt(sec_str_num[h]); //Hamming Wight of second string
-
-                //Hamming Distance of first string and second string
-                //Hamming Distance calculation HammingDistance(bitstring, bitstring2) == HammingWeight(bitstring ^ bitstring2)
-                temp[h] = fir_str_num[h] ^ sec_str_num[h];
-                hamming_distance[h] = emulated_popcnt(temp[h]);
-            }
-
-            if(abm_supported) {
-                //leading zeros calculation with LZCNT
-                __asm__ volatile ("lzcntq %0, %3 \n\t"
-                                  "lzcntq %1, %4 \n\t"
-                                  "lzcntq %2, %5 \n\t"
-                    :"=r"(fir_str_lz[h]), "=r"(sec_str_lz[h]), "=r"(hamming_distance_lz[h])
-                    :"r"(fir_str_num[h]), "r"(sec_str_num[h]), "r" (hamming_distance[h])
-                    :
-                );
-
-            } else {
-                //calculation of leading zeros with LZCNT
-                fir_str_lz[h] = emulated_lzcnt(fir_str_num[h]); //leading zeros count of first string bitstring
-                sec_str_lz[h] = emulated_lzcnt(sec_str_num[h]); //leading zeros count of second string bitstring
-                hamming_distance_lz[h] = emulated_lzcnt(hamming_distance[h]); //leading zeros count of hamming distance
-            }
-
-            gettimeofday(&end_time, NULL);
-            time_sum += (double) (end_time.tv_usec - start_time.tv_usec);
-        }
+//parses the value of option argv[*i] as unsigned 64 bit integer (decimal or 0x hex)
+static bool parse_u64(int argc, char *argv[], int *i, uint64_t *value) {
+    char *end;
+    if(*i + 1 >= argc) {
+        return false;
     }
+    *value = strtoull(argv[++*i], &end, 0);
+    return *end == '\0';
+}
 
-    return (double) (time_sum/10);
+static void print_usage(const char *prog) {
+    printf("usage: %s [--seed N] [--warmup N] [--min-samples N] [--max-samples N] [--rel-error X] [--max-seconds S]\r\n"
+           "          [--suite PATTERN]... [--threads] [--counters] [--json FILE] [--csv FILE] [--compare BASELINE]\r\n"
+           "          [--c2c-csv FILE] [--list] [PATTERN...]\r\n"
+           "       %s --daemon [--interval S] [--shm NAME] [--rounds N]\r\n"
+           "PATTERN selects benchmarks by name or shell glob (e.g. 'popcnt' or 'avx*'), default is all\r\n"
+           "--suite selects sweep suites the same way, they only run when asked for\r\n"
+           "--counters adds hardware performance counters per operation (perf_event_open)\r\n"
+           "--json/--csv write the benchmark results with the CPU identity to FILE\r\n"
+           "--compare checks the results against a file written by --json, exits with 2 on a regression\r\n"
+           "--c2c-csv writes the matrix of the c2c suite (core-to-core latency) to FILE\r\n"
+           "--daemon probes clock, memory latency and popcount every --interval seconds (default %.0f) until\r\n"
+           "         SIGINT/SIGTERM or --rounds rounds, results go to the shared memory object --shm (default %s)\r\n",
+           prog, prog, DAEMON_INTERVAL, DAEMON_SHM_NAME);
 }
 
 int main(int argc, char *argv[]) {
@@ -195,18 +107,169 @@ int main(int argc, char *argv[]) {
       printf("\n");
     }
 
-    struct cpu_info *cpu_info = malloc(sizeof(*cpu_info)); //included from cpuinfo.h
-    struct execution_time execution_time; //included from cpuinfo.h
+    struct measure_config config;
+    uint64_t seed = CORPUS_DEFAULT_SEED;
+    bool list = false;
+    bool threads = false;
+    bool count = false;
+    const char *json_path = NULL;
+    const char *csv_path = NULL;
+    const char *c2c_csv_path = NULL;
+    const char *baseline_path = NULL;
+    bool daemon = false;
+    struct daemon_config daemon_config = {DAEMON_SHM_NAME, DAEMON_INTERVAL, 0};
+    char **patterns = calloc(argc, sizeof(*patterns));
+    char **suites = calloc(argc, sizeof(*suites));
+    size_t pattern_cnt = 0;
+    size_t suite_cnt = 0;
+    measure_default_config(&config);
+    for(int i=1; i<argc; i++) {
+        double value;
+        uint64_t number;
+        if(strcmp(argv[i], "--seed") == 0 && parse_u64(argc, argv, &i, &number)) {
+            seed = number;
+        } else if(strcmp(argv[i], "--warmup") == 0 && parse_number(argc, argv, &i, &value)) {
+            config.warmup = (uint32_t) value;
+        } else if(strcmp(argv[i], "--min-samples") == 0 && parse_number(argc, argv, &i, &value)) {
+            config.min_samples = (uint32_t) value;
+        } else if(strcmp(argv[i], "--max-samples") == 0 && parse_number(argc, argv, &i, &value)) {
+            config.max_samples = (uint32_t) value;
+        } else if(strcmp(argv[i], "--rel-error") == 0 && parse_number(argc, argv, &i, &value)) {
+            config.target_rel_error = value;
+        } else if(strcmp(argv[i], "--max-seconds") == 0 && parse_number(argc, argv, &i, &value)) {
+            config.max_seconds = value;
+        } else if(strcmp(argv[i], "--suite") == 0 && i + 1 < argc) {
+            suites[suite_cnt++] = argv[++i];
+        } else if(strcmp(argv[i], "--threads") == 0) {
+            threads = true;
+        } else if(strcmp(argv[i], "--counters") == 0) {
+            count = true;
+        } else if(strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if(strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if(strcmp(argv[i], "--c2c-csv") == 0 && i + 1 < argc) {
+            c2c_csv_path = argv[++i];
+        } else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if(strcmp(argv[i], "--daemon") == 0) {
+            daemon = true;
+        } else if(strcmp(argv[i], "--interval") == 0 && parse_number(argc, argv, &i, &value) && value > 0.0) {
+            daemon_config.interval = value;
+        } else if(strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            daemon_config.shm_name = argv[++i];
+        } else if(strcmp(argv[i], "--rounds") == 0 && parse_u64(argc, argv, &i, &number)) {
+            daemon_config.rounds = number;
+        } else if(strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if(argv[i][0] != '-') {
+            patterns[pattern_cnt++] = argv[i];
+        } else {
+            print_usage(argv[0]);
+            free(patterns);
+            free(suites);
+            return 1;
+        }
+    }
+
+    struct cpu_info *cpu_info = calloc(1, sizeof(*cpu_info)); //included from cpuinfo.h
+    struct execution_time execution_time = {0}; //included from cpuinfo.h
+    struct corpus corpus;
+    struct counters counters;
+    struct report report = {0};
+    int failed = 0;
+    int regressions = 0;
 
     set_cpu_info(cpu_info);
+    set_topology(&cpu_info->topology);
+    cpu_info->CORES_LOGICAL  = cpu_info->topology.cpu_cnt;
+    cpu_info->CORES_PHYSICAL = topology_cores(&cpu_info->topology);
+    cpu_info->PACKAGES       = topology_packages(&cpu_info->topology);
+    if(list) {
+        registry_list(cpu_info);
+        free(patterns);
+        free(suites);
+        free(cpu_info);
+        return 0;
+    }
+    timing_init(cpu_info);
+    printf("Clock source: %s, TSC %.3f GHz, timer overhead %lu ticks\r\n",
+           timer_info.tsc ? (timer_info.rdtscp ? "rdtsc/rdtscp" : "rdtsc") : "clock_gettime (TSC not invariant)",
+           timer_info.cycles_per_ns, (unsigned long) timer_info.overhead);
+    print_topology(cpu_info);
+    printf("Input seed: 0x%016llx\r\n", (unsigned long long) seed);
+    if(corpus_init(&corpus, seed, CORPUS_SIZE) != 0) {
+        printf("Could not reserve %zu bytes for the input corpus\r\n", CORPUS_SIZE);
+        free(patterns);
+        free(suites);
+        free(cpu_info);
+        return 1;
+    }
 
-    execution_time.ABM = abm_bench(cpu_info->ABM, cpu_info->POPCNT);
-    execution_time.POPCNT = abm_bench(false, cpu_info->POPCNT);
-    char *em_str[2] = {" (emulated)", ""}; //string for output if bit not set
-    printf("ABM%s execution time: %f \r\n", em_str[cpu_info->ABM],execution_time.ABM);
-    printf("POPCNT%s execution time: %f \r\n", em_str[cpu_info->POPCNT], execution_time.POPCNT);
+    //without counters the benchmarks still run, they just report timing only
+    if(count && counters_open(&counters) == 0) {
+        config.counters = &counters;
+        counters_describe(&counters);
+    } else if(count) {
+        printf("Counters unavailable: %s\r\n", counters.reason);
+    }
+
+    struct bench_env env = {cpu_info, &corpus, &config, c2c_csv_path};
+    //the daemon replaces the benchmark run, its probes are calibrated to stay below DAEMON_BUDGET of one CPU
+    if(daemon) {
+        failed = daemon_run(&env, &daemon_config);
+        if(config.counters) {
+            counters_close(config.counters);
+        }
+        corpus_free(&corpus);
+        free(patterns);
+        free(suites);
+        free(cpu_info);
+        return failed;
+    }
+    const bool structured = json_path || csv_path || baseline_path;
+    if(structured && report_init(&report, cpu_info, &config, seed, bench_registry_cnt * TOPOLOGY_MAX_CORE_TYPES) != 0) {
+        printf("Could not allocate the report, structured output disabled\r\n");
+        failed++;
+    }
+    //benchmarks run by default, but not if only suites were asked for
+    if(pattern_cnt > 0 || suite_cnt == 0) {
+        failed += registry_run(&env, patterns, pattern_cnt, &execution_time, report.entries ? &report : NULL);
+        if(threads) {
+            failed += parallel_run(&env, patterns, pattern_cnt);
+        }
+    }
+    if(suite_cnt > 0) {
+        failed += registry_run_suites(&env, suites, suite_cnt);
+    }
+
+    if(report.entries && json_path && report_write_json(&report, json_path) != 0) {
+        printf("Could not write %s\r\n", json_path);
+        failed++;
+    }
+    if(report.entries && csv_path && report_write_csv(&report, csv_path) != 0) {
+        printf("Could not write %s\r\n", csv_path);
+        failed++;
+    }
+    if(report.entries && baseline_path) {
+        regressions = report_compare(&report, baseline_path);
+        if(regressions < 0) {
+            printf("Could not read the baseline %s\r\n", baseline_path);
+            failed++;
+        }
+    }
 
     //freeing all allocated memory
+    report_free(&report);
+    if(config.counters) {
+        counters_close(config.counters);
+    }
+    corpus_free(&corpus);
+    free(patterns);
+    free(suites);
     free(cpu_info);
-    return 0;
+    if(failed) {
+        return 1;
+    }
+    return regressions > 0 ? 2 : 0;
 }
@@ -0,0 +1,291 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "corpus.h"
+#include "measure.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "freq.h"
+#include "bmi.h"
+
+#define WEIGHT_CNT (sizeof(weights) / sizeof(weights[0]))
+
+//***********************************************
+//************EMULATED_INSTRUCTIONS**************
+//***********************************************
+
+uint64_t emulated_tzcnt(uint64_t val) {
+    uint64_t zero_cnt = 0;
+    const uint64_t bits = sizeof(val) * 8;
+    for (uint64_t i = bits; i--; ) {
+        if (val & 1) break;
+        zero_cnt++;
+        val >>= 1;
+    }
+    return zero_cnt;
+}
+
+uint64_t emulated_blsr(uint64_t val) {
+    return val & (val - 1);
+}
+
+uint64_t emulated_andn(uint64_t fir, uint64_t sec) {
+    return ~fir & sec;
+}
+
+uint64_t emulated_bextr(uint64_t val, uint32_t start, uint32_t len) {
+    if (start >= 64) return 0;
+    val >>= start;
+    if (len >= 64) return val;
+    return val & (((uint64_t) 1 << len) - 1);
+}
+
+//one step per set bit of the mask, so the cost grows with its popcount like microcoded PDEP does
+//the steps are branch free, random operand bits would otherwise mispredict half of the time
+uint64_t emulated_pdep(uint64_t val, uint64_t mask) {
+    uint64_t res = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        res |= mask & -mask & -(uint64_t) ((val & bit) != 0);
+        mask &= mask - 1;
+    }
+    return res;
+}
+
+uint64_t emulated_pext(uint64_t val, uint64_t mask) {
+    uint64_t res = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        res |= bit & -(uint64_t) ((val & mask & -mask) != 0);
+        mask &= mask - 1;
+    }
+    return res;
+}
+
+uint64_t emulated_shlx(uint64_t val, uint64_t cnt) {
+    return val << (cnt & 63);
+}
+
+//schoolbook multiplication of the 32 bit halves, returns the low and stores the high half of the product
+uint64_t emulated_mulx(uint64_t fir, uint64_t sec, uint64_t *hi) {
+    const uint64_t fir_lo = fir & 0xffffffff, fir_hi = fir >> 32;
+    const uint64_t sec_lo = sec & 0xffffffff, sec_hi = sec >> 32;
+    const uint64_t lo_lo = fir_lo * sec_lo;
+    const uint64_t hi_lo = fir_hi * sec_lo;
+    const uint64_t lo_hi = fir_lo * sec_hi;
+    const uint64_t hi_hi = fir_hi * sec_hi;
+    const uint64_t mid = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+
+    *hi = hi_hi + (hi_lo >> 32) + (mid >> 32);
+    return (mid << 32) | (lo_lo & 0xffffffff);
+}
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+//adapters to the OP(val, mask) form of BMI_KERNEL
+static inline uint64_t emu_tzcnt(uint64_t val, uint64_t mask) {
+    (void) mask;
+    return emulated_tzcnt(val);
+}
+
+static inline uint64_t emu_blsr(uint64_t val, uint64_t mask) {
+    (void) mask;
+    return emulated_blsr(val);
+}
+
+static inline uint64_t emu_bextr(uint64_t val, uint64_t mask) {
+    (void) mask;
+    return emulated_bextr(val, BMI_BEXTR_START, BMI_BEXTR_LEN);
+}
+
+static inline uint64_t emu_mulx(uint64_t val, uint64_t mask) {
+    uint64_t hi;
+    uint64_t lo = emulated_mulx(val, mask, &hi);
+    return lo + hi;
+}
+
+BMI_KERNEL(tzcnt, _emulated, emu_tzcnt)
+BMI_KERNEL(blsr, _emulated, emu_blsr)
+BMI_KERNEL(andn, _emulated, emulated_andn)
+BMI_KERNEL(bextr, _emulated, emu_bextr)
+BMI_KERNEL(pdep, _emulated, emulated_pdep)
+BMI_KERNEL(pext, _emulated, emulated_pext)
+BMI_KERNEL(shlx, _emulated, emulated_shlx)
+BMI_KERNEL(mulx, _emulated, emu_mulx)
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+//instructions used: TZCNT; BLSR; ANDN; BEXTR or PDEP; PEXT; SHLX; MULX, the mask has about half of its bits set
+void *bmi_setup(const struct bench_env *env, uint64_t *ops) {
+    struct bmi_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    if(ctx == NULL) {
+        return NULL;
+    }
+    ctx->data = corpus_u64(env->corpus, BMI_SAMPLE_CNT);
+    ctx->mask = rng_next(&env->corpus->rng);
+    ctx->result = 0;
+    if(ctx->data == NULL) {
+        return NULL;
+    }
+    *ops = BMI_SAMPLE_CNT * BMI_OPS_PER_ROUND;
+    return ctx;
+}
+
+void bmi1_run_emulated(void *arg) {
+    struct bmi_ctx *ctx = arg;
+    uint64_t sum = 0;
+
+    tzcnt_throughput_emulated(ctx);
+    sum += ctx->result;
+    blsr_throughput_emulated(ctx);
+    sum += ctx->result;
+    andn_throughput_emulated(ctx);
+    sum += ctx->result;
+    bextr_throughput_emulated(ctx);
+    ctx->result += sum;
+}
+
+void bmi2_run_emulated(void *arg) {
+    struct bmi_ctx *ctx = arg;
+    uint64_t sum = 0;
+
+    pdep_throughput_emulated(ctx);
+    sum += ctx->result;
+    pext_throughput_emulated(ctx);
+    sum += ctx->result;
+    shlx_throughput_emulated(ctx);
+    sum += ctx->result;
+    mulx_throughput_emulated(ctx);
+    ctx->result += sum;
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//hardware and emulated kernels of one instruction
+struct bmi_op {
+    const char *name;
+    size_t requires;                    //ISA() of the extension
+    bench_fn throughput, throughput_emulated;
+    bench_fn latency, latency_emulated;
+};
+
+static const struct bmi_op ops[] = {
+    {"tzcnt", ISA(BMI1), tzcnt_throughput, tzcnt_throughput_emulated, tzcnt_latency, tzcnt_latency_emulated},
+    {"blsr",  ISA(BMI1), blsr_throughput,  blsr_throughput_emulated,  blsr_latency,  blsr_latency_emulated},
+    {"andn",  ISA(BMI1), andn_throughput,  andn_throughput_emulated,  andn_latency,  andn_latency_emulated},
+    {"bextr", ISA(BMI1), bextr_throughput, bextr_throughput_emulated, bextr_latency, bextr_latency_emulated},
+    {"pdep",  ISA(BMI2), pdep_throughput,  pdep_throughput_emulated,  pdep_latency,  pdep_latency_emulated},
+    {"pext",  ISA(BMI2), pext_throughput,  pext_throughput_emulated,  pext_latency,  pext_latency_emulated},
+    {"shlx",  ISA(BMI2), shlx_throughput,  shlx_throughput_emulated,  shlx_latency,  shlx_latency_emulated},
+    {"mulx",  ISA(BMI2), mulx_throughput,  mulx_throughput_emulated,  mulx_latency,  mulx_latency_emulated},
+};
+
+//median core cycles per operation, 0 on failure
+static double measure_cycles(const struct bench_env *env, bench_fn run, struct bmi_ctx *ctx, double ghz) {
+    struct measure_result result;
+    struct measure_kernel kernel = {NULL, run, ctx, BMI_SAMPLE_CNT};
+    return measure_run(&kernel, env->config, &result) == 0 ? result.median * ghz : 0.0;
+}
+
+//throughput and latency of every instruction next to its emulation
+static int ops_section(const struct bench_env *env, struct bmi_ctx *ctx, double ghz) {
+    const uint64_t *mask = corpus_masks(env->corpus, 1, 32);
+    if(mask == NULL) {
+        return -1;
+    }
+    ctx->mask = *mask;
+    printf("Random operands, PDEP/PEXT mask with 32 of 64 bits set, cycles per instruction\r\n");
+    printf("%-8s %12s %12s %12s %12s\r\n", "", "tp", "tp emulated", "latency", "lat emulated");
+    for(size_t i=0; i<sizeof(ops) / sizeof(ops[0]); i++) {
+        const size_t requires[DISPATCH_REQUIRES_MAX] = {ops[i].requires};
+        const bool supported = dispatch_supported(env->cpu_info, requires);
+        double tp = supported ? measure_cycles(env, ops[i].throughput, ctx, ghz) : 0.0;
+        double tp_emulated = measure_cycles(env, ops[i].throughput_emulated, ctx, ghz);
+        double lat = supported ? measure_cycles(env, ops[i].latency, ctx, ghz) : 0.0;
+        double lat_emulated = measure_cycles(env, ops[i].latency_emulated, ctx, ghz);
+        if((supported && (tp == 0.0 || lat == 0.0)) || tp_emulated == 0.0 || lat_emulated == 0.0) {
+            return -1;
+        }
+        if(!supported) {
+            printf("%-8s %12s %12.2f %12s %12.2f\r\n", ops[i].name, "-", tp_emulated, "-", lat_emulated);
+            continue;
+        }
+        //the compiler vectorizes the cheap emulations, so only a loss in both columns counts
+        const bool slow = tp > tp_emulated * BMI_SLOW_FACTOR && lat > lat_emulated * BMI_SLOW_FACTOR;
+        printf("%-8s %12.2f %12.2f %12.2f %12.2f%s\r\n", ops[i].name, tp, tp_emulated, lat, lat_emulated,
+               slow ? "  hardware slower than emulation" : "");
+    }
+    return 0;
+}
+
+//PDEP/PEXT throughput over masks of growing popcount; microcoded implementations (AMD before Zen 3)
+//loop over the set mask bits, fast ones take the same few cycles for every mask
+static int mask_section(const struct bench_env *env, struct bmi_ctx *ctx, double ghz) {
+    static const uint32_t weights[] = {1, 2, 4, 8, 16, 24, 32, 40, 48, 56, 64};
+    uint32_t slow_from = 0;
+    bool slow = false;
+
+    printf("PDEP/PEXT throughput against the set bits of the mask, cycles per instruction\r\n");
+    printf("%-8s %12s %12s %12s %12s\r\n", "bits", "pdep", "pdep emu", "pext", "pext emu");
+    for(size_t i=0; i<WEIGHT_CNT; i++) {
+        const uint64_t *mask = corpus_masks(env->corpus, 1, weights[i]);
+        if(mask == NULL) {
+            return -1;
+        }
+        ctx->mask = *mask;
+        double pdep = measure_cycles(env, pdep_throughput, ctx, ghz);
+        double pdep_emulated = measure_cycles(env, pdep_throughput_emulated, ctx, ghz);
+        double pext = measure_cycles(env, pext_throughput, ctx, ghz);
+        double pext_emulated = measure_cycles(env, pext_throughput_emulated, ctx, ghz);
+        if(pdep == 0.0 || pdep_emulated == 0.0 || pext == 0.0 || pext_emulated == 0.0) {
+            return -1;
+        }
+        const bool row_slow = pdep > pdep_emulated * BMI_SLOW_FACTOR || pext > pext_emulated * BMI_SLOW_FACTOR;
+        printf("%-8u %12.2f %12.2f %12.2f %12.2f%s\r\n", weights[i], pdep, pdep_emulated, pext, pext_emulated,
+               row_slow ? "  hardware slower than emulation" : "");
+        slow_from = (row_slow && !slow) ? weights[i] : slow_from;
+        slow = slow || row_slow;
+    }
+
+    if(slow) {
+        printf("WARNING: PDEP/PEXT are slower than the emulation from %u set mask bits on (microcoded), "
+               "keep them out of hot paths on this CPU\r\n", slow_from);
+    } else {
+        printf("PDEP/PEXT: hardware is faster than the emulation for every mask\r\n");
+    }
+    return 0;
+}
+
+//BMI1/BMI2 instructions against their portable emulations, and the PDEP/PEXT mask dependence
+int bmi_suite(const struct bench_env *env) {
+    const double ghz = freq_core_ghz(env);
+    struct bmi_ctx ctx = {corpus_u64(env->corpus, BMI_SAMPLE_CNT), 0, 0};
+    if(ghz == 0.0 || ctx.data == NULL) {
+        return -1;
+    }
+
+    printf("Core clock (integer add chain): %.2f GHz, cycles below are core cycles\r\n", ghz);
+    if(ops_section(env, &ctx, ghz) != 0) {
+        return -1;
+    }
+    if(!dispatch_supported(env->cpu_info, REQUIRES(ISA(BMI2)))) {
+        printf("PDEP/PEXT: BMI2 not supported, only the emulation can be used\r\n");
+        return 0;
+    }
+    return mask_section(env, &ctx, ghz);
+}
@@ -0,0 +1,110 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef BMI_INSTRUCTIONS
+#define BMI_INSTRUCTIONS
+#include <stdint.h>
+#include <stddef.h>
+
+uint64_t emulated_tzcnt(uint64_t val);
+uint64_t emulated_blsr(uint64_t val);
+uint64_t emulated_andn(uint64_t fir, uint64_t sec);
+uint64_t emulated_bextr(uint64_t val, uint32_t start, uint32_t len);
+uint64_t emulated_pdep(uint64_t val, uint64_t mask);
+uint64_t emulated_pext(uint64_t val, uint64_t mask);
+uint64_t emulated_shlx(uint64_t val, uint64_t cnt);
+uint64_t emulated_mulx(uint64_t fir, uint64_t sec, uint64_t *hi);
+
+#define BMI_SAMPLE_CNT 1024      //operands per timed region, 8 KiB stay in L1D
+#define BMI_OPS_PER_ROUND 4      //four instructions per operand in bmi1_run and bmi2_run
+#define BMI_BEXTR_START 7        //field extracted by the bextr kernels
+#define BMI_BEXTR_LEN 23
+#define BMI_SLOW_FACTOR 1.5      //hardware this much slower than the emulation is flagged
+
+//operands of one kernel run; mask is the PDEP/PEXT mask, the other kernels ignore it
+struct bmi_ctx {
+    const uint64_t *data;        //BMI_SAMPLE_CNT operands
+    uint64_t mask;
+    uint64_t result;             //checksum, so the work can not be optimized away
+};
+
+//throughput kernels run one instruction over all BMI_SAMPLE_CNT operands, spread over four accumulators;
+//latency kernels feed every result into the next operation (x = op(x ^ data[i]))
+//the non-emulated kernels live in bmi1_hw.c (built for BMI1) and bmi2_hw.c (built for BMI2) and may only
+//run after dispatch
+void tzcnt_throughput(void *ctx);
+void blsr_throughput(void *ctx);
+void andn_throughput(void *ctx);
+void bextr_throughput(void *ctx);
+void pdep_throughput(void *ctx);
+void pext_throughput(void *ctx);
+void shlx_throughput(void *ctx);
+void mulx_throughput(void *ctx);
+void tzcnt_throughput_emulated(void *ctx);
+void blsr_throughput_emulated(void *ctx);
+void andn_throughput_emulated(void *ctx);
+void bextr_throughput_emulated(void *ctx);
+void pdep_throughput_emulated(void *ctx);
+void pext_throughput_emulated(void *ctx);
+void shlx_throughput_emulated(void *ctx);
+void mulx_throughput_emulated(void *ctx);
+void tzcnt_latency(void *ctx);
+void blsr_latency(void *ctx);
+void andn_latency(void *ctx);
+void bextr_latency(void *ctx);
+void pdep_latency(void *ctx);
+void pext_latency(void *ctx);
+void shlx_latency(void *ctx);
+void mulx_latency(void *ctx);
+void tzcnt_latency_emulated(void *ctx);
+void blsr_latency_emulated(void *ctx);
+void andn_latency_emulated(void *ctx);
+void bextr_latency_emulated(void *ctx);
+void pdep_latency_emulated(void *ctx);
+void pext_latency_emulated(void *ctx);
+void shlx_latency_emulated(void *ctx);
+void mulx_latency_emulated(void *ctx);
+
+//OP(val, mask) is the operation under test, the one operand instructions ignore mask
+#define BMI_KERNEL(name, suffix, OP)                                                         \
+void name##_throughput##suffix(void *arg) {                                                  \
+    struct bmi_ctx *ctx = arg;                                                               \
+    const uint64_t mask = ctx->mask;                                                         \
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;                                         \
+    for(size_t i=0; i<BMI_SAMPLE_CNT; i+=4) {                                                \
+        acc0 += OP(ctx->data[i], mask);                                                      \
+        acc1 += OP(ctx->data[i + 1], mask);                                                  \
+        acc2 += OP(ctx->data[i + 2], mask);                                                  \
+        acc3 += OP(ctx->data[i + 3], mask);                                                  \
+    }                                                                                        \
+    ctx->result = acc0 + acc1 + acc2 + acc3;                                                 \
+}                                                                                            \
+                                                                                             \
+void name##_latency##suffix(void *arg) {                                                     \
+    struct bmi_ctx *ctx = arg;                                                               \
+    const uint64_t mask = ctx->mask;                                                         \
+    uint64_t x = 0;                                                                          \
+    for(size_t i=0; i<BMI_SAMPLE_CNT; i++) {                                                 \
+        x = OP(x ^ ctx->data[i], mask);                                                      \
+    }                                                                                        \
+    ctx->result = x;                                                                         \
+}
+
+//per-extension benches for the registry, the ctx lives in the corpus arena and needs no teardown
+struct bench_env;
+void *bmi_setup(const struct bench_env *env, uint64_t *ops);
+void bmi1_run(void *ctx);
+void bmi1_run_emulated(void *ctx);
+void bmi2_run(void *ctx);
+void bmi2_run_emulated(void *ctx);
+
+int bmi_suite(const struct bench_env *env);
+
+#endif
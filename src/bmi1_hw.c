@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//BMI1 variants of the BMI kernels, this translation unit is compiled for BMI1 only
+//nothing in here may be called unless dispatch_supported() confirmed BMI1
+#pragma GCC target("bmi")
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bmi.h"
+
+//***********************************************
+//*****************INSTRUCTIONS******************
+//***********************************************
+
+//inline asm instead of intrinsics, the compiler may neither vectorize nor rewrite the instruction under test
+
+static inline uint64_t hw_tzcnt(uint64_t val, uint64_t mask) {
+    uint64_t res;
+    (void) mask;
+    __asm__ ("tzcntq %1, %0" :"=r"(res) :"r"(val) :"cc");
+    return res;
+}
+
+static inline uint64_t hw_blsr(uint64_t val, uint64_t mask) {
+    uint64_t res;
+    (void) mask;
+    __asm__ ("blsrq %1, %0" :"=r"(res) :"r"(val) :"cc");
+    return res;
+}
+
+//~val & mask
+static inline uint64_t hw_andn(uint64_t val, uint64_t mask) {
+    uint64_t res;
+    __asm__ ("andnq %2, %1, %0" :"=r"(res) :"r"(val), "r"(mask) :"cc");
+    return res;
+}
+
+static inline uint64_t hw_bextr(uint64_t val, uint64_t mask) {
+    const uint64_t control = BMI_BEXTR_START | (BMI_BEXTR_LEN << 8);
+    uint64_t res;
+    (void) mask;
+    __asm__ ("bextrq %2, %1, %0" :"=r"(res) :"r"(val), "r"(control) :"cc");
+    return res;
+}
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+BMI_KERNEL(tzcnt, , hw_tzcnt)
+BMI_KERNEL(blsr, , hw_blsr)
+BMI_KERNEL(andn, , hw_andn)
+BMI_KERNEL(bextr, , hw_bextr)
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+//instructions used: TZCNT; BLSR; ANDN; BEXTR
+void bmi1_run(void *arg) {
+    struct bmi_ctx *ctx = arg;
+    uint64_t sum = 0;
+
+    tzcnt_throughput(ctx);
+    sum += ctx->result;
+    blsr_throughput(ctx);
+    sum += ctx->result;
+    andn_throughput(ctx);
+    sum += ctx->result;
+    bextr_throughput(ctx);
+    ctx->result += sum;
+}
@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//BMI2 variants of the BMI kernels, this translation unit is compiled for BMI2 only
+//nothing in here may be called unless dispatch_supported() confirmed BMI2
+#pragma GCC target("bmi2")
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bmi.h"
+
+//***********************************************
+//*****************INSTRUCTIONS******************
+//***********************************************
+
+//inline asm instead of intrinsics, the compiler may neither vectorize nor rewrite the instruction under test
+
+static inline uint64_t hw_pdep(uint64_t val, uint64_t mask) {
+    uint64_t res;
+    __asm__ ("pdepq %2, %1, %0" :"=r"(res) :"r"(val), "r"(mask));
+    return res;
+}
+
+static inline uint64_t hw_pext(uint64_t val, uint64_t mask) {
+    uint64_t res;
+    __asm__ ("pextq %2, %1, %0" :"=r"(res) :"r"(val), "r"(mask));
+    return res;
+}
+
+//shift count is the low six bits of mask
+static inline uint64_t hw_shlx(uint64_t val, uint64_t mask) {
+    uint64_t res;
+    __asm__ ("shlxq %2, %1, %0" :"=r"(res) :"r"(val), "r"(mask));
+    return res;
+}
+
+//sum of both halves of the 128 bit product
+static inline uint64_t hw_mulx(uint64_t val, uint64_t mask) {
+    uint64_t lo, hi;
+    __asm__ ("mulxq %3, %0, %1" :"=r"(lo), "=r"(hi) :"d"(val), "r"(mask));
+    return lo + hi;
+}
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+BMI_KERNEL(pdep, , hw_pdep)
+BMI_KERNEL(pext, , hw_pext)
+BMI_KERNEL(shlx, , hw_shlx)
+BMI_KERNEL(mulx, , hw_mulx)
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+//instructions used: PDEP; PEXT; SHLX; MULX
+void bmi2_run(void *arg) {
+    struct bmi_ctx *ctx = arg;
+    uint64_t sum = 0;
+
+    pdep_throughput(ctx);
+    sum += ctx->result;
+    pext_throughput(ctx);
+    sum += ctx->result;
+    shlx_throughput(ctx);
+    sum += ctx->result;
+    mulx_throughput(ctx);
+    ctx->result += sum;
+}
@@ -0,0 +1,283 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//branch predictor and frontend suite, the measured successors of the random_jump, tf_jumps and
+//recursive_calls stressors of oldbenchmark.c. All results are in core cycles (see freq.c).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "freq.h"
+#include "branch.h"
+
+#define STRINGIFY(x) #x
+#define EXPAND(x) STRINGIFY(x)
+#define DEPTH_CNT (sizeof(depths) / sizeof(depths[0]))
+#define RANDOM_PERIOD (2 * BRANCH_MAX_PERIOD)            //one period never repeats within the buffer
+#define PERIOD_CNT (__builtin_ctz(RANDOM_PERIOD) + 1)    //1 to RANDOM_PERIOD in powers of two
+
+_Static_assert((BRANCH_MAX_PERIOD & (BRANCH_MAX_PERIOD - 1)) == 0, "BRANCH_MAX_PERIOD must be a power of two");
+_Static_assert(RANDOM_PERIOD <= BRANCH_PATTERN_LEN, "the random pattern must fit into the buffer");
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+//BTB_MAX_BRANCHES unconditional jumps, each to the next one, BTB_STRIDE bytes apart; entering the
+//chain BTB_STRIDE * (BTB_MAX_BRANCHES - n) bytes after btb_chain runs the last n of them
+__asm__ (".text \n\t"
+         ".balign 64 \n"
+         "btb_chain: \n\t"
+         ".rept " EXPAND(BTB_MAX_BRANCHES) "\n\t"
+         "jmp 1f \n\t"
+         ".balign " EXPAND(BTB_STRIDE) ", 0xcc \n"
+         "1: \n\t"
+         ".endr \n\t"
+         "ret");
+
+//recursion down to depth 0; the two call sites alternate with the depth and share one ret, so once
+//the return stack buffer underflows the BTB can not stand in for it (the target changes every time)
+__asm__ (".text \n\t"
+         ".balign 64 \n"
+         "rsb_recurse: \n\t"
+         "test %rdi, %rdi \n\t"
+         "jz 2f \n\t"
+         "dec %rdi \n\t"
+         "test $1, %dil \n\t"
+         "jnz 1f \n\t"
+         "call rsb_recurse \n\t"
+         "jmp 2f \n"
+         "1: \n\t"
+         "call rsb_recurse \n"
+         "2: \n\t"
+         "ret");
+
+void btb_chain(void);
+void rsb_recurse(uint64_t depth);
+
+//one conditional branch per outcome, taken if the outcome is not 0
+static void pattern_run(void *arg) {
+    struct branch_ctx *ctx = arg;
+    uint64_t taken = 0;
+    for(size_t i=0; i<BRANCH_PATTERN_LEN; i++) {
+        __asm__ volatile ("test %1, %1 \n\t"
+                          "jz 1f \n\t"
+                          "inc %0 \n"
+                          "1:"
+            :"+r"(taken)
+            :"r"((uint32_t) ctx->outcomes[i])
+            :"cc"
+        );
+    }
+    ctx->result = taken;
+}
+
+#define TARGET(k) static uint64_t __attribute__((noinline)) target_##k(uint64_t x) { return x + k + 1; }
+TARGET(0) TARGET(1) TARGET(2) TARGET(3) TARGET(4) TARGET(5) TARGET(6) TARGET(7)
+TARGET(8) TARGET(9) TARGET(10) TARGET(11) TARGET(12) TARGET(13) TARGET(14) TARGET(15)
+
+static uint64_t (*const targets[BRANCH_INDIRECT_TARGETS])(uint64_t) = {
+    target_0, target_1, target_2, target_3, target_4, target_5, target_6, target_7,
+    target_8, target_9, target_10, target_11, target_12, target_13, target_14, target_15,
+};
+
+//one indirect call per outcome, the outcome selects the target
+static void indirect_run(void *arg) {
+    struct branch_ctx *ctx = arg;
+    uint64_t x = 0;
+    for(size_t i=0; i<BRANCH_PATTERN_LEN; i++) {
+        x = targets[ctx->outcomes[i]](x);
+    }
+    ctx->result = x;
+}
+
+static void btb_run(void *arg) {
+    struct branch_ctx *ctx = arg;
+    for(uint64_t r=0; r<ctx->reps; r++) {
+        ctx->entry();
+    }
+}
+
+static void rsb_run(void *arg) {
+    struct branch_ctx *ctx = arg;
+    for(uint64_t r=0; r<ctx->reps; r++) {
+        rsb_recurse(ctx->depth);
+    }
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//median core cycles per operation, 0 on failure
+static double measure_cycles(const struct bench_env *env, bench_fn run, struct branch_ctx *ctx, uint64_t ops,
+                             double ghz) {
+    struct measure_result result;
+    struct measure_kernel kernel = {NULL, run, ctx, ops};
+    return measure_run(&kernel, env->config, &result) == 0 ? result.median * ghz : 0.0;
+}
+
+//the first period random bits repeated over the whole buffer
+static void fill_pattern(uint8_t *outcomes, size_t period, struct rng *rng) {
+    for(size_t i=0; i<period; i++) {
+        outcomes[i] = (uint8_t) (rng_next(rng) >> 63);
+    }
+    for(size_t i=period; i<BRANCH_PATTERN_LEN; i++) {
+        outcomes[i] = outcomes[i - period];
+    }
+}
+
+//cost of a conditional branch for taken/not-taken patterns of growing period; short periods are
+//learned by the predictor, random outcomes mispredict half of the time, which gives the penalty
+static int pattern_section(const struct bench_env *env, uint8_t *outcomes, double ghz) {
+    struct branch_ctx ctx = {outcomes, NULL, 0, 0, 0};
+    double cycles[PERIOD_CNT];
+    double base = 0.0;
+    size_t learned = 0, k = 0;
+
+    printf("Conditional branch, random taken/not-taken pattern repeating with the given period\r\n");
+    printf("%10s %12s\r\n", "period", "cyc/branch");
+    for(size_t period=1; period<=RANDOM_PERIOD; period*=2, k++) {
+        fill_pattern(outcomes, period, &env->corpus->rng);
+        cycles[k] = measure_cycles(env, pattern_run, &ctx, BRANCH_PATTERN_LEN, ghz);
+        if(cycles[k] == 0.0) {
+            return -1;
+        }
+        if(period == RANDOM_PERIOD) {
+            printf("%10s %12.2f\r\n", "random", cycles[k]);
+        } else {
+            printf("%10zu %12.2f\r\n", period, cycles[k]);
+        }
+        base = (base == 0.0 || cycles[k] < base) ? cycles[k] : base;
+    }
+
+    //a period counts as learned while it stays in the lower quarter between predicted and random
+    const double random = cycles[PERIOD_CNT - 1];
+    for(size_t period=1, i=0; period<RANDOM_PERIOD && cycles[i]<=base+(random-base)/4; period*=2, i++) {
+        learned = period;
+    }
+    printf("Mispredict penalty: %.1f cycles (random outcomes miss half of the time)\r\n", 2.0 * (random - base));
+    printf("Longest pattern still predicted: %zu outcomes\r\n", learned);
+    return 0;
+}
+
+//cost of an indirect call whose target cycles through or randomly picks one of n targets
+static int indirect_section(const struct bench_env *env, uint8_t *outcomes, double ghz) {
+    struct branch_ctx ctx = {outcomes, NULL, 0, 0, 0};
+
+    printf("Indirect call among n targets\r\n");
+    printf("%10s %12s %12s %12s\r\n", "targets", "cyclic", "random", "penalty");
+    for(uint32_t n=1; n<=BRANCH_INDIRECT_TARGETS; n*=2) {
+        for(size_t i=0; i<BRANCH_PATTERN_LEN; i++) {
+            outcomes[i] = (uint8_t) (i % n);
+        }
+        double cyclic = measure_cycles(env, indirect_run, &ctx, BRANCH_PATTERN_LEN, ghz);
+        for(size_t i=0; i<BRANCH_PATTERN_LEN; i++) {
+            outcomes[i] = (uint8_t) rng_below(&env->corpus->rng, n);
+        }
+        double random = measure_cycles(env, indirect_run, &ctx, BRANCH_PATTERN_LEN, ghz);
+        if(cyclic == 0.0 || random == 0.0) {
+            return -1;
+        }
+        //a random pick of n targets is mispredicted with probability 1 - 1/n
+        printf("%10u %12.2f %12.2f", n, cyclic, random);
+        if(n > 1) {
+            printf(" %12.1f\r\n", (random - cyclic) * n / (n - 1));
+        } else {
+            printf(" %12s\r\n", "-");
+        }
+    }
+    return 0;
+}
+
+//cost of a taken jump as the number of distinct jumps grows past the BTB (and the L1i)
+static int btb_section(const struct bench_env *env, double ghz) {
+    const uint8_t *chain = (const uint8_t *) btb_chain;
+    struct branch_ctx ctx = {NULL, NULL, 0, 0, 0};
+    double fastest = 0.0;
+    size_t capacity = 0;
+    bool limited = false;
+
+    printf("Distinct unconditional jumps, %d bytes apart\r\n", BTB_STRIDE);
+    printf("%10s %12s %12s\r\n", "jumps", "code KiB", "cyc/jump");
+    for(size_t n=16; n<=BTB_MAX_BRANCHES; n*=2) {
+        ctx.entry = (void (*)(void)) (chain + (BTB_MAX_BRANCHES - n) * BTB_STRIDE);
+        ctx.reps = BTB_SAMPLE_BRANCHES / n;
+        double cycles = measure_cycles(env, btb_run, &ctx, ctx.reps * n, ghz);
+        if(cycles == 0.0) {
+            return -1;
+        }
+        printf("%10zu %12.1f %12.2f\r\n", n, n * BTB_STRIDE / 1024.0, cycles);
+        fastest = (fastest == 0.0 || cycles < fastest) ? cycles : fastest;
+        limited = limited || cycles > fastest * BRANCH_SLOW_FACTOR;
+        capacity = limited ? capacity : n;
+    }
+    printf("Jumps handled at full speed: %zu%s\r\n", capacity, limited ? "" : " (no limit found)");
+    return 0;
+}
+
+//cost of a call/ret pair for recursion of growing depth, returns mispredict once the depth exceeds
+//the return stack buffer
+static int rsb_section(const struct bench_env *env, double ghz) {
+    static const uint32_t depths[] = {1, 2, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 48, 56, 64, 96, RSB_MAX_DEPTH};
+    struct branch_ctx ctx = {NULL, NULL, 0, 0, 0};
+    double cycles[DEPTH_CNT];
+    size_t fastest = 0;
+
+    printf("Recursion, cost per call/ret pair\r\n");
+    printf("%10s %12s\r\n", "depth", "cyc/call");
+    for(size_t i=0; i<DEPTH_CNT; i++) {
+        ctx.depth = depths[i];
+        ctx.reps = RSB_SAMPLE_CALLS / (depths[i] + 1);
+        cycles[i] = measure_cycles(env, rsb_run, &ctx, ctx.reps * (depths[i] + 1), ghz);
+        if(cycles[i] == 0.0) {
+            return -1;
+        }
+        printf("%10u %12.2f\r\n", depths[i], cycles[i]);
+        fastest = cycles[i] < cycles[fastest] ? i : fastest;
+    }
+
+    //shallow recursion is slower because the loop around it is spread over fewer calls,
+    //so the limit is searched after the fastest depth
+    size_t last = fastest;
+    while(last + 1 < DEPTH_CNT && cycles[last + 1] <= cycles[fastest] * BRANCH_SLOW_FACTOR) {
+        last++;
+    }
+    if(last + 1 < DEPTH_CNT) {
+        printf("Return stack buffer: %u to %u entries\r\n", depths[last], depths[last + 1] - 1);
+    } else {
+        printf("Return stack buffer: no limit found up to depth %u\r\n", RSB_MAX_DEPTH);
+    }
+    return 0;
+}
+
+//mispredict penalty and pattern length of the conditional predictor, indirect target prediction,
+//BTB capacity and return stack buffer depth
+int branch_suite(const struct bench_env *env) {
+    const double ghz = freq_core_ghz(env);
+    uint8_t *outcomes = arena_alloc(&env->corpus->arena, BRANCH_PATTERN_LEN);
+    if(ghz == 0.0 || outcomes == NULL) {
+        return -1;
+    }
+
+    printf("Core clock (integer add chain): %.2f GHz, cycles below are core cycles\r\n", ghz);
+    if(pattern_section(env, outcomes, ghz) != 0 || indirect_section(env, outcomes, ghz) != 0 ||
+       btb_section(env, ghz) != 0 || rsb_section(env, ghz) != 0) {
+        return -1;
+    }
+    return 0;
+}
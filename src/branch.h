@@ -0,0 +1,38 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef BRANCH
+#define BRANCH
+#include <stdint.h>
+#include <stddef.h>
+
+#define BRANCH_PATTERN_LEN 65536    //outcomes per sample of the pattern and indirect kernels
+#define BRANCH_MAX_PERIOD 32768     //longest repeating pattern, longer ones count as random
+#define BRANCH_INDIRECT_TARGETS 16
+#define BTB_MAX_BRANCHES 8192       //direct jumps in the BTB chain
+#define BTB_STRIDE 16               //bytes between two jumps of the chain
+#define BTB_SAMPLE_BRANCHES 65536   //jumps per sample, the chain is run as often as needed
+#define RSB_MAX_DEPTH 128
+#define RSB_SAMPLE_CALLS 65536      //calls per sample, the recursion is repeated as often as needed
+#define BRANCH_SLOW_FACTOR 1.25     //a step this much slower than the fastest one marks a capacity limit
+
+//one kernel configuration, the fields a kernel does not use stay zero
+struct branch_ctx {
+    const uint8_t *outcomes; //BRANCH_PATTERN_LEN taken flags or indirect target indices
+    void (*entry)(void);     //first jump of the BTB chain to run
+    uint64_t reps;           //runs of the BTB chain or the recursion per sample
+    uint64_t depth;          //recursion depth
+    uint64_t result;
+};
+
+struct bench_env;
+int branch_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,249 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//core-to-core latency: two threads pinned to a pair of logical CPUs hand one cache line back and forth,
+//the round trip time shows SMT siblings, L3 domains (CCX/CCD, ring or mesh stops) and package hops
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "cpuinfo.h"
+#include "topology.h"
+#include "measure.h"
+#include "registry.h"
+#include "c2c.h"
+
+//how two logical CPUs are connected, from near to far
+enum c2c_class {
+    C2C_SMT,     //same core
+    C2C_L3,      //different cores behind the same L3
+    C2C_PACKAGE, //same package, different L3
+    C2C_REMOTE,  //different packages
+    C2C_CLASS_CNT
+};
+
+static const char *const class_names[C2C_CLASS_CNT] = {"SMT siblings", "shared L3", "same package", "other package"};
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+static int pin_thread(uint32_t cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+//answers every odd value with the next even one until C2C_STOP shows up
+//both sides spin without pause, it would add its own latency (up to 140 cycles) to every hop
+static void *responder_main(void *arg) {
+    struct c2c_ctx *ctx = arg;
+    if(pin_thread(ctx->responder_cpu) != 0) {
+        atomic_store_explicit(&ctx->ready, -1, memory_order_release);
+        return NULL;
+    }
+    atomic_store_explicit(&ctx->ready, 1, memory_order_release);
+    for(uint64_t expect=1; ; expect+=2) {
+        uint64_t val;
+        while((val = atomic_load_explicit(ctx->line, memory_order_acquire)) != expect) {
+            if(val == C2C_STOP) {
+                return NULL;
+            }
+        }
+        atomic_store_explicit(ctx->line, expect + 1, memory_order_release);
+    }
+}
+
+//C2C_ROUND_TRIPS round trips of the line, each one moves it to the responder and back
+static void ping_run(void *arg) {
+    struct c2c_ctx *ctx = arg;
+    uint64_t seq = ctx->seq;
+    for(uint32_t r=0; r<C2C_ROUND_TRIPS; r++) {
+        atomic_store_explicit(ctx->line, seq + 1, memory_order_release);
+        while(atomic_load_explicit(ctx->line, memory_order_acquire) != seq + 2) {
+        }
+        seq += 2;
+    }
+    ctx->seq = seq;
+}
+
+//median ns per round trip between the calling thread pinned to initiator and a responder thread, 0 on failure
+static double measure_pair(const struct measure_config *config, _Atomic uint64_t *line, uint32_t initiator,
+                           uint32_t responder) {
+    struct c2c_ctx ctx = {line, 0, responder, 0};
+    struct measure_kernel kernel = {NULL, ping_run, &ctx, C2C_ROUND_TRIPS};
+    struct measure_result result;
+    pthread_t thread;
+
+    if(pin_thread(initiator) != 0) {
+        return 0.0;
+    }
+    atomic_store(line, 0);
+    if(pthread_create(&thread, NULL, responder_main, &ctx) != 0) {
+        return 0.0;
+    }
+    //ping_run would wait forever for a responder that gave up, so it only starts once the responder is pinned
+    int ready;
+    while((ready = atomic_load_explicit(&ctx.ready, memory_order_acquire)) == 0) {
+        sched_yield();
+    }
+    int status = ready > 0 ? measure_run(&kernel, config, &result) : -1;
+    atomic_store(line, C2C_STOP);
+    pthread_join(thread, NULL);
+    return status == 0 ? result.median : 0.0;
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+static enum c2c_class classify(const struct cpu_topology *topology, const struct logical_cpu *a,
+                               const struct logical_cpu *b) {
+    if(a->package != b->package) {
+        return C2C_REMOTE;
+    }
+    if(a->core == b->core) {
+        return C2C_SMT;
+    }
+    uint32_t domain = topology_cache_domain(topology, a, 3);
+    if(domain != UINT32_MAX && domain == topology_cache_domain(topology, b, 3)) {
+        return C2C_L3;
+    }
+    return C2C_PACKAGE;
+}
+
+//min/avg/max round trip of every class that occurs on this machine
+static void print_classes(const struct cpu_topology *topology, const double *matrix) {
+    const uint32_t n = topology->cpu_cnt;
+    double min[C2C_CLASS_CNT] = {0}, max[C2C_CLASS_CNT] = {0}, sum[C2C_CLASS_CNT] = {0};
+    uint32_t cnt[C2C_CLASS_CNT] = {0};
+
+    for(uint32_t i=0; i<n; i++) {
+        for(uint32_t j=i+1; j<n; j++) {
+            enum c2c_class c = classify(topology, &topology->cpus[i], &topology->cpus[j]);
+            double ns = matrix[i * n + j];
+            min[c] = (cnt[c] == 0 || ns < min[c]) ? ns : min[c];
+            max[c] = (cnt[c] == 0 || ns > max[c]) ? ns : max[c];
+            sum[c] += ns;
+            cnt[c]++;
+        }
+    }
+    for(uint32_t c=0; c<C2C_CLASS_CNT; c++) {
+        if(cnt[c] > 0) {
+            printf("%-14s %6u pairs, round trip min %7.1f ns, avg %7.1f ns, max %7.1f ns\r\n", class_names[c],
+                   cnt[c], min[c], sum[c] / cnt[c], max[c]);
+        }
+    }
+}
+
+//the matrix with the OS cpu numbers as first row and column, the diagonal stays empty
+static int write_csv(const struct cpu_topology *topology, const double *matrix, const char *path) {
+    const uint32_t n = topology->cpu_cnt;
+    FILE *file = fopen(path, "w");
+    if(file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "cpu");
+    for(uint32_t j=0; j<n; j++) {
+        fprintf(file, ",%u", topology->cpus[j].cpu);
+    }
+    fprintf(file, "\n");
+    for(uint32_t i=0; i<n; i++) {
+        fprintf(file, "%u", topology->cpus[i].cpu);
+        for(uint32_t j=0; j<n; j++) {
+            if(i == j) {
+                fprintf(file, ",");
+            } else {
+                fprintf(file, ",%.2f", matrix[i * n + j]);
+            }
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+//round trip latency of one cache line for every pair of logical CPUs; the round trip is symmetric,
+//so every pair is measured once and mirrored, a row is printed as soon as it is complete
+int c2c_suite(const struct bench_env *env) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    const uint32_t n = env->cpu_info->CORES_LOGICAL;
+    struct measure_config config = *env->config;
+    cpu_set_t saved;
+
+    if(n < 2) {
+        printf("Core-to-core latency needs at least two logical CPUs, this process may use %u\r\n", n);
+        return 0;
+    }
+    if(pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) != 0) {
+        return -1;
+    }
+    _Atomic uint64_t *line = aligned_alloc(C2C_LINE_BYTES, C2C_LINE_BYTES);
+    double *matrix = calloc((size_t) n * n, sizeof(*matrix));
+    int status = 0;
+    if(line == NULL || matrix == NULL) {
+        status = -1;
+        goto out;
+    }
+    config.max_seconds = config.max_seconds < C2C_PAIR_SECONDS ? config.max_seconds : C2C_PAIR_SECONDS;
+    config.counters = NULL;
+
+    printf("Round trip of one cache line between two pinned threads in ns, %u CPUs, %u pairs\r\n",
+           n, n * (n - 1) / 2);
+    printf("%6s", "cpu");
+    for(uint32_t j=0; j<n; j++) {
+        printf("%7u", topology->cpus[j].cpu);
+    }
+    printf("\r\n");
+    for(uint32_t i=0; i<n && status==0; i++) {
+        for(uint32_t j=i+1; j<n; j++) {
+            double ns = measure_pair(&config, line, topology->cpus[i].cpu, topology->cpus[j].cpu);
+            if(ns == 0.0) {
+                status = -1;
+                break;
+            }
+            matrix[i * n + j] = matrix[j * n + i] = ns;
+        }
+        printf("%6u", topology->cpus[i].cpu);
+        for(uint32_t j=0; j<n && status==0; j++) {
+            if(i == j) {
+                printf("%7s", "-");
+            } else {
+                printf("%7.1f", matrix[i * n + j]);
+            }
+        }
+        printf("\r\n");
+        fflush(stdout);
+    }
+
+    if(status == 0) {
+        print_classes(topology, matrix);
+    }
+    if(status == 0 && env->c2c_csv) {
+        if(write_csv(topology, matrix, env->c2c_csv) != 0) {
+            printf("Could not write %s\r\n", env->c2c_csv);
+            status = -1;
+        } else {
+            printf("Matrix written to %s\r\n", env->c2c_csv);
+        }
+    }
+
+out:
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    free(line);
+    free(matrix);
+    return status;
+}
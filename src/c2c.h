@@ -0,0 +1,33 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef C2C
+#define C2C
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define C2C_LINE_BYTES 128          //the ping-pong line gets two cache lines, so the adjacent line prefetcher stays out
+#define C2C_ROUND_TRIPS 256         //round trips per timed sample
+#define C2C_PAIR_SECONDS 0.02       //measure_config.max_seconds for one pair, the matrix has n * (n - 1) / 2 of them
+#define C2C_STOP UINT64_MAX         //written to the line to let the responder return
+
+//one pair of the matrix: the initiator (the calling thread) writes odd values to the line,
+//the responder thread answers every one of them with the next even value
+struct c2c_ctx {
+    _Atomic uint64_t *line;
+    uint64_t seq;               //last even value seen by the initiator
+    uint32_t responder_cpu;
+    _Atomic int ready;          //set by the responder: 1 once pinned, -1 if it could not be pinned
+};
+
+struct bench_env;
+int c2c_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,383 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "copy.h"
+
+#define COLUMN_WIDTH 10
+#define STRATEGY_CNT (sizeof(strategies) / sizeof(strategies[0]))
+#define SIZE_CNT 28 //COPY_MIN_BYTES to COPY_MAX_BYTES in powers of two
+#define FILL_BYTE 0x5a
+#define GUARD_BYTE 0xa5
+#define TIE_TOLERANCE 0.02 //the previous winner keeps its place unless it is more than this much slower
+
+//lengths around every unroll and vector boundary of the strategies
+static const size_t check_lengths[] = {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+                                       255, 256, 257, 1000, 4099, 65536 + 15};
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+static void copy_glibc(void *dst, const void *src, size_t n) {
+    memcpy(dst, src, n);
+}
+
+static void fill_glibc(void *dst, int c, size_t n) {
+    memset(dst, c, n);
+}
+
+//rep movsb/stosb work everywhere, ERMS makes them fast for large and FSRM for short lengths
+void copy_rep_movsb(void *dst, const void *src, size_t n) {
+    __asm__ volatile ("rep movsb"
+        :"+D"(dst), "+S"(src), "+c"(n)
+        :
+        :"memory"
+    );
+}
+
+void fill_rep_stosb(void *dst, int c, size_t n) {
+    __asm__ volatile ("rep stosb"
+        :"+D"(dst), "+c"(n)
+        :"a"(c)
+        :"memory"
+    );
+}
+
+//SSE2 is part of the x86-64 baseline, so these loops need no dispatch
+void copy_sse2(void *dst_arg, const void *src_arg, size_t n) {
+    uint8_t *dst = dst_arg;
+    const uint8_t *src = src_arg;
+    size_t i = 0;
+
+    if(n < sizeof(__m128i)) {
+        copy_small(dst, src, n);
+        return;
+    }
+    for(; i + 4 * sizeof(__m128i) <= n; i += 4 * sizeof(__m128i)) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i *) (src + i + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *) (src + i + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i *) (src + i + 48));
+        _mm_storeu_si128((__m128i *) (dst + i), v0);
+        _mm_storeu_si128((__m128i *) (dst + i + 16), v1);
+        _mm_storeu_si128((__m128i *) (dst + i + 32), v2);
+        _mm_storeu_si128((__m128i *) (dst + i + 48), v3);
+    }
+    for(; i + sizeof(__m128i) <= n; i += sizeof(__m128i)) {
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_loadu_si128((const __m128i *) (src + i)));
+    }
+    //the last vector overlaps the previous one instead of falling back to smaller moves
+    if(i < n) {
+        _mm_storeu_si128((__m128i *) (dst + n - 16), _mm_loadu_si128((const __m128i *) (src + n - 16)));
+    }
+}
+
+void fill_sse2(void *dst_arg, int c, size_t n) {
+    uint8_t *dst = dst_arg;
+    const __m128i val = _mm_set1_epi8((char) c);
+    size_t i = 0;
+
+    if(n < sizeof(__m128i)) {
+        fill_small(dst, c, n);
+        return;
+    }
+    for(; i + 4 * sizeof(__m128i) <= n; i += 4 * sizeof(__m128i)) {
+        _mm_storeu_si128((__m128i *) (dst + i), val);
+        _mm_storeu_si128((__m128i *) (dst + i + 16), val);
+        _mm_storeu_si128((__m128i *) (dst + i + 32), val);
+        _mm_storeu_si128((__m128i *) (dst + i + 48), val);
+    }
+    for(; i + sizeof(__m128i) <= n; i += sizeof(__m128i)) {
+        _mm_storeu_si128((__m128i *) (dst + i), val);
+    }
+    if(i < n) {
+        _mm_storeu_si128((__m128i *) (dst + n - 16), val);
+    }
+}
+
+//non-temporal stores bypass the caches, they need a 16 byte aligned destination, so the
+//unaligned head and tail are written with regular stores
+void copy_sse2_nt(void *dst_arg, const void *src_arg, size_t n) {
+    uint8_t *dst = dst_arg;
+    const uint8_t *src = src_arg;
+
+    if(n < 4 * sizeof(__m128i)) {
+        copy_sse2(dst, src, n);
+        return;
+    }
+    _mm_storeu_si128((__m128i *) dst, _mm_loadu_si128((const __m128i *) src));
+    size_t i = sizeof(__m128i) - ((uintptr_t) dst & (sizeof(__m128i) - 1));
+    for(; i + 4 * sizeof(__m128i) <= n; i += 4 * sizeof(__m128i)) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i *) (src + i + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *) (src + i + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i *) (src + i + 48));
+        _mm_stream_si128((__m128i *) (dst + i), v0);
+        _mm_stream_si128((__m128i *) (dst + i + 16), v1);
+        _mm_stream_si128((__m128i *) (dst + i + 32), v2);
+        _mm_stream_si128((__m128i *) (dst + i + 48), v3);
+    }
+    for(; i + sizeof(__m128i) <= n; i += sizeof(__m128i)) {
+        _mm_stream_si128((__m128i *) (dst + i), _mm_loadu_si128((const __m128i *) (src + i)));
+    }
+    if(i < n) {
+        _mm_storeu_si128((__m128i *) (dst + n - 16), _mm_loadu_si128((const __m128i *) (src + n - 16)));
+    }
+    //streaming stores are weakly ordered, make them visible before the copy counts as done
+    _mm_sfence();
+}
+
+void fill_sse2_nt(void *dst_arg, int c, size_t n) {
+    uint8_t *dst = dst_arg;
+    const __m128i val = _mm_set1_epi8((char) c);
+
+    if(n < 4 * sizeof(__m128i)) {
+        fill_sse2(dst, c, n);
+        return;
+    }
+    _mm_storeu_si128((__m128i *) dst, val);
+    size_t i = sizeof(__m128i) - ((uintptr_t) dst & (sizeof(__m128i) - 1));
+    for(; i + 4 * sizeof(__m128i) <= n; i += 4 * sizeof(__m128i)) {
+        _mm_stream_si128((__m128i *) (dst + i), val);
+        _mm_stream_si128((__m128i *) (dst + i + 16), val);
+        _mm_stream_si128((__m128i *) (dst + i + 32), val);
+        _mm_stream_si128((__m128i *) (dst + i + 48), val);
+    }
+    for(; i + sizeof(__m128i) <= n; i += sizeof(__m128i)) {
+        _mm_stream_si128((__m128i *) (dst + i), val);
+    }
+    if(i < n) {
+        _mm_storeu_si128((__m128i *) (dst + n - 16), val);
+    }
+    _mm_sfence();
+}
+
+static void copy_run(void *arg) {
+    struct copy_ctx *ctx = arg;
+    for(uint32_t i=0; i<ctx->reps; i++) {
+        ctx->strategy->copy(ctx->dst, ctx->src, ctx->bytes);
+    }
+}
+
+static void fill_run(void *arg) {
+    struct copy_ctx *ctx = arg;
+    for(uint32_t i=0; i<ctx->reps; i++) {
+        ctx->strategy->fill(ctx->dst, FILL_BYTE, ctx->bytes);
+    }
+}
+
+//***********************************************
+//*******************REGISTRY********************
+//***********************************************
+
+//COPY_SAMPLE_BYTES between two arena buffers (L2 resident), ops are bytes
+void *copy_setup(const struct bench_env *env, uint64_t *ops) {
+    struct copy_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    uint8_t *dst = arena_alloc(&env->corpus->arena, COPY_SAMPLE_BYTES);
+    const uint64_t *src = corpus_u64(env->corpus, COPY_SAMPLE_BYTES / sizeof(uint64_t));
+    if(ctx == NULL || dst == NULL || src == NULL) {
+        return NULL;
+    }
+    ctx->strategy = NULL;
+    ctx->dst = dst;
+    ctx->src = (const uint8_t *) src;
+    ctx->bytes = COPY_SAMPLE_BYTES;
+    ctx->reps = 1;
+    *ops = COPY_SAMPLE_BYTES;
+    return ctx;
+}
+
+void erms_run(void *arg) {
+    struct copy_ctx *ctx = arg;
+    copy_rep_movsb(ctx->dst, ctx->src, ctx->bytes);
+}
+
+//without ERMS rep movsb is slow for most sizes, a library would pick the SSE2 copy instead
+void erms_run_emulated(void *arg) {
+    struct copy_ctx *ctx = arg;
+    copy_sse2(ctx->dst, ctx->src, ctx->bytes);
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//"8 B", "4 KiB", "1 GiB", sizes are powers of two
+static const char *format_size(char *buf, size_t len, size_t bytes) {
+    static const char *units[] = {"B", "KiB", "MiB", "GiB"};
+    size_t unit = 0;
+    while(bytes >= 1024 && unit < 3) {
+        bytes >>= 10;
+        unit++;
+    }
+    snprintf(buf, len, "%zu %s", bytes, units[unit]);
+    return buf;
+}
+
+//checks copy and fill of strategy for every check length from an aligned and a misaligned start,
+//including that no byte behind the destination is touched, returns false on a mismatch
+static bool copy_verify(const struct copy_strategy *strategy, uint8_t *dst, const uint8_t *src) {
+    for(size_t i=0; i<sizeof(check_lengths) / sizeof(check_lengths[0]); i++) {
+        for(size_t offset=0; offset<2; offset++) {
+            const size_t n = check_lengths[i];
+            uint8_t *d = dst + offset * COPY_DST_MISALIGN;
+            const uint8_t *s = src + offset * COPY_SRC_MISALIGN;
+
+            memset(dst, GUARD_BYTE, n + 2 * CORPUS_ALIGNMENT);
+            strategy->copy(d, s, n);
+            bool copied = memcmp(d, s, n) == 0 && d[n] == GUARD_BYTE && (offset == 0 || dst[0] == GUARD_BYTE);
+
+            memset(dst, GUARD_BYTE, n + 2 * CORPUS_ALIGNMENT);
+            strategy->fill(d, FILL_BYTE, n);
+            bool filled = d[n] == GUARD_BYTE && (offset == 0 || dst[0] == GUARD_BYTE);
+            for(size_t k=0; k<n && filled; k++) {
+                filled = d[k] == FILL_BYTE;
+            }
+
+            if(!copied || !filled) {
+                printf("%s: wrong %s for %zu bytes at offset %zu, excluded\r\n", strategy->name,
+                       copied ? "fill" : "copy", n, offset);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//prints the size ranges in which each strategy was the fastest
+static void print_crossovers(const char *title, const struct copy_strategy *strategies, const size_t *best,
+                             uint32_t rows) {
+    char from[32], to[32];
+    printf("%s:", title);
+    for(uint32_t row=0; row<rows; ) {
+        uint32_t end = row;
+        while(end + 1 < rows && best[end + 1] == best[row]) {
+            end++;
+        }
+        format_size(from, sizeof(from), COPY_MIN_BYTES << row);
+        format_size(to, sizeof(to), COPY_MIN_BYTES << end);
+        printf(" %s %s%s%s%s", strategies[best[row]].name, from, end > row ? "-" : "", end > row ? to : "",
+               end + 1 < rows ? "," : "");
+        row = end + 1;
+    }
+    printf("\r\n");
+}
+
+//one table of copy or fill bandwidth in GB/s for all sizes, best[] receives the fastest strategy per size
+//returns the number of rows measured or -1 on failure
+static int copy_table(const struct bench_env *env, const struct copy_strategy *strategies, size_t strategy_cnt,
+                      bool fill, bool misaligned, uint8_t *dst, const uint8_t *src, size_t *best) {
+    struct copy_ctx ctx;
+    struct measure_result result;
+    char size[32];
+    uint32_t rows = 0;
+
+    printf("%s, %s, GB/s:\r\n%10s", fill ? "Fill" : "Copy", misaligned ? "misaligned" : "aligned", "size");
+    for(size_t k=0; k<strategy_cnt; k++) {
+        printf("%*s", COLUMN_WIDTH, strategies[k].name);
+    }
+    printf("%*s\r\n", COLUMN_WIDTH, "best");
+
+    ctx.dst = misaligned ? dst + COPY_DST_MISALIGN : dst;
+    ctx.src = misaligned ? src + COPY_SRC_MISALIGN : src;
+    for(size_t bytes=COPY_MIN_BYTES; bytes<=COPY_MAX_BYTES; bytes*=2, rows++) {
+        double rates[strategy_cnt];
+        double best_rate = 0.0;
+        best[rows] = 0;
+        printf("%10s", format_size(size, sizeof(size), bytes));
+        for(size_t k=0; k<strategy_cnt; k++) {
+            rates[k] = 0.0;
+            if(!strategies[k].supported) {
+                printf("%*s", COLUMN_WIDTH, "-");
+                continue;
+            }
+            ctx.strategy = &strategies[k];
+            ctx.bytes = bytes;
+            ctx.reps = bytes < COPY_SAMPLE_BYTES ? (uint32_t) (COPY_SAMPLE_BYTES / bytes) : 1;
+            struct measure_kernel kernel = {NULL, fill ? fill_run : copy_run, &ctx, ctx.reps};
+            if(measure_run(&kernel, env->config, &result) != 0) {
+                printf("\r\n");
+                return -1;
+            }
+            double rate = rates[k] = bytes / result.median;
+            if(rate > best_rate) {
+                best_rate = rate;
+                best[rows] = k;
+            }
+            printf("%*.2f", COLUMN_WIDTH, rate);
+        }
+        //keeps measurement noise from showing up as crossovers
+        if(rows > 0 && rates[best[rows - 1]] >= best_rate * (1.0 - TIE_TOLERANCE)) {
+            best[rows] = best[rows - 1];
+        }
+        printf("%*s\r\n", COLUMN_WIDTH, strategies[best[rows]].name);
+        fflush(stdout);
+    }
+    return (int) rows;
+}
+
+//copy and fill bandwidth of every strategy from COPY_MIN_BYTES to COPY_MAX_BYTES, aligned and
+//misaligned, followed by the size ranges in which each strategy wins
+int copy_suite(const struct bench_env *env) {
+    const struct cpu_info *info = env->cpu_info;
+    const struct copy_strategy strategies[] = {
+        {"glibc", copy_glibc, fill_glibc, true},
+        {"rep", copy_rep_movsb, fill_rep_stosb, true},
+        {"sse2", copy_sse2, fill_sse2, true},
+        {"avx2", copy_avx2, fill_avx2, dispatch_supported(info, REQUIRES(ISA(AVX2)))},
+        {"avx512", copy_avx512, fill_avx512, dispatch_supported(info, REQUIRES(ISA(AVX512F), ISA(AVX512BW)))},
+        {"nt-sse2", copy_sse2_nt, fill_sse2_nt, true},
+    };
+    struct copy_strategy checked[STRATEGY_CNT];
+    size_t best[4][SIZE_CNT];
+    int rows[4];
+
+    //one extra cache line on both buffers leaves room for the misaligned start
+    const uint8_t *src = (const uint8_t *) corpus_u64(env->corpus, (COPY_MAX_BYTES + CORPUS_ALIGNMENT) / sizeof(uint64_t));
+    uint8_t *dst = arena_alloc(&env->corpus->arena, COPY_MAX_BYTES + CORPUS_ALIGNMENT);
+    if(src == NULL || dst == NULL) {
+        printf("Not enough memory for %zu MiB buffers\r\n", COPY_MAX_BYTES >> 20);
+        return -1;
+    }
+    memset(dst, 0, COPY_MAX_BYTES + CORPUS_ALIGNMENT); //commit the pages before timing
+
+    for(size_t k=0; k<STRATEGY_CNT; k++) {
+        checked[k] = strategies[k];
+        if(checked[k].supported) {
+            checked[k].supported = copy_verify(&checked[k], dst, src);
+        }
+    }
+    printf("rep = rep movsb / rep stosb (ERMS %s, FSRM %s), nt = non-temporal stores\r\n",
+           info->ERMS ? "yes" : "no", info->FSRM ? "yes" : "no");
+
+    for(int table=0; table<4; table++) {
+        rows[table] = copy_table(env, checked, STRATEGY_CNT, table >= 2, table & 1, dst, src, best[table]);
+        if(rows[table] < 0) {
+            return -1;
+        }
+    }
+    print_crossovers("Fastest copy, aligned", checked, best[0], (uint32_t) rows[0]);
+    print_crossovers("Fastest copy, misaligned", checked, best[1], (uint32_t) rows[1]);
+    print_crossovers("Fastest fill, aligned", checked, best[2], (uint32_t) rows[2]);
+    print_crossovers("Fastest fill, misaligned", checked, best[3], (uint32_t) rows[3]);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef COPY
+#define COPY
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define COPY_MIN_BYTES ((size_t) 8)
+#define COPY_MAX_BYTES ((size_t) 1 << 30)
+#define COPY_SAMPLE_BYTES ((size_t) 64 << 10) //small sizes are repeated until a sample moves at least this much
+#define COPY_SRC_MISALIGN 1 //offsets from a cache line for the misaligned tables, different on purpose
+#define COPY_DST_MISALIGN 3 //so source and destination are not aligned relative to each other either
+
+//one way to move or fill memory, both functions have memcpy/memset semantics
+struct copy_strategy {
+    const char *name;
+    void (*copy)(void *dst, const void *src, size_t n);
+    void (*fill)(void *dst, int c, size_t n);
+    bool supported;
+};
+
+//timed region of one sample: reps copies (or fills) of bytes
+struct copy_ctx {
+    const struct copy_strategy *strategy;
+    uint8_t *dst;
+    const uint8_t *src;
+    size_t bytes;
+    uint32_t reps;
+};
+
+//copies below the vector width, overlapping fixed size moves instead of a byte loop
+static inline void copy_small(uint8_t *dst, const uint8_t *src, size_t n) {
+    if(n >= 8) {
+        uint64_t head, tail;
+        memcpy(&head, src, 8);
+        memcpy(&tail, src + n - 8, 8);
+        memcpy(dst, &head, 8);
+        memcpy(dst + n - 8, &tail, 8);
+    } else if(n >= 4) {
+        uint32_t head, tail;
+        memcpy(&head, src, 4);
+        memcpy(&tail, src + n - 4, 4);
+        memcpy(dst, &head, 4);
+        memcpy(dst + n - 4, &tail, 4);
+    } else {
+        for(size_t i=0; i<n; i++) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+static inline void fill_small(uint8_t *dst, int c, size_t n) {
+    const uint64_t pattern = (uint8_t) c * 0x0101010101010101ull;
+    if(n >= 8) {
+        memcpy(dst, &pattern, 8);
+        memcpy(dst + n - 8, &pattern, 8);
+    } else if(n >= 4) {
+        memcpy(dst, &pattern, 4);
+        memcpy(dst + n - 4, &pattern, 4);
+    } else {
+        for(size_t i=0; i<n; i++) {
+            dst[i] = (uint8_t) c;
+        }
+    }
+}
+
+void copy_rep_movsb(void *dst, const void *src, size_t n);
+void fill_rep_stosb(void *dst, int c, size_t n);
+void copy_sse2(void *dst, const void *src, size_t n);
+void fill_sse2(void *dst, int c, size_t n);
+void copy_sse2_nt(void *dst, const void *src, size_t n);
+void fill_sse2_nt(void *dst, int c, size_t n);
+void copy_avx2(void *dst, const void *src, size_t n);
+void fill_avx2(void *dst, int c, size_t n);
+void copy_avx512(void *dst, const void *src, size_t n);
+void fill_avx512(void *dst, int c, size_t n);
+
+//ERMS registry entry: rep movsb, the SSE2 copy as emulation
+struct bench_env;
+void *copy_setup(const struct bench_env *env, uint64_t *ops);
+void erms_run(void *ctx);
+void erms_run_emulated(void *ctx);
+int copy_suite(const struct bench_env *env);
+
+#endif
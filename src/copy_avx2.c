@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AVX2 copy and fill loops, this translation unit is compiled for AVX2
+//nothing in here may be called unless dispatch_supported() confirmed it
+#pragma GCC target("avx2")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "copy.h"
+
+#define VECTOR_BYTES 32
+
+void copy_avx2(void *dst_arg, const void *src_arg, size_t n) {
+    uint8_t *dst = dst_arg;
+    const uint8_t *src = src_arg;
+    size_t i = 0;
+
+    if(n < VECTOR_BYTES) {
+        if(n >= 16) {
+            __m128i head = _mm_loadu_si128((const __m128i *) src);
+            __m128i tail = _mm_loadu_si128((const __m128i *) (src + n - 16));
+            _mm_storeu_si128((__m128i *) dst, head);
+            _mm_storeu_si128((__m128i *) (dst + n - 16), tail);
+        } else {
+            copy_small(dst, src, n);
+        }
+        return;
+    }
+    for(; i + 4 * VECTOR_BYTES <= n; i += 4 * VECTOR_BYTES) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *) (src + i + VECTOR_BYTES));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *) (src + i + 2 * VECTOR_BYTES));
+        __m256i v3 = _mm256_loadu_si256((const __m256i *) (src + i + 3 * VECTOR_BYTES));
+        _mm256_storeu_si256((__m256i *) (dst + i), v0);
+        _mm256_storeu_si256((__m256i *) (dst + i + VECTOR_BYTES), v1);
+        _mm256_storeu_si256((__m256i *) (dst + i + 2 * VECTOR_BYTES), v2);
+        _mm256_storeu_si256((__m256i *) (dst + i + 3 * VECTOR_BYTES), v3);
+    }
+    for(; i + VECTOR_BYTES <= n; i += VECTOR_BYTES) {
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_loadu_si256((const __m256i *) (src + i)));
+    }
+    //the last vector overlaps the previous one instead of falling back to smaller moves
+    if(i < n) {
+        _mm256_storeu_si256((__m256i *) (dst + n - VECTOR_BYTES),
+                            _mm256_loadu_si256((const __m256i *) (src + n - VECTOR_BYTES)));
+    }
+    _mm256_zeroupper();
+}
+
+void fill_avx2(void *dst_arg, int c, size_t n) {
+    uint8_t *dst = dst_arg;
+    const __m256i val = _mm256_set1_epi8((char) c);
+    size_t i = 0;
+
+    if(n < VECTOR_BYTES) {
+        if(n >= 16) {
+            _mm_storeu_si128((__m128i *) dst, _mm256_castsi256_si128(val));
+            _mm_storeu_si128((__m128i *) (dst + n - 16), _mm256_castsi256_si128(val));
+        } else {
+            fill_small(dst, c, n);
+        }
+        return;
+    }
+    for(; i + 4 * VECTOR_BYTES <= n; i += 4 * VECTOR_BYTES) {
+        _mm256_storeu_si256((__m256i *) (dst + i), val);
+        _mm256_storeu_si256((__m256i *) (dst + i + VECTOR_BYTES), val);
+        _mm256_storeu_si256((__m256i *) (dst + i + 2 * VECTOR_BYTES), val);
+        _mm256_storeu_si256((__m256i *) (dst + i + 3 * VECTOR_BYTES), val);
+    }
+    for(; i + VECTOR_BYTES <= n; i += VECTOR_BYTES) {
+        _mm256_storeu_si256((__m256i *) (dst + i), val);
+    }
+    if(i < n) {
+        _mm256_storeu_si256((__m256i *) (dst + n - VECTOR_BYTES), val);
+    }
+    _mm256_zeroupper();
+}
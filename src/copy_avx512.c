@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AVX-512 copy and fill loops, this translation unit is compiled for AVX512F and AVX512BW
+//nothing in here may be called unless dispatch_supported() confirmed both
+#pragma GCC target("avx512f,avx512bw")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "copy.h"
+
+#define VECTOR_BYTES 64
+
+//byte mask selecting the first n (< 64) bytes of a vector
+static inline __mmask64 tail_mask(size_t n) {
+    return ((__mmask64) 1 << n) - 1;
+}
+
+//short copies and the tail use masked byte moves, which never touch memory past the buffer
+void copy_avx512(void *dst_arg, const void *src_arg, size_t n) {
+    uint8_t *dst = dst_arg;
+    const uint8_t *src = src_arg;
+    size_t i = 0;
+
+    for(; i + 4 * VECTOR_BYTES <= n; i += 4 * VECTOR_BYTES) {
+        __m512i v0 = _mm512_loadu_si512(src + i);
+        __m512i v1 = _mm512_loadu_si512(src + i + VECTOR_BYTES);
+        __m512i v2 = _mm512_loadu_si512(src + i + 2 * VECTOR_BYTES);
+        __m512i v3 = _mm512_loadu_si512(src + i + 3 * VECTOR_BYTES);
+        _mm512_storeu_si512(dst + i, v0);
+        _mm512_storeu_si512(dst + i + VECTOR_BYTES, v1);
+        _mm512_storeu_si512(dst + i + 2 * VECTOR_BYTES, v2);
+        _mm512_storeu_si512(dst + i + 3 * VECTOR_BYTES, v3);
+    }
+    for(; i + VECTOR_BYTES <= n; i += VECTOR_BYTES) {
+        _mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+    }
+    if(i < n) {
+        __mmask64 mask = tail_mask(n - i);
+        _mm512_mask_storeu_epi8(dst + i, mask, _mm512_maskz_loadu_epi8(mask, src + i));
+    }
+    _mm256_zeroupper();
+}
+
+void fill_avx512(void *dst_arg, int c, size_t n) {
+    uint8_t *dst = dst_arg;
+    const __m512i val = _mm512_set1_epi8((char) c);
+    size_t i = 0;
+
+    for(; i + 4 * VECTOR_BYTES <= n; i += 4 * VECTOR_BYTES) {
+        _mm512_storeu_si512(dst + i, val);
+        _mm512_storeu_si512(dst + i + VECTOR_BYTES, val);
+        _mm512_storeu_si512(dst + i + 2 * VECTOR_BYTES, val);
+        _mm512_storeu_si512(dst + i + 3 * VECTOR_BYTES, val);
+    }
+    for(; i + VECTOR_BYTES <= n; i += VECTOR_BYTES) {
+        _mm512_storeu_si512(dst + i, val);
+    }
+    if(i < n) {
+        _mm512_mask_storeu_epi8(dst + i, tail_mask(n - i), val);
+    }
+    _mm256_zeroupper();
+}
@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include "corpus.h"
+
+//***********************************************
+//*********************PRNG**********************
+//***********************************************
+
+//expands a single seed into the xoshiro state with splitmix64 (never yields the all zero state)
+void rng_seed(struct rng *rng, uint64_t seed) {
+    for(int i=0; i<4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+//***********************************************
+//*********************ARENA*********************
+//***********************************************
+
+//reserves size bytes of address space, returns 0 on success and -1 on failure
+int arena_init(struct arena *arena, size_t size) {
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(base == MAP_FAILED) {
+        arena->base = NULL;
+        return -1;
+    }
+    arena->base = base;
+    arena->size = size;
+    arena->used = 0;
+    return 0;
+}
+
+//returns CORPUS_ALIGNMENT aligned memory or NULL if the arena is exhausted
+void *arena_alloc(struct arena *arena, size_t size) {
+    size_t offset = (arena->used + CORPUS_ALIGNMENT - 1) & ~(size_t) (CORPUS_ALIGNMENT - 1);
+    if(offset > arena->size || size > arena->size - offset) {
+        return NULL;
+    }
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+void arena_free(struct arena *arena) {
+    if(arena->base != NULL) {
+        munmap(arena->base, arena->size);
+        arena->base = NULL;
+    }
+}
+
+//***********************************************
+//********************CORPUS*********************
+//***********************************************
+
+int corpus_init(struct corpus *corpus, uint64_t seed, size_t size) {
+    corpus->seed = seed;
+    rng_seed(&corpus->rng, seed);
+    return arena_init(&corpus->arena, size);
+}
+
+//releases all inputs and restarts the generator, so every bench sees the same data regardless of order
+void corpus_reset(struct corpus *corpus) {
+    corpus->arena.used = 0;
+    rng_seed(&corpus->rng, corpus->seed);
+}
+
+void corpus_free(struct corpus *corpus) {
+    arena_free(&corpus->arena);
+}
+
+//cnt uniformly distributed operands using all 64 bits
+uint64_t *corpus_u64(struct corpus *corpus, size_t cnt) {
+    uint64_t *dst = arena_alloc(&corpus->arena, cnt * sizeof(*dst));
+    if(dst == NULL) {
+        return NULL;
+    }
+    for(size_t i=0; i<cnt; i++) {
+        dst[i] = rng_next(&corpus->rng);
+    }
+    return dst;
+}
+
+//cnt operands with exactly bits (0..64) randomly placed set bits
+uint64_t *corpus_masks(struct corpus *corpus, size_t cnt, uint32_t bits) {
+    uint64_t *dst = arena_alloc(&corpus->arena, cnt * sizeof(*dst));
+    if(dst == NULL || bits > 64) {
+        return NULL;
+    }
+    for(size_t i=0; i<cnt; i++) {
+        uint64_t mask = bits > 32 ? ~(uint64_t) 0 : 0;
+        uint32_t flips = bits > 32 ? 64 - bits : bits;
+        //flipping the smaller side keeps the expected number of retries below 2 per bit
+        for(uint32_t k=0; k<flips; ) {
+            uint64_t bit = (uint64_t) 1 << rng_below(&corpus->rng, 64);
+            if(((mask & bit) != 0) == (bits > 32)) {
+                mask ^= bit;
+                k++;
+            }
+        }
+        dst[i] = mask;
+    }
+    return dst;
+}
+
+//cnt NUL terminated decimal strings of exactly len digits (no leading zero), stored len + 1 bytes apart
+char *corpus_digits(struct corpus *corpus, size_t cnt, size_t len) {
+    char *dst = arena_alloc(&corpus->arena, cnt * (len + 1));
+    if(dst == NULL || len == 0) {
+        return NULL;
+    }
+    for(size_t i=0; i<cnt; i++) {
+        char *str = dst + i * (len + 1);
+        str[0] = (char) ('1' + rng_below(&corpus->rng, 9));
+        for(size_t k=1; k<len; k++) {
+            str[k] = (char) ('0' + rng_below(&corpus->rng, 10));
+        }
+        str[len] = '\0';
+    }
+    return dst;
+}
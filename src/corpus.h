@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef CORPUS
+#define CORPUS
+#include <stdint.h>
+#include <stddef.h>
+
+#define CORPUS_ALIGNMENT 64 //every allocation starts on its own cache line
+#define CORPUS_DEFAULT_SEED 0x5eedc0ffee15bad5ull
+
+//xoshiro256** state
+struct rng {
+    uint64_t s[4];
+};
+
+//bump allocator over one mmap'd region, pages are only committed once they are touched
+struct arena {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+};
+
+//all benchmark input comes from here, so a run is fully determined by its seed
+struct corpus {
+    struct arena arena;
+    struct rng rng;
+    uint64_t seed;
+};
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(struct rng *rng) {
+    uint64_t *s = rng->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+//returns a value in [0, bound) without modulo bias worth mentioning for small bounds
+static inline uint64_t rng_below(struct rng *rng, uint64_t bound) {
+    return (uint64_t) (((unsigned __int128) rng_next(rng) * bound) >> 64);
+}
+
+void rng_seed(struct rng *rng, uint64_t seed);
+
+int arena_init(struct arena *arena, size_t size);
+void *arena_alloc(struct arena *arena, size_t size);
+void arena_free(struct arena *arena);
+
+int corpus_init(struct corpus *corpus, uint64_t seed, size_t size);
+void corpus_reset(struct corpus *corpus);
+void corpus_free(struct corpus *corpus);
+uint64_t *corpus_u64(struct corpus *corpus, size_t cnt);
+uint64_t *corpus_masks(struct corpus *corpus, size_t cnt, uint32_t bits);
+char *corpus_digits(struct corpus *corpus, size_t cnt, size_t len);
+
+#endif
@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//hardware performance counters for the timed region of a benchmark. All events form one group that
+//is enabled and disabled with a single ioctl and read with a single read(), so collecting them costs
+//two syscalls per sample outside of the timed region. Only user space is counted, which
+//perf_event_paranoid up to 2 allows without privileges.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <cpuid.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "counters.h"
+
+#define CACHE_EVENT(cache, op, result) \
+    ((cache) | ((uint64_t) (op) << 8) | ((uint64_t) (result) << 16))
+#define INTEL_UOPS_ISSUED 0x010e //UOPS_ISSUED.ANY, Nehalem to Sapphire Rapids
+#define AMD_UOPS_RETIRED 0x00c1  //retired micro-ops, family 17h and later
+
+struct counter_desc {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+static struct counter_desc descs[COUNTER_CNT] = {
+    [COUNTER_CYCLES]        = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [COUNTER_INSTRUCTIONS]  = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [COUNTER_BRANCH_MISSES] = {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    [COUNTER_L1D_MISSES]    = {"L1D-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D,
+                               PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    [COUNTER_LLC_MISSES]    = {"LLC-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_LL,
+                               PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    [COUNTER_DTLB_MISSES]   = {"dTLB-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB,
+                               PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    [COUNTER_UOPS]          = {"uops", PERF_TYPE_RAW, 0}, //filled in by uops_event()
+};
+
+static long perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd, unsigned long flags) {
+    return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+//there is no generic micro-op event, returns the raw event of the vendor or 0 if it is unknown
+static uint64_t uops_event(void) {
+    uint32_t values[4];
+    char vendor[13];
+    __cpuid(0, values[0], values[1], values[2], values[3]);
+    memcpy(vendor, &values[1], 4);
+    memcpy(vendor + 4, &values[3], 4);
+    memcpy(vendor + 8, &values[2], 4);
+    vendor[12] = '\0';
+    if(strcmp(vendor, "GenuineIntel") == 0) {
+        return INTEL_UOPS_ISSUED;
+    }
+    if(strcmp(vendor, "AuthenticAMD") == 0 || strcmp(vendor, "HygonGenuine") == 0) {
+        return AMD_UOPS_RETIRED;
+    }
+    return 0;
+}
+
+static bool hypervisor_present(void) {
+    uint32_t values[4];
+    return __get_cpuid(1, &values[0], &values[1], &values[2], &values[3]) && (values[2] & ((uint32_t) 1 << 31));
+}
+
+static int paranoid_level(void) {
+    int level = -100;
+    FILE *file = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if(file != NULL) {
+        if(fscanf(file, "%d", &level) != 1) {
+            level = -100;
+        }
+        fclose(file);
+    }
+    return level;
+}
+
+//explains why the kernel refused the group leader
+static void describe_error(struct counters *counters, int error) {
+    if(error == EACCES || error == EPERM) {
+        snprintf(counters->reason, sizeof(counters->reason), "not permitted, perf_event_paranoid is %d",
+                 paranoid_level());
+    } else if(error == ENOENT || error == ENODEV || error == EOPNOTSUPP) {
+        snprintf(counters->reason, sizeof(counters->reason), "no hardware PMU%s",
+                 hypervisor_present() ? ", the hypervisor does not expose one" : "");
+    } else {
+        snprintf(counters->reason, sizeof(counters->reason), "perf_event_open failed: %s", strerror(error));
+    }
+}
+
+//the kernel accepts groups the PMU can never schedule as a whole (more events than counters), such a
+//group just never runs; this enables it around a short loop and checks that it ran
+static bool group_runs(const struct counters *counters) {
+    struct counter_values values;
+    volatile uint32_t spin = 0;
+    counters_reset(counters);
+    counters_start(counters);
+    for(uint32_t i=0; i<100000; i++) {
+        spin = spin + i;
+    }
+    counters_stop(counters);
+    return counters_read(counters, &values) == 0;
+}
+
+//opens as many events as the kernel and the PMU allow, returns -1 if not even cycles can be counted
+int counters_open(struct counters *counters) {
+    int leader = -1;
+    counters->open = 0;
+    counters->reason[0] = '\0';
+    descs[COUNTER_UOPS].config = uops_event();
+    for(uint32_t e=0; e<COUNTER_CNT; e++) {
+        counters->fds[e] = -1;
+    }
+
+    for(uint32_t e=0; e<COUNTER_CNT; e++) {
+        struct perf_event_attr attr;
+        if(descs[e].type == PERF_TYPE_RAW && descs[e].config == 0) {
+            continue;
+        }
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = descs[e].type;
+        attr.config = descs[e].config;
+        attr.disabled = leader < 0; //members follow the leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = (int) perf_event_open(&attr, 0, -1, leader, 0);
+        if(fd < 0) {
+            if(leader < 0) {
+                describe_error(counters, errno);
+                return -1;
+            }
+            continue;
+        }
+        leader = leader < 0 ? fd : leader;
+        counters->fds[e] = fd;
+        counters->open++;
+    }
+
+    //drop events from the end until the PMU can schedule the group
+    for(int e=COUNTER_CNT-1; e>0 && !group_runs(counters); e--) {
+        if(counters->fds[e] >= 0) {
+            close(counters->fds[e]);
+            counters->fds[e] = -1;
+            counters->open--;
+        }
+    }
+    if(!group_runs(counters)) {
+        snprintf(counters->reason, sizeof(counters->reason), "the PMU does not schedule the cycle counter");
+        counters_close(counters);
+        return -1;
+    }
+    if(counters->open < COUNTER_CNT) {
+        snprintf(counters->reason, sizeof(counters->reason), "events the kernel or PMU refused are left out");
+    }
+    return 0;
+}
+
+void counters_close(struct counters *counters) {
+    //members first, closing the leader would turn them into singletons
+    for(int e=COUNTER_CNT-1; e>=0; e--) {
+        if(counters->fds[e] >= 0) {
+            close(counters->fds[e]);
+            counters->fds[e] = -1;
+        }
+    }
+    counters->open = 0;
+}
+
+void counters_reset(const struct counters *counters) {
+    ioctl(counters->fds[COUNTER_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+}
+
+void counters_start(const struct counters *counters) {
+    ioctl(counters->fds[COUNTER_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void counters_stop(const struct counters *counters) {
+    ioctl(counters->fds[COUNTER_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+//reads the whole group at once, returns -1 if the read failed or the group never ran;
+//values->ops is left to the caller
+int counters_read(const struct counters *counters, struct counter_values *values) {
+    uint64_t buffer[3 + COUNTER_CNT];
+    ssize_t size = read(counters->fds[COUNTER_CYCLES], buffer, sizeof(buffer));
+    if(size < (ssize_t) (3 * sizeof(uint64_t)) || buffer[0] != counters->open || buffer[2] == 0) {
+        return -1;
+    }
+    //the group is read in the order the events joined it
+    values->scale = (double) buffer[1] / (double) buffer[2];
+    uint32_t slot = 0;
+    for(uint32_t e=0; e<COUNTER_CNT; e++) {
+        values->valid[e] = counters->fds[e] >= 0;
+        values->count[e] = values->valid[e] ? (double) buffer[3 + slot++] * values->scale : 0.0;
+    }
+    return 0;
+}
+
+const char *counters_name(enum counter_event event) {
+    return descs[event].name;
+}
+
+//prints which events are counted and why the others are not
+void counters_describe(const struct counters *counters) {
+    printf("Counters:");
+    for(uint32_t e=0; e<COUNTER_CNT; e++) {
+        if(counters->fds[e] >= 0) {
+            printf(" %s", descs[e].name);
+        }
+    }
+    printf("%s%s\r\n", counters->reason[0] ? " - " : "", counters->reason);
+}
+
+//one line of per operation values below the timing of a benchmark
+void counters_print(const struct counter_values *values) {
+    const double ops = values->ops ? (double) values->ops : 1.0;
+    printf("    per op:");
+    for(uint32_t e=0; e<COUNTER_CNT; e++) {
+        if(values->valid[e]) {
+            printf(" %s %.3f", descs[e].name, values->count[e] / ops);
+        }
+    }
+    if(values->valid[COUNTER_INSTRUCTIONS] && values->count[COUNTER_CYCLES] > 0.0) {
+        printf(", IPC %.2f", values->count[COUNTER_INSTRUCTIONS] / values->count[COUNTER_CYCLES]);
+    }
+    if(values->scale > 1.01) {
+        printf(" (multiplexed, scaled by %.2f)", values->scale);
+    }
+    printf("\r\n");
+}
@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef COUNTERS
+#define COUNTERS
+#include <stdint.h>
+#include <stdbool.h>
+
+//events in the order they join the group, cycles leads it; if the PMU can not schedule all of them
+//at once, events are dropped from the end of this list
+enum counter_event {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_DTLB_MISSES,
+    COUNTER_UOPS,
+    COUNTER_CNT
+};
+
+//one perf_event_open group counting user space of the calling thread
+struct counters {
+    int fds[COUNTER_CNT];   //-1 if the event is not part of the group
+    uint32_t open;          //events in the group
+    char reason[96];        //why events are missing, empty if the group is complete
+};
+
+//counts accumulated by one measure_run(), scaled up if the kernel multiplexed the group
+struct counter_values {
+    bool valid[COUNTER_CNT];
+    double count[COUNTER_CNT];
+    double scale;           //time enabled / time running, 1.0 if the group was on the PMU the whole time
+    uint64_t ops;           //operations executed while counting
+};
+
+int counters_open(struct counters *counters);
+void counters_close(struct counters *counters);
+void counters_reset(const struct counters *counters);
+void counters_start(const struct counters *counters);
+void counters_stop(const struct counters *counters);
+int counters_read(const struct counters *counters, struct counter_values *values);
+const char *counters_name(enum counter_event event);
+void counters_describe(const struct counters *counters);
+void counters_print(const struct counter_values *values);
+
+#endif
@@ -10,13 +10,114 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <cpuid.h>
 #include "cpuinfo.h"
 
+#define XCR0_AVX    0x06 //SSE and AVX state
+#define XCR0_AVX512 0xe6 //SSE, AVX, opmask and both halves of the ZMM state
+
+#define FLAG(name) {#name, offsetof(struct cpu_info, name)}
+
+//every feature flag by name, used by the structured output
+const struct cpu_flag cpu_flags[] = {
+    FLAG(HYP_THR), FLAG(X64), FLAG(FPU), FLAG(PCMULQDQ), FLAG(CX8), FLAG(CX16), FLAG(MOVBE), FLAG(POPCNT),
+    FLAG(FCMOV), FLAG(ERMS), FLAG(INVPCID), FLAG(RDSEED), FLAG(PCOMMIT), FLAG(CLFLUSHOPT), FLAG(CLWB),
+    FLAG(SYSCALL), FLAG(SKINIT), FLAG(CMOV), FLAG(SMX), FLAG(FMA3), FLAG(FMA4), FLAG(AES), FLAG(XSAVE),
+    FLAG(F16), FLAG(RDRAND), FLAG(FXSR), FLAG(ABM), FLAG(BMI1), FLAG(BMI2), FLAG(CLMUL), FLAG(MMX), FLAG(AVX),
+    FLAG(AVX2), FLAG(AVX512F), FLAG(AVX512VL), FLAG(AVX512BW), FLAG(AVX512CD), FLAG(AVX512DQ), FLAG(AVX512ER),
+    FLAG(AVX512PF), FLAG(AVX512VNNI), FLAG(AVX512VBMI), FLAG(AVX512IFMA), FLAG(AVX512VBMI2),
+    FLAG(AVX5124FMAPS), FLAG(AVX512BITALG), FLAG(AVX5124VNNIW), FLAG(AVX512VPOPCNTDQ), FLAG(SSE), FLAG(SSE2),
+    FLAG(SSE3), FLAG(SSSE3), FLAG(SSE41), FLAG(SSE42), FLAG(SSE4a), FLAG(SGX), FLAG(TSX), FLAG(RTM),
+    FLAG(INTEL_ADX), FLAG(INTEL_MPX), FLAG(SHA), FLAG(PREFETCHWT1), FLAG(GFNI), FLAG(VAES), FLAG(VPCLMULQDQ),
+    FLAG(FSRM), FLAG(XOP), FLAG(TBM), FLAG(AMD_3DNOW), FLAG(RDTSCP), FLAG(INVARIANT_TSC),
+};
+
+const size_t cpu_flag_cnt = sizeof(cpu_flags) / sizeof(cpu_flags[0]);
+
+static uint64_t xgetbv(uint32_t index) {
+    uint32_t lo, hi;
+    __asm__ volatile ("xgetbv" :"=a"(lo), "=d"(hi) :"c"(index));
+    return ((uint64_t) hi << 32) | lo;
+}
+
+//vector extensions are only usable if the OS saves their register state, CPUID alone is not enough
+static void check_os_support(struct cpu_info *info, bool osxsave) {
+    uint64_t xcr0 = osxsave ? xgetbv(0) : 0;
+
+    if((xcr0 & XCR0_AVX) != XCR0_AVX) {
+        info->AVX = info->AVX2 = info->FMA3 = info->FMA4 = info->F16 = info->XOP = false;
+        info->VAES = info->VPCLMULQDQ = false;
+    }
+    if((xcr0 & XCR0_AVX512) != XCR0_AVX512) {
+        info->AVX512F = info->AVX512VL = info->AVX512BW = info->AVX512CD = info->AVX512DQ = false;
+        info->AVX512ER = info->AVX512PF = info->AVX512VNNI = info->AVX512VBMI = info->AVX512IFMA = false;
+        info->AVX512VBMI2 = info->AVX5124FMAPS = info->AVX512BITALG = info->AVX5124VNNIW = false;
+        info->AVX512VPOPCNTDQ = false;
+    }
+}
+
+//vendor, brand string and family/model/stepping as the OS and the vendor manuals display them
+static void read_identity(struct cpu_info *info) {
+    uint32_t values[4];
+    uint32_t max_ext = __get_cpuid_max(0x80000000, NULL);
+
+    __cpuid(0x00000000, values[0], values[1], values[2], values[3]);
+    memcpy(info->VENDOR, &values[1], 4);
+    memcpy(info->VENDOR + 4, &values[3], 4);
+    memcpy(info->VENDOR + 8, &values[2], 4);
+    info->VENDOR[12] = '\0';
+
+    __cpuid(0x00000001, values[0], values[1], values[2], values[3]);
+    info->STEPPING = values[0] & 0xf;
+    info->MODEL    = (values[0] >> 4) & 0xf;
+    info->FAMILY   = (values[0] >> 8) & 0xf;
+    if(info->FAMILY == 0xf) {
+        info->FAMILY += (values[0] >> 20) & 0xff;
+    }
+    if(info->FAMILY == 0x6 || info->FAMILY >= 0xf) {
+        info->MODEL |= ((values[0] >> 16) & 0xf) << 4;
+    }
+
+    info->BRAND[0] = '\0';
+    if(max_ext >= 0x80000004) {
+        char brand[49];
+        for(uint32_t i=0; i<3; i++) {
+            __cpuid(0x80000002 + i, values[0], values[1], values[2], values[3]);
+            memcpy(brand + 16 * i, values, 16);
+        }
+        brand[48] = '\0';
+        const char *start = brand;
+        while(*start == ' ') start++; //some vendors right align the string
+        strcpy(info->BRAND, start);
+    }
+}
+
+//the microcode revision needs a privileged MSR read, the kernel exports it in /proc/cpuinfo
+static uint64_t read_microcode(void) {
+    char line[256];
+    unsigned long long revision = 0;
+    FILE *file = fopen("/proc/cpuinfo", "r");
+    if(file == NULL) {
+        return 0;
+    }
+    while(fgets(line, sizeof(line), file) != NULL) {
+        if(strncmp(line, "microcode", 9) == 0) {
+            const char *value = strchr(line, ':');
+            revision = value ? strtoull(value + 1, NULL, 0) : 0;
+            break;
+        }
+    }
+    fclose(file);
+    return revision;
+}
+
 //returns NULL pointer on failure
 void set_cpu_info(struct cpu_info *info) {
     uint32_t values[4];
+    bool osxsave = false;
 
     if (__get_cpuid(0x00000001, &values[0], &values[1], &values[2], &values[3])){
         info->SSE3      = (values[2] & ((uint32_t)1 <<  0)) != 0;
@@ -34,6 +135,7 @@ void set_cpu_info(struct cpu_info *info) {
         info->AVX       = (values[2] & ((uint32_t)1 << 28)) != 0;
         info->F16       = (values[2] & ((uint32_t)1 << 29)) != 0;
         info->RDRAND    = (values[2] & ((uint32_t)1 << 30)) != 0;
+        osxsave         = (values[2] & ((uint32_t)1 << 27)) != 0;
         info->FPU       = (values[3] & ((uint32_t)1 <<  0)) != 0;
         info->CX8       = (values[3] & ((uint32_t)1 <<  8)) != 0;
         info->FCMOV     = (values[3] & ((uint32_t)1 << 15)) != 0;
@@ -47,7 +149,7 @@ void set_cpu_info(struct cpu_info *info) {
         return;
     }
 
-    if (__get_cpuid(0x00000007, &values[0], &values[1], &values[2], &values[3])){
+    if (__get_cpuid_count(0x00000007, 0, &values[0], &values[1], &values[2], &values[3])){
         info->SGX               = (values[1] & ((uint32_t)1 <<  2)) != 0;
         info->BMI1              = (values[1] & ((uint32_t)1 <<  3)) != 0;
         info->TSX               = (values[1] & ((uint32_t)1 <<  4)) != 0;
@@ -55,6 +157,7 @@ void set_cpu_info(struct cpu_info *info) {
         info->BMI2              = (values[1] & ((uint32_t)1 <<  8)) != 0;
         info->ERMS              = (values[1] & ((uint32_t)1 <<  9)) != 0;
         info->INVPCID           = (values[1] & ((uint32_t)1 << 10)) != 0;
+        info->RTM               = (values[1] & ((uint32_t)1 << 11)) != 0;
         info->INTEL_MPX         = (values[1] & ((uint32_t)1 << 14)) != 0;
         info->AVX512F           = (values[1] & ((uint32_t)1 << 16)) != 0;
         info->AVX512DQ          = (values[1] & ((uint32_t)1 << 17)) != 0;
@@ -79,9 +182,9 @@ void set_cpu_info(struct cpu_info *info) {
         info->AVX512VNNI        = (values[2] & ((uint32_t)1 << 11)) != 0;
         info->AVX512BITALG      = (values[2] & ((uint32_t)1 << 12)) != 0;
         info->AVX512VPOPCNTDQ   = (values[2] & ((uint32_t)1 << 14)) != 0;
-        info->AVX5124VNNIW      = (values[3] & ((uint32_t)1 << 11)) != 0;
-        info->AVX5124FMAPS      = (values[3] & ((uint32_t)1 << 11)) != 0;
-        info->FSRM              = (values[3] & ((uint32_t)1 << 11)) != 0;
+        info->AVX5124VNNIW      = (values[3] & ((uint32_t)1 <<  2)) != 0;
+        info->AVX5124FMAPS      = (values[3] & ((uint32_t)1 <<  3)) != 0;
+        info->FSRM              = (values[3] & ((uint32_t)1 <<  4)) != 0;
     }
 
     if (__get_cpuid(0x80000001, &values[0], &values[1], &values[2], &values[3])){
@@ -98,4 +201,12 @@ void set_cpu_info(struct cpu_info *info) {
         info->RDTSCP  = (values[3] & ((uint32_t)1 << 27)) != 0;
         info->X64     = (values[3] & ((uint32_t)1 << 29)) != 0;
     }
+
+    if (__get_cpuid(0x80000007, &values[0], &values[1], &values[2], &values[3])){
+        info->INVARIANT_TSC = (values[3] & ((uint32_t)1 <<  8)) != 0;
+    }
+
+    check_os_support(info, osxsave);
+    read_identity(info);
+    info->MICROCODE = read_microcode();
 }
@@ -11,11 +11,14 @@
 #ifndef CPUINFO
 #define CPUINFO
 #include <stdbool.h>
+#include <stddef.h>
+#include "topology.h"
 
 struct cpu_info {
     uint8_t BIT_VERSION; //still missing
-    uint8_t CORES_PHYSICAL; //still missing
-    uint8_t CORES_LOGICAL; //still missing
+    uint16_t CORES_PHYSICAL;
+    uint16_t CORES_LOGICAL;
+    uint16_t PACKAGES;
     bool HYP_THR;
     bool X64;
     bool FPU;
@@ -73,6 +76,7 @@ struct cpu_info {
     bool SSE4a;
     bool SGX;
     bool TSX;
+    bool RTM;
     bool INTEL_ADX;
     bool INTEL_MPX;
     bool SHA;
@@ -85,9 +89,17 @@ struct cpu_info {
     bool TBM;
     bool AMD_3DNOW;
     bool RDTSCP;
+    bool INVARIANT_TSC;
+    char VENDOR[13];    //CPUID leaf 0
+    char BRAND[49];     //CPUID leaves 0x80000002 to 0x80000004, empty if they are missing
+    uint32_t FAMILY;    //family and model include their extended fields
+    uint32_t MODEL;
+    uint32_t STEPPING;
+    uint64_t MICROCODE; //revision reported by the kernel, 0 if unknown
+    struct cpu_topology topology; //logical CPUs this process may use and the cache hierarchy, filled by set_topology()
 };
 
-//struct takes average time after MEASUREMENT_ITERATIONS
+//struct takes the median time per operation reported by measure_run in ns
 struct execution_time {
     double X64;
     double FPU;
@@ -145,6 +157,7 @@ struct execution_time {
     double SSE4a;
     double SGX;
     double TSX;
+    double RTM;
     double INTEL_ADX;
     double INTEL_MPX;
     double SHA;
@@ -159,6 +172,15 @@ struct execution_time {
     double RDTSCP;
 };
 
+//name and offsetof(struct cpu_info, ...) of every feature flag, in declaration order
+struct cpu_flag {
+    const char *name;
+    size_t offset;
+};
+
+extern const struct cpu_flag cpu_flags[];
+extern const size_t cpu_flag_cnt;
+
 void set_cpu_info(struct cpu_info *info);
 
 #endif
@@ -0,0 +1,583 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "crypto.h"
+
+#define VARIANT_CNT (sizeof(variants) / sizeof(variants[0]))
+#define CHECK_BYTES (263 * AES_BLOCK + 3) //16 + 4 + 3 blocks past the unrolled loops plus a partial block
+#define NAME_WIDTH 24
+#define COLUMN_WIDTH 12
+
+//***********************************************
+//******************AES FALLBACK*****************
+//***********************************************
+
+static uint8_t sbox[256];
+static uint32_t te[4][256]; //round tables, te[k] is te[0] rotated right by 8 * k bits
+static bool tables_ready;
+
+static inline uint8_t rotl8(uint8_t x, int k) {
+    return (uint8_t) ((x << k) | (x >> (8 - k)));
+}
+
+static inline uint8_t xtime(uint8_t x) {
+    return (uint8_t) ((x << 1) ^ ((x & 0x80) ? 0x1b : 0));
+}
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t) (v >> 24);
+    p[1] = (uint8_t) (v >> 16);
+    p[2] = (uint8_t) (v >> 8);
+    p[3] = (uint8_t) v;
+}
+
+//walks the multiplicative group with generator 3 to get the inverses, then applies the affine map
+static void aes_tables_init(void) {
+    uint8_t p = 1, q = 1;
+    do {
+        p = p ^ xtime(p);
+        q ^= (uint8_t) (q << 1);
+        q ^= (uint8_t) (q << 2);
+        q ^= (uint8_t) (q << 4);
+        if(q & 0x80) {
+            q ^= 0x09;
+        }
+        sbox[p] = (uint8_t) (q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63);
+    } while(p != 1);
+    sbox[0] = 0x63;
+
+    for(int i=0; i<256; i++) {
+        uint8_t s = sbox[i];
+        uint32_t word = ((uint32_t) xtime(s) << 24) | ((uint32_t) s << 16) | ((uint32_t) s << 8) | (uint8_t) (xtime(s) ^ s);
+        for(int k=0; k<4; k++) {
+            te[k][i] = k == 0 ? word : (word >> (8 * k)) | (word << (32 - 8 * k));
+        }
+    }
+    tables_ready = true;
+}
+
+static inline uint32_t sub_word(uint32_t w) {
+    return ((uint32_t) sbox[w >> 24] << 24) | ((uint32_t) sbox[(w >> 16) & 0xff] << 16) |
+           ((uint32_t) sbox[(w >> 8) & 0xff] << 8) | sbox[w & 0xff];
+}
+
+//FIPS-197 key expansion for 128 or 256 bit keys
+void aes_key_expand(struct aes_key *key, const uint8_t *user_key, uint32_t bits) {
+    const uint32_t nk = bits / 32;
+    uint32_t rcon = 1;
+
+    if(!tables_ready) {
+        aes_tables_init();
+    }
+    key->rounds = nk + 6;
+    for(uint32_t i=0; i<nk; i++) {
+        key->words[i] = load_be32(user_key + 4 * i);
+    }
+    for(uint32_t i=nk; i<4 * (key->rounds + 1); i++) {
+        uint32_t tmp = key->words[i - 1];
+        if(i % nk == 0) {
+            tmp = sub_word((tmp << 8) | (tmp >> 24)) ^ (rcon << 24);
+            rcon = xtime((uint8_t) rcon);
+        } else if(nk > 6 && i % nk == 4) {
+            tmp = sub_word(tmp);
+        }
+        key->words[i] = key->words[i - nk] ^ tmp;
+    }
+    for(uint32_t i=0; i<4 * (key->rounds + 1); i++) {
+        store_be32(key->rk[i / 4] + 4 * (i % 4), key->words[i]);
+    }
+}
+
+static void aes_encrypt_block(const struct aes_key *key, uint8_t *dst, const uint8_t *src) {
+    const uint32_t *rk = key->words;
+    uint32_t s0 = load_be32(src) ^ rk[0], s1 = load_be32(src + 4) ^ rk[1];
+    uint32_t s2 = load_be32(src + 8) ^ rk[2], s3 = load_be32(src + 12) ^ rk[3];
+
+    for(uint32_t r=1; r<key->rounds; r++) {
+        rk += 4;
+        uint32_t t0 = te[0][s0 >> 24] ^ te[1][(s1 >> 16) & 0xff] ^ te[2][(s2 >> 8) & 0xff] ^ te[3][s3 & 0xff] ^ rk[0];
+        uint32_t t1 = te[0][s1 >> 24] ^ te[1][(s2 >> 16) & 0xff] ^ te[2][(s3 >> 8) & 0xff] ^ te[3][s0 & 0xff] ^ rk[1];
+        uint32_t t2 = te[0][s2 >> 24] ^ te[1][(s3 >> 16) & 0xff] ^ te[2][(s0 >> 8) & 0xff] ^ te[3][s1 & 0xff] ^ rk[2];
+        uint32_t t3 = te[0][s3 >> 24] ^ te[1][(s0 >> 16) & 0xff] ^ te[2][(s1 >> 8) & 0xff] ^ te[3][s2 & 0xff] ^ rk[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    //the last round has no MixColumns
+    rk += 4;
+    store_be32(dst,      (((uint32_t) sbox[s0 >> 24] << 24) | ((uint32_t) sbox[(s1 >> 16) & 0xff] << 16) |
+                          ((uint32_t) sbox[(s2 >> 8) & 0xff] << 8) | sbox[s3 & 0xff]) ^ rk[0]);
+    store_be32(dst + 4,  (((uint32_t) sbox[s1 >> 24] << 24) | ((uint32_t) sbox[(s2 >> 16) & 0xff] << 16) |
+                          ((uint32_t) sbox[(s3 >> 8) & 0xff] << 8) | sbox[s0 & 0xff]) ^ rk[1]);
+    store_be32(dst + 8,  (((uint32_t) sbox[s2 >> 24] << 24) | ((uint32_t) sbox[(s3 >> 16) & 0xff] << 16) |
+                          ((uint32_t) sbox[(s0 >> 8) & 0xff] << 8) | sbox[s1 & 0xff]) ^ rk[2]);
+    store_be32(dst + 12, (((uint32_t) sbox[s3 >> 24] << 24) | ((uint32_t) sbox[(s0 >> 16) & 0xff] << 16) |
+                          ((uint32_t) sbox[(s1 >> 8) & 0xff] << 8) | sbox[s2 & 0xff]) ^ rk[3]);
+}
+
+void aes_ecb_soft(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks) {
+    for(size_t i=0; i<blocks; i++) {
+        aes_encrypt_block(key, dst + i * AES_BLOCK, src + i * AES_BLOCK);
+    }
+}
+
+void aes_ctr_soft(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len) {
+    uint8_t counter[AES_BLOCK], stream[AES_BLOCK];
+
+    memcpy(counter, iv, AES_BLOCK);
+    for(size_t i=0; i<len; i+=AES_BLOCK) {
+        aes_encrypt_block(key, stream, counter);
+        for(size_t k=0; k<AES_BLOCK && i + k<len; k++) {
+            dst[i + k] = src[i + k] ^ stream[k];
+        }
+        for(int k=AES_BLOCK - 1; k>=0 && ++counter[k] == 0; k--);
+    }
+}
+
+//***********************************************
+//*****************GHASH FALLBACK****************
+//***********************************************
+
+//reduction of the four bits shifted out per step (Shoup's 4 bit method)
+static const uint64_t ghash_rem[16] = {
+    0x0000ull << 48, 0x1c20ull << 48, 0x3840ull << 48, 0x2460ull << 48,
+    0x7080ull << 48, 0x6ca0ull << 48, 0x48c0ull << 48, 0x54e0ull << 48,
+    0xe100ull << 48, 0xfd20ull << 48, 0xd940ull << 48, 0xc560ull << 48,
+    0x9180ull << 48, 0x8da0ull << 48, 0xa9c0ull << 48, 0xb5e0ull << 48,
+};
+
+//table[i] = i * H for every 4 bit value i
+void ghash_init(struct ghash_key *key, const uint8_t h[AES_BLOCK]) {
+    uint64_t hi = ((uint64_t) load_be32(h) << 32) | load_be32(h + 4);
+    uint64_t lo = ((uint64_t) load_be32(h + 8) << 32) | load_be32(h + 12);
+
+    memset(key->table, 0, sizeof(key->table));
+    key->table[8][0] = hi;
+    key->table[8][1] = lo;
+    for(int i=4; i>0; i>>=1) {
+        uint64_t carry = (lo & 1) ? 0xe100000000000000ull : 0;
+        lo = (hi << 63) | (lo >> 1);
+        hi = (hi >> 1) ^ carry;
+        key->table[i][0] = hi;
+        key->table[i][1] = lo;
+    }
+    for(int i=2; i<16; i<<=1) {
+        for(int k=1; k<i; k++) {
+            key->table[i + k][0] = key->table[i][0] ^ key->table[k][0];
+            key->table[i + k][1] = key->table[i][1] ^ key->table[k][1];
+        }
+    }
+}
+
+//x = x * H, one nibble per step starting at the last byte
+static void ghash_mul_soft(const struct ghash_key *key, uint8_t x[AES_BLOCK]) {
+    uint64_t hi = 0, lo = 0;
+
+    for(int i=AES_BLOCK - 1; i>=0; i--) {
+        for(int nibble=0; nibble<2; nibble++) {
+            const uint8_t n = nibble == 0 ? x[i] & 0xf : x[i] >> 4;
+            if(i != AES_BLOCK - 1 || nibble != 0) {
+                const uint64_t rem = lo & 0xf;
+                lo = (hi << 60) | (lo >> 4);
+                hi = (hi >> 4) ^ ghash_rem[rem];
+            }
+            hi ^= key->table[n][0];
+            lo ^= key->table[n][1];
+        }
+    }
+    store_be32(x, (uint32_t) (hi >> 32));
+    store_be32(x + 4, (uint32_t) hi);
+    store_be32(x + 8, (uint32_t) (lo >> 32));
+    store_be32(x + 12, (uint32_t) lo);
+}
+
+void ghash_soft(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks) {
+    for(size_t i=0; i<blocks; i++) {
+        for(int k=0; k<AES_BLOCK; k++) {
+            x[k] ^= data[i * AES_BLOCK + k];
+        }
+        ghash_mul_soft(key, x);
+    }
+}
+
+//***********************************************
+//****************SHA-256 FALLBACK***************
+//***********************************************
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr32(uint32_t x, int k) {
+    return (x >> k) | (x << (32 - k));
+}
+
+void sha256_soft(uint32_t state[8], const uint8_t *data, size_t blocks) {
+    uint32_t w[64];
+
+    for(size_t block=0; block<blocks; block++, data+=SHA256_BLOCK) {
+        for(int i=0; i<16; i++) {
+            w[i] = load_be32(data + 4 * i);
+        }
+        for(int i=16; i<64; i++) {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for(int i=0; i<64; i++) {
+            uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+            uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+//complete hash of msg including padding, blocks does the compression
+void sha256(sha256_fn blocks, const uint8_t *msg, size_t len, uint8_t digest[32]) {
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    uint8_t last[2 * SHA256_BLOCK] = {0};
+    const size_t full = len / SHA256_BLOCK, rest = len % SHA256_BLOCK;
+    const size_t tail = rest < SHA256_BLOCK - 8 ? 1 : 2;
+
+    blocks(state, msg, full);
+    memcpy(last, msg + full * SHA256_BLOCK, rest);
+    last[rest] = 0x80;
+    store_be32(last + tail * SHA256_BLOCK - 8, (uint32_t) ((uint64_t) len >> 29));
+    store_be32(last + tail * SHA256_BLOCK - 4, (uint32_t) (len << 3));
+    blocks(state, last, tail);
+    for(int i=0; i<8; i++) {
+        store_be32(digest + 4 * i, state[i]);
+    }
+}
+
+//***********************************************
+//*******************REGISTRY********************
+//***********************************************
+
+//random AES-128 key, GHASH key H = E(K, 0) and counter from the corpus, CRYPTO_REGISTRY_BYTES message
+void *crypto_setup(const struct bench_env *env, uint64_t *ops) {
+    static const uint8_t zero[AES_BLOCK];
+    struct crypto_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    const uint64_t *key = corpus_u64(env->corpus, 4);
+    uint8_t h[AES_BLOCK];
+
+    if(ctx == NULL || key == NULL) {
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    aes_key_expand(&ctx->aes, (const uint8_t *) key, 128);
+    aes_ecb_soft(&ctx->aes, h, zero, 1);
+    ghash_init(&ctx->ghash, h);
+    if(dispatch_supported(env->cpu_info, REQUIRES(ISA(PCMULQDQ), ISA(SSSE3)))) {
+        ghash_init_clmul(&ctx->ghash, h);
+    }
+    memcpy(ctx->iv, key + 2, AES_BLOCK);
+    ctx->src = (const uint8_t *) corpus_u64(env->corpus, CRYPTO_REGISTRY_BYTES / sizeof(uint64_t));
+    ctx->dst = arena_alloc(&env->corpus->arena, CRYPTO_REGISTRY_BYTES);
+    ctx->bytes = CRYPTO_REGISTRY_BYTES;
+    ctx->reps = 1;
+    *ops = CRYPTO_REGISTRY_BYTES;
+    return ctx->src && ctx->dst ? ctx : NULL;
+}
+
+void aes_run_emulated(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    aes_ctr_soft(&ctx->aes, ctx->iv, ctx->dst, ctx->src, ctx->bytes);
+}
+
+void ghash_run_emulated(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    ghash_soft(&ctx->ghash, ctx->x, ctx->src, ctx->bytes / AES_BLOCK);
+}
+
+void sha_run_emulated(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    sha256(sha256_soft, ctx->src, ctx->bytes, ctx->digest);
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//one row of the suite, exactly one of the kernels is set
+struct crypto_variant {
+    const char *name;
+    bench_fn run;
+    aes_ecb_fn ecb;
+    aes_ctr_fn ctr;
+    ghash_fn ghash;
+    sha256_fn sha;
+    uint32_t key_bits;
+    bool supported;
+};
+
+#define ECB(name, bits, fn, ok) {name, ecb_run, fn, NULL, NULL, NULL, bits, ok}
+#define CTR(name, bits, fn, ok) {name, ctr_run, NULL, fn, NULL, NULL, bits, ok}
+#define GHASH(name, fn, ok) {name, ghash_run, NULL, NULL, fn, NULL, 0, ok}
+#define SHA256(name, fn, ok) {name, sha256_run, NULL, NULL, NULL, fn, 0, ok}
+
+static void ecb_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    const struct crypto_variant *variant = ctx->variant;
+    for(uint32_t i=0; i<ctx->reps; i++) {
+        variant->ecb(&ctx->aes, ctx->dst, ctx->src, ctx->bytes / AES_BLOCK);
+    }
+}
+
+static void ctr_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    const struct crypto_variant *variant = ctx->variant;
+    for(uint32_t i=0; i<ctx->reps; i++) {
+        variant->ctr(&ctx->aes, ctx->iv, ctx->dst, ctx->src, ctx->bytes);
+    }
+}
+
+static void ghash_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    const struct crypto_variant *variant = ctx->variant;
+    for(uint32_t i=0; i<ctx->reps; i++) {
+        variant->ghash(&ctx->ghash, ctx->x, ctx->src, ctx->bytes / AES_BLOCK);
+    }
+}
+
+static void sha256_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    const struct crypto_variant *variant = ctx->variant;
+    for(uint32_t i=0; i<ctx->reps; i++) {
+        sha256(variant->sha, ctx->src, ctx->bytes, ctx->digest);
+    }
+}
+
+//FIPS-197 C.1/C.3 (ECB), SP 800-38A F.5.1/F.5.5 (CTR), GCM spec test case 2 (GHASH), FIPS 180-2 (SHA-256)
+static const uint8_t fips_key[32] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f};
+static const uint8_t fips_plain[AES_BLOCK] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+static const uint8_t fips_cipher128[AES_BLOCK] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+static const uint8_t fips_cipher256[AES_BLOCK] = {
+    0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+
+static const uint8_t ctr_key128[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static const uint8_t ctr_key256[32] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4};
+static const uint8_t ctr_iv[AES_BLOCK] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+static const uint8_t ctr_plain[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+static const uint8_t ctr_cipher128[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee};
+static const uint8_t ctr_cipher256[64] = {
+    0x60, 0x1e, 0xc3, 0x13, 0x77, 0x57, 0x89, 0xa5, 0xb7, 0xa7, 0xf5, 0x04, 0xbb, 0xf3, 0xd2, 0x28,
+    0xf4, 0x43, 0xe3, 0xca, 0x4d, 0x62, 0xb5, 0x9a, 0xca, 0x84, 0xe9, 0x90, 0xca, 0xca, 0xf5, 0xc5,
+    0x2b, 0x09, 0x30, 0xda, 0xa2, 0x3d, 0xe9, 0x4c, 0xe8, 0x70, 0x17, 0xba, 0x2d, 0x84, 0x98, 0x8d,
+    0xdf, 0xc9, 0xc5, 0x8d, 0xb6, 0x7a, 0xad, 0xa6, 0x13, 0xc2, 0xdd, 0x08, 0x45, 0x79, 0x41, 0xa6};
+
+//H for the all zero key, ciphertext of one zero block followed by the length block, expected tag input
+static const uint8_t gcm_h[AES_BLOCK] = {
+    0x66, 0xe9, 0x4b, 0xd4, 0xef, 0x8a, 0x2c, 0x3b, 0x88, 0x4c, 0xfa, 0x59, 0xca, 0x34, 0x2b, 0x2e};
+static const uint8_t gcm_data[2 * AES_BLOCK] = {
+    0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80};
+static const uint8_t gcm_ghash[AES_BLOCK] = {
+    0xf3, 0x8c, 0xbb, 0x1a, 0xd6, 0x92, 0x23, 0xdc, 0xc3, 0x45, 0x7a, 0xe5, 0xb6, 0xb0, 0xf8, 0x85};
+
+static const char *sha_messages[] = {"", "abc", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"};
+static const uint8_t sha_digests[3][32] = {
+    {0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+     0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55},
+    {0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+     0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad},
+    {0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+     0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1},
+};
+
+//known answer test plus a comparison with the fallback over CHECK_BYTES of random input, which
+//reaches every unroll width and (for CTR) a carry out of the low half of the counter
+static bool crypto_verify(const struct crypto_variant *variant, const struct ghash_key *gcm_key,
+                          const uint8_t *input, uint8_t *out, uint8_t *expected) {
+    static const uint8_t carry_iv[AES_BLOCK] = {
+        0, 0, 0, 0, 0, 0, 0, 1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0};
+    const size_t blocks = CHECK_BYTES / AES_BLOCK;
+    struct aes_key key;
+    uint8_t x[AES_BLOCK] = {0}, y[AES_BLOCK] = {0};
+    bool ok = true;
+
+    if(variant->ecb) {
+        aes_key_expand(&key, fips_key, variant->key_bits);
+        variant->ecb(&key, out, fips_plain, 1);
+        ok = memcmp(out, variant->key_bits == 128 ? fips_cipher128 : fips_cipher256, AES_BLOCK) == 0;
+        variant->ecb(&key, out, input, blocks);
+        aes_ecb_soft(&key, expected, input, blocks);
+        ok = ok && memcmp(out, expected, blocks * AES_BLOCK) == 0;
+    } else if(variant->ctr) {
+        aes_key_expand(&key, variant->key_bits == 128 ? ctr_key128 : ctr_key256, variant->key_bits);
+        variant->ctr(&key, ctr_iv, out, ctr_plain, sizeof(ctr_plain));
+        ok = memcmp(out, variant->key_bits == 128 ? ctr_cipher128 : ctr_cipher256, sizeof(ctr_plain)) == 0;
+        variant->ctr(&key, carry_iv, out, input, CHECK_BYTES);
+        aes_ctr_soft(&key, carry_iv, expected, input, CHECK_BYTES);
+        ok = ok && memcmp(out, expected, CHECK_BYTES) == 0;
+    } else if(variant->ghash) {
+        variant->ghash(gcm_key, x, gcm_data, 2);
+        ok = memcmp(x, gcm_ghash, AES_BLOCK) == 0;
+        variant->ghash(gcm_key, x, input, blocks);
+        ghash_soft(gcm_key, y, gcm_data, 2);
+        ghash_soft(gcm_key, y, input, blocks);
+        ok = ok && memcmp(x, y, AES_BLOCK) == 0;
+    } else {
+        for(size_t i=0; i<sizeof(sha_messages) / sizeof(sha_messages[0]) && ok; i++) {
+            sha256(variant->sha, (const uint8_t *) sha_messages[i], strlen(sha_messages[i]), out);
+            ok = memcmp(out, sha_digests[i], 32) == 0;
+        }
+        sha256(variant->sha, input, CHECK_BYTES, out);
+        sha256(sha256_soft, input, CHECK_BYTES, expected);
+        ok = ok && memcmp(out, expected, 32) == 0;
+    }
+    if(!ok) {
+        printf("%s: does not match the test vectors, excluded\r\n", variant->name);
+    }
+    return ok;
+}
+
+//cycles per byte of one message of bytes, 0 on failure
+static double crypto_measure(const struct bench_env *env, struct crypto_ctx *ctx, size_t bytes) {
+    const struct crypto_variant *variant = ctx->variant;
+    struct measure_result result;
+
+    ctx->bytes = bytes;
+    ctx->reps = bytes < CRYPTO_SAMPLE_BYTES ? (uint32_t) (CRYPTO_SAMPLE_BYTES / bytes) : 1;
+    struct measure_kernel kernel = {NULL, variant->run, ctx, (uint64_t) ctx->reps * bytes};
+    if(measure_run(&kernel, env->config, &result) != 0) {
+        return 0.0;
+    }
+    return result.median * timer_info.cycles_per_ns;
+}
+
+//AES-128/256 ECB and CTR, GHASH and SHA-256 in every available implementation, verified against
+//known answers and reported in cycles per byte for a short and a bulk message
+int crypto_suite(const struct bench_env *env) {
+    const struct cpu_info *info = env->cpu_info;
+    const bool aesni = dispatch_supported(info, REQUIRES(ISA(AES), ISA(SSSE3)));
+    const bool vaes = dispatch_supported(info, REQUIRES(ISA(VAES), ISA(AES), ISA(AVX512F), ISA(AVX512BW)));
+    const bool pclmul = dispatch_supported(info, REQUIRES(ISA(PCMULQDQ), ISA(SSSE3)));
+    const bool vpclmul = dispatch_supported(info, REQUIRES(ISA(VPCLMULQDQ), ISA(PCMULQDQ), ISA(AVX512F), ISA(AVX512BW)));
+    const bool shani = dispatch_supported(info, REQUIRES(ISA(SHA), ISA(SSSE3), ISA(SSE41)));
+    struct crypto_variant variants[] = {
+        ECB("aes128-ecb-soft", 128, aes_ecb_soft, true),
+        ECB("aes128-ecb-aesni-x1", 128, aes_ecb_aesni1, aesni),
+        ECB("aes128-ecb-aesni-x4", 128, aes_ecb_aesni4, aesni),
+        ECB("aes128-ecb-aesni-x8", 128, aes_ecb_aesni8, aesni),
+        ECB("aes128-ecb-vaes-x16", 128, aes_ecb_vaes, vaes),
+        ECB("aes256-ecb-soft", 256, aes_ecb_soft, true),
+        ECB("aes256-ecb-aesni-x1", 256, aes_ecb_aesni1, aesni),
+        ECB("aes256-ecb-aesni-x4", 256, aes_ecb_aesni4, aesni),
+        ECB("aes256-ecb-aesni-x8", 256, aes_ecb_aesni8, aesni),
+        ECB("aes256-ecb-vaes-x16", 256, aes_ecb_vaes, vaes),
+        CTR("aes128-ctr-soft", 128, aes_ctr_soft, true),
+        CTR("aes128-ctr-aesni-x1", 128, aes_ctr_aesni1, aesni),
+        CTR("aes128-ctr-aesni-x4", 128, aes_ctr_aesni4, aesni),
+        CTR("aes128-ctr-aesni-x8", 128, aes_ctr_aesni8, aesni),
+        CTR("aes128-ctr-vaes-x16", 128, aes_ctr_vaes, vaes),
+        CTR("aes256-ctr-soft", 256, aes_ctr_soft, true),
+        CTR("aes256-ctr-aesni-x1", 256, aes_ctr_aesni1, aesni),
+        CTR("aes256-ctr-aesni-x4", 256, aes_ctr_aesni4, aesni),
+        CTR("aes256-ctr-aesni-x8", 256, aes_ctr_aesni8, aesni),
+        CTR("aes256-ctr-vaes-x16", 256, aes_ctr_vaes, vaes),
+        GHASH("ghash-soft", ghash_soft, true),
+        GHASH("ghash-pclmul-x1", ghash_pclmul1, pclmul),
+        GHASH("ghash-pclmul-x4", ghash_pclmul4, pclmul),
+        GHASH("ghash-vpclmul-x16", ghash_vpclmul, vpclmul),
+        SHA256("sha256-soft", sha256_soft, true),
+        SHA256("sha256-shani", sha256_shani, shani),
+    };
+    struct ghash_key *gcm_key = arena_alloc(&env->corpus->arena, sizeof(*gcm_key));
+    struct aes_key *keys = arena_alloc(&env->corpus->arena, 2 * sizeof(*keys));
+    uint8_t *expected = arena_alloc(&env->corpus->arena, CHECK_BYTES);
+    void *ctx_mem = crypto_setup(env, &(uint64_t) {0});
+    const uint8_t *key_bytes = (const uint8_t *) corpus_u64(env->corpus, 4);
+    const uint8_t *input = (const uint8_t *) corpus_u64(env->corpus, CRYPTO_BULK_BYTES / sizeof(uint64_t));
+    uint8_t *output = arena_alloc(&env->corpus->arena, CRYPTO_BULK_BYTES);
+    if(gcm_key == NULL || keys == NULL || expected == NULL || ctx_mem == NULL || key_bytes == NULL ||
+       input == NULL || output == NULL) {
+        return -1;
+    }
+    struct crypto_ctx *ctx = ctx_mem;
+
+    ghash_init(gcm_key, gcm_h);
+    if(pclmul) {
+        ghash_init_clmul(gcm_key, gcm_h);
+    }
+    for(size_t k=0; k<VARIANT_CNT; k++) {
+        if(variants[k].supported) {
+            variants[k].supported = crypto_verify(&variants[k], gcm_key, input, output, expected);
+        }
+    }
+    aes_key_expand(&keys[0], key_bytes, 128);
+    aes_key_expand(&keys[1], key_bytes, 256);
+    ctx->src = input;
+    ctx->dst = output;
+
+    printf("Crypto in cycles/byte, GB/s for the bulk message:\r\n%-*s%*zu B%*zu KiB%*s\r\n", NAME_WIDTH, "variant",
+           COLUMN_WIDTH - 2, (size_t) CRYPTO_SMALL_BYTES, COLUMN_WIDTH - 4, CRYPTO_BULK_BYTES >> 10,
+           COLUMN_WIDTH, "GB/s");
+    for(size_t k=0; k<VARIANT_CNT; k++) {
+        printf("%-*s", NAME_WIDTH, variants[k].name);
+        if(!variants[k].supported) {
+            printf("%*s%*s%*s\r\n", COLUMN_WIDTH, "-", COLUMN_WIDTH, "-", COLUMN_WIDTH, "-");
+            continue;
+        }
+        ctx->variant = &variants[k];
+        ctx->aes = keys[variants[k].key_bits == 256];
+        double small = crypto_measure(env, ctx, CRYPTO_SMALL_BYTES);
+        double bulk = crypto_measure(env, ctx, CRYPTO_BULK_BYTES);
+        if(small == 0.0 || bulk == 0.0) {
+            printf("\r\n");
+            return -1;
+        }
+        printf("%*.2f%*.2f%*.2f\r\n", COLUMN_WIDTH, small, COLUMN_WIDTH, bulk,
+               COLUMN_WIDTH, timer_info.cycles_per_ns / bulk);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef CRYPTO
+#define CRYPTO
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define AES_BLOCK 16
+#define AES_MAX_ROUNDS 14
+#define GHASH_POWERS 16          //H^1..H^16 for the aggregated carry-less multiply kernels
+#define SHA256_BLOCK 64
+#define CRYPTO_SMALL_BYTES 64    //one short TLS record fragment
+#define CRYPTO_BULK_BYTES ((size_t) 1 << 20)
+#define CRYPTO_SAMPLE_BYTES ((size_t) 16 << 10) //small messages are repeated until a sample covers this much
+#define CRYPTO_REGISTRY_BYTES 4096 //message of the per-byte registry benches
+
+//expanded AES key, the same schedule feeds the table based fallback and AES-NI/VAES
+struct aes_key {
+    uint32_t words[4 * (AES_MAX_ROUNDS + 1)];       //big endian round key words for the fallback
+    uint8_t rk[AES_MAX_ROUNDS + 1][AES_BLOCK];       //round keys in memory order for aesenc
+    uint32_t rounds;                                  //10 for AES-128, 14 for AES-256
+};
+
+//GHASH key: 4 bit tables for the fallback and byte reflected powers of H for the clmul kernels
+struct ghash_key {
+    uint64_t table[16][2];
+    uint8_t powers[GHASH_POWERS][AES_BLOCK]; //powers[i] = H^(i + 1), filled by ghash_init_clmul()
+};
+
+//ECB encrypts whole blocks, CTR any length with a 128 bit big endian counter starting at iv
+typedef void (*aes_ecb_fn)(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks);
+typedef void (*aes_ctr_fn)(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst,
+                           const uint8_t *src, size_t len);
+//folds blocks of data into the running hash x
+typedef void (*ghash_fn)(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks);
+//compresses whole 64 byte blocks into state
+typedef void (*sha256_fn)(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+void aes_key_expand(struct aes_key *key, const uint8_t *user_key, uint32_t bits);
+void ghash_init(struct ghash_key *key, const uint8_t h[AES_BLOCK]);
+void ghash_init_clmul(struct ghash_key *key, const uint8_t h[AES_BLOCK]);
+void sha256(sha256_fn blocks, const uint8_t *msg, size_t len, uint8_t digest[32]);
+
+//table based fallbacks, run everywhere
+void aes_ecb_soft(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks);
+void aes_ctr_soft(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len);
+void ghash_soft(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks);
+void sha256_soft(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+//AES-NI with 1, 4 or 8 independent blocks in flight (crypto_aesni.c, AES and SSSE3)
+void aes_ecb_aesni1(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks);
+void aes_ecb_aesni4(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks);
+void aes_ecb_aesni8(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks);
+void aes_ctr_aesni1(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len);
+void aes_ctr_aesni4(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len);
+void aes_ctr_aesni8(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len);
+
+//carry-less multiply GHASH, one block or four blocks per reduction (crypto_pclmul.c, PCLMULQDQ and SSSE3)
+void ghash_pclmul1(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks);
+void ghash_pclmul4(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks);
+
+//16 blocks per iteration in four zmm registers (crypto_vaes.c, VAES/VPCLMULQDQ with AVX512F/BW)
+void aes_ecb_vaes(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks);
+void aes_ctr_vaes(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len);
+void ghash_vpclmul(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks);
+
+//SHA-NI (crypto_sha.c, SHA, SSSE3 and SSE4.1)
+void sha256_shani(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+//input of the registry benches and the suite, the message lives in the corpus arena
+struct crypto_ctx {
+    struct aes_key aes;
+    struct ghash_key ghash;
+    uint8_t iv[AES_BLOCK];
+    uint8_t x[AES_BLOCK];   //running GHASH, keeps the result alive
+    uint8_t digest[32];
+    const uint8_t *src;
+    uint8_t *dst;
+    size_t bytes;           //message length of one run
+    uint32_t reps;          //messages per run
+    const void *variant;    //suite only: the variant being measured
+};
+
+struct bench_env;
+void *crypto_setup(const struct bench_env *env, uint64_t *ops);
+void aes_run(void *ctx);
+void aes_run_emulated(void *ctx);
+void vaes_run(void *ctx);
+void pclmulqdq_run(void *ctx);
+void vpclmulqdq_run(void *ctx);
+void ghash_run_emulated(void *ctx);
+void sha_run(void *ctx);
+void sha_run_emulated(void *ctx);
+int crypto_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AES-NI kernels, this translation unit is compiled for AES and SSSE3
+//nothing in here may be called unless dispatch_supported() confirmed both
+#pragma GCC target("aes,ssse3")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <immintrin.h>
+#include "crypto.h"
+
+#define MAX_WAYS 8
+
+//encrypts n independent blocks, interleaving hides the latency of aesenc behind the other blocks
+static inline __attribute__((always_inline)) void encrypt_blocks(const struct aes_key *key, __m128i *b, int n) {
+    const __m128i *rk = (const __m128i *) key->rk;
+    __m128i k = _mm_loadu_si128(rk);
+#pragma GCC unroll 8
+    for(int i=0; i<n; i++) {
+        b[i] = _mm_xor_si128(b[i], k);
+    }
+    for(uint32_t r=1; r<key->rounds; r++) {
+        k = _mm_loadu_si128(rk + r);
+#pragma GCC unroll 8
+        for(int i=0; i<n; i++) {
+            b[i] = _mm_aesenc_si128(b[i], k);
+        }
+    }
+    k = _mm_loadu_si128(rk + key->rounds);
+#pragma GCC unroll 8
+    for(int i=0; i<n; i++) {
+        b[i] = _mm_aesenclast_si128(b[i], k);
+    }
+}
+
+static inline __attribute__((always_inline)) void ecb_ways(const struct aes_key *key, uint8_t *dst,
+                                                           const uint8_t *src, size_t blocks, int n) {
+    __m128i b[MAX_WAYS];
+    size_t i = 0;
+
+    for(; i + n <= blocks; i += n) {
+#pragma GCC unroll 8
+        for(int k=0; k<n; k++) {
+            b[k] = _mm_loadu_si128((const __m128i *) (src + (i + k) * AES_BLOCK));
+        }
+        encrypt_blocks(key, b, n);
+#pragma GCC unroll 8
+        for(int k=0; k<n; k++) {
+            _mm_storeu_si128((__m128i *) (dst + (i + k) * AES_BLOCK), b[k]);
+        }
+    }
+    for(; i<blocks; i++) {
+        b[0] = _mm_loadu_si128((const __m128i *) (src + i * AES_BLOCK));
+        encrypt_blocks(key, b, 1);
+        _mm_storeu_si128((__m128i *) (dst + i * AES_BLOCK), b[0]);
+    }
+}
+
+//the counter is kept as two host order halves, a byte reversal turns {lo, hi} into the big endian block
+static inline __m128i counter_block(__m128i counter) {
+    return _mm_shuffle_epi8(counter, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+//next n counter blocks, the vector add is only used when the low half can not wrap
+static inline __attribute__((always_inline)) void next_counters(uint64_t *hi, uint64_t *lo, __m128i *b, int n) {
+    if(*lo <= UINT64_MAX - (uint64_t) n) {
+        const __m128i base = _mm_set_epi64x((long long) *hi, (long long) *lo);
+#pragma GCC unroll 8
+        for(int k=0; k<n; k++) {
+            b[k] = counter_block(_mm_add_epi64(base, _mm_set_epi64x(0, k)));
+        }
+        *lo += (uint64_t) n;
+        return;
+    }
+    for(int k=0; k<n; k++) {
+        b[k] = counter_block(_mm_set_epi64x((long long) *hi, (long long) *lo));
+        if(++*lo == 0) {
+            ++*hi;
+        }
+    }
+}
+
+static inline __attribute__((always_inline)) void ctr_ways(const struct aes_key *key, const uint8_t iv[AES_BLOCK],
+                                                           uint8_t *dst, const uint8_t *src, size_t len, int n) {
+    __m128i b[MAX_WAYS];
+    uint64_t hi, lo;
+    size_t i = 0;
+
+    memcpy(&hi, iv, sizeof(hi));
+    memcpy(&lo, iv + sizeof(hi), sizeof(lo));
+    hi = __builtin_bswap64(hi);
+    lo = __builtin_bswap64(lo);
+
+    for(; i + n * AES_BLOCK <= len; i += n * AES_BLOCK) {
+        next_counters(&hi, &lo, b, n);
+        encrypt_blocks(key, b, n);
+#pragma GCC unroll 8
+        for(int k=0; k<n; k++) {
+            __m128i data = _mm_loadu_si128((const __m128i *) (src + i + k * AES_BLOCK));
+            _mm_storeu_si128((__m128i *) (dst + i + k * AES_BLOCK), _mm_xor_si128(data, b[k]));
+        }
+    }
+    for(; i + AES_BLOCK <= len; i += AES_BLOCK) {
+        next_counters(&hi, &lo, b, 1);
+        encrypt_blocks(key, b, 1);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i *) (src + i)), b[0]));
+    }
+    //a partial last block uses only the first bytes of the key stream
+    if(i < len) {
+        uint8_t stream[AES_BLOCK];
+        next_counters(&hi, &lo, b, 1);
+        encrypt_blocks(key, b, 1);
+        _mm_storeu_si128((__m128i *) stream, b[0]);
+        for(size_t k=0; i + k<len; k++) {
+            dst[i + k] = src[i + k] ^ stream[k];
+        }
+    }
+}
+
+void aes_ecb_aesni1(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks) {
+    ecb_ways(key, dst, src, blocks, 1);
+}
+
+void aes_ecb_aesni4(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks) {
+    ecb_ways(key, dst, src, blocks, 4);
+}
+
+void aes_ecb_aesni8(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks) {
+    ecb_ways(key, dst, src, blocks, 8);
+}
+
+void aes_ctr_aesni1(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len) {
+    ctr_ways(key, iv, dst, src, len, 1);
+}
+
+void aes_ctr_aesni4(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len) {
+    ctr_ways(key, iv, dst, src, len, 4);
+}
+
+void aes_ctr_aesni8(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len) {
+    ctr_ways(key, iv, dst, src, len, 8);
+}
+
+void aes_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    aes_ctr_aesni8(&ctx->aes, ctx->iv, ctx->dst, ctx->src, ctx->bytes);
+}
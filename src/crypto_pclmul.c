@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//PCLMULQDQ GHASH kernels, this translation unit is compiled for PCLMULQDQ and SSSE3
+//nothing in here may be called unless dispatch_supported() confirmed both
+#pragma GCC target("pclmul,ssse3")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "crypto.h"
+#include "ghash_clmul.h"
+
+#define POWER(key, n) _mm_loadu_si128((const __m128i *) (key)->powers[(n) - 1])
+#define BLOCK(data, i) ghash_reflect(_mm_loadu_si128((const __m128i *) ((data) + (i) * AES_BLOCK)))
+
+//H^1..H^GHASH_POWERS for the aggregated kernels, ghash_init() has to be called as well for the fallback
+void ghash_init_clmul(struct ghash_key *key, const uint8_t h[AES_BLOCK]) {
+    const __m128i h1 = ghash_reflect(_mm_loadu_si128((const __m128i *) h));
+    __m128i power = h1;
+
+    _mm_storeu_si128((__m128i *) key->powers[0], h1);
+    for(int i=1; i<GHASH_POWERS; i++) {
+        power = ghash_mul(power, h1);
+        _mm_storeu_si128((__m128i *) key->powers[i], power);
+    }
+}
+
+//one multiply and reduction per block, every block waits for the previous one
+void ghash_pclmul1(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks) {
+    const __m128i h = POWER(key, 1);
+    __m128i acc = ghash_reflect(_mm_loadu_si128((const __m128i *) x));
+
+    for(size_t i=0; i<blocks; i++) {
+        acc = ghash_mul(_mm_xor_si128(acc, BLOCK(data, i)), h);
+    }
+    _mm_storeu_si128((__m128i *) x, ghash_reflect(acc));
+}
+
+//(x ^ b0) * H^4 ^ b1 * H^3 ^ b2 * H^2 ^ b3 * H: four independent multiplies and one reduction per 64 bytes
+void ghash_pclmul4(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks) {
+    const __m128i h1 = POWER(key, 1), h2 = POWER(key, 2), h3 = POWER(key, 3), h4 = POWER(key, 4);
+    __m128i acc = ghash_reflect(_mm_loadu_si128((const __m128i *) x));
+    size_t i = 0;
+
+    for(; i + 4 <= blocks; i += 4) {
+        __m128i lo, hi, lo_k, hi_k;
+        clmul_wide(_mm_xor_si128(acc, BLOCK(data, i)), h4, &lo, &hi);
+        clmul_wide(BLOCK(data, i + 1), h3, &lo_k, &hi_k);
+        lo = _mm_xor_si128(lo, lo_k);
+        hi = _mm_xor_si128(hi, hi_k);
+        clmul_wide(BLOCK(data, i + 2), h2, &lo_k, &hi_k);
+        lo = _mm_xor_si128(lo, lo_k);
+        hi = _mm_xor_si128(hi, hi_k);
+        clmul_wide(BLOCK(data, i + 3), h1, &lo_k, &hi_k);
+        acc = ghash_reduce(_mm_xor_si128(lo, lo_k), _mm_xor_si128(hi, hi_k));
+    }
+    for(; i<blocks; i++) {
+        acc = ghash_mul(_mm_xor_si128(acc, BLOCK(data, i)), h1);
+    }
+    _mm_storeu_si128((__m128i *) x, ghash_reflect(acc));
+}
+
+void pclmulqdq_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    ghash_pclmul4(&ctx->ghash, ctx->x, ctx->src, ctx->bytes / AES_BLOCK);
+}
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//SHA-NI kernel, this translation unit is compiled for SHA, SSSE3 and SSE4.1
+//nothing in here may be called unless dispatch_supported() confirmed all of them
+#pragma GCC target("sha,ssse3,sse4.1")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "crypto.h"
+
+static const uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+//sha256rnds2 works on the state split into ABEF and CDGH, the message schedule for rounds
+//4 * i + 4.. is finished with sha256msg1/msg2 while rounds 4 * i.. are computed
+void sha256_shani(uint32_t state[8], const uint8_t *data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0xb1);         //CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (state + 4)), 0x1b); //EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                          //ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);                                               //CDGH
+
+    for(size_t block=0; block<blocks; block++, data+=SHA256_BLOCK) {
+        const __m128i abef = state0, cdgh = state1;
+        __m128i msg[4];
+
+#pragma GCC unroll 16
+        for(int i=0; i<16; i++) {
+            if(i < 4) {
+                msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16 * i)), byte_swap);
+            }
+            __m128i wk = _mm_add_epi32(msg[i % 4], _mm_loadu_si128((const __m128i *) (round_constants + 4 * i)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+            if(i >= 3 && i <= 14) {
+                __m128i next = _mm_add_epi32(msg[(i + 1) % 4], _mm_alignr_epi8(msg[i % 4], msg[(i + 3) % 4], 4));
+                msg[(i + 1) % 4] = _mm_sha256msg2_epu32(next, msg[i % 4]);
+            }
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0e));
+            if(i >= 1 && i <= 12) {
+                msg[(i + 3) % 4] = _mm_sha256msg1_epu32(msg[(i + 3) % 4], msg[i % 4]);
+            }
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);           //FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xb1);        //DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);     //DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);        //HGFE
+    _mm_storeu_si128((__m128i *) state, state0);
+    _mm_storeu_si128((__m128i *) (state + 4), state1);
+}
+
+void sha_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    sha256(sha256_shani, ctx->src, ctx->bytes, ctx->digest);
+}
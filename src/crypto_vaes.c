@@ -0,0 +1,212 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//VAES and VPCLMULQDQ kernels on zmm registers, this translation unit is compiled for VAES,
+//VPCLMULQDQ, AES, PCLMULQDQ, AVX512F and AVX512BW
+//nothing in here may be called unless dispatch_supported() confirmed all of them
+#pragma GCC target("vaes,vpclmulqdq,aes,pclmul,ssse3,avx512f,avx512bw")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <immintrin.h>
+#include "crypto.h"
+#include "ghash_clmul.h"
+
+#define LANES 4 //AES blocks per zmm register
+#define WAYS 4  //zmm registers in flight, 16 blocks per iteration
+#define ZMM_BYTES (LANES * AES_BLOCK)
+#define POWER(key, n) _mm_loadu_si128((const __m128i *) (key)->powers[(n) - 1])
+
+static inline __m512i reflect512(__m512i x) {
+    return _mm512_shuffle_epi8(x, _mm512_broadcast_i32x4(
+        _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+}
+
+//xor of the four 128 bit lanes
+static inline __m128i fold_lanes(__m512i x) {
+    __m256i half = _mm256_xor_si256(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+    return _mm_xor_si128(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+}
+
+//round keys broadcast to all four lanes
+static inline void load_round_keys(const struct aes_key *key, __m512i *rk) {
+    for(uint32_t r=0; r<=key->rounds; r++) {
+        rk[r] = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) key->rk[r]));
+    }
+}
+
+static inline __attribute__((always_inline)) void encrypt_zmm(const __m512i *rk, uint32_t rounds, __m512i *b, int n) {
+#pragma GCC unroll 4
+    for(int i=0; i<n; i++) {
+        b[i] = _mm512_xor_si512(b[i], rk[0]);
+    }
+    for(uint32_t r=1; r<rounds; r++) {
+#pragma GCC unroll 4
+        for(int i=0; i<n; i++) {
+            b[i] = _mm512_aesenc_epi128(b[i], rk[r]);
+        }
+    }
+#pragma GCC unroll 4
+    for(int i=0; i<n; i++) {
+        b[i] = _mm512_aesenclast_epi128(b[i], rk[rounds]);
+    }
+}
+
+//next n * LANES counter blocks, see crypto_aesni.c for the representation of the counter
+static inline __attribute__((always_inline)) void next_counters(uint64_t *hi, uint64_t *lo, __m512i *b, int n) {
+    const __m512i reverse = _mm512_broadcast_i32x4(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    if(*lo <= UINT64_MAX - (uint64_t) (n * LANES)) {
+        const __m512i base = _mm512_broadcast_i32x4(_mm_set_epi64x((long long) *hi, (long long) *lo));
+#pragma GCC unroll 4
+        for(int k=0; k<n; k++) {
+            const long long first = k * LANES;
+            b[k] = _mm512_shuffle_epi8(_mm512_add_epi64(base, _mm512_set_epi64(0, first + 3, 0, first + 2,
+                                                                                 0, first + 1, 0, first)), reverse);
+        }
+        *lo += (uint64_t) (n * LANES);
+        return;
+    }
+    for(int k=0; k<n; k++) {
+        uint64_t halves[2 * LANES];
+        for(int l=0; l<LANES; l++) {
+            halves[2 * l] = *lo;
+            halves[2 * l + 1] = *hi;
+            if(++*lo == 0) {
+                ++*hi;
+            }
+        }
+        b[k] = _mm512_shuffle_epi8(_mm512_loadu_si512(halves), reverse);
+    }
+}
+
+void aes_ecb_vaes(const struct aes_key *key, uint8_t *dst, const uint8_t *src, size_t blocks) {
+    __m512i rk[AES_MAX_ROUNDS + 1], b[WAYS];
+    const size_t bytes = blocks * AES_BLOCK;
+    size_t i = 0;
+
+    load_round_keys(key, rk);
+    for(; i + WAYS * ZMM_BYTES <= bytes; i += WAYS * ZMM_BYTES) {
+#pragma GCC unroll 4
+        for(int k=0; k<WAYS; k++) {
+            b[k] = _mm512_loadu_si512(src + i + k * ZMM_BYTES);
+        }
+        encrypt_zmm(rk, key->rounds, b, WAYS);
+#pragma GCC unroll 4
+        for(int k=0; k<WAYS; k++) {
+            _mm512_storeu_si512(dst + i + k * ZMM_BYTES, b[k]);
+        }
+    }
+    for(; i + ZMM_BYTES <= bytes; i += ZMM_BYTES) {
+        b[0] = _mm512_loadu_si512(src + i);
+        encrypt_zmm(rk, key->rounds, b, 1);
+        _mm512_storeu_si512(dst + i, b[0]);
+    }
+    //up to three blocks are left, masked moves keep them in one register
+    if(i < bytes) {
+        __mmask64 mask = ((__mmask64) 1 << (bytes - i)) - 1;
+        b[0] = _mm512_maskz_loadu_epi8(mask, src + i);
+        encrypt_zmm(rk, key->rounds, b, 1);
+        _mm512_mask_storeu_epi8(dst + i, mask, b[0]);
+    }
+    _mm256_zeroupper();
+}
+
+void aes_ctr_vaes(const struct aes_key *key, const uint8_t iv[AES_BLOCK], uint8_t *dst, const uint8_t *src, size_t len) {
+    __m512i rk[AES_MAX_ROUNDS + 1], b[WAYS];
+    uint64_t hi, lo;
+    size_t i = 0;
+
+    memcpy(&hi, iv, sizeof(hi));
+    memcpy(&lo, iv + sizeof(hi), sizeof(lo));
+    hi = __builtin_bswap64(hi);
+    lo = __builtin_bswap64(lo);
+    load_round_keys(key, rk);
+    for(; i + WAYS * ZMM_BYTES <= len; i += WAYS * ZMM_BYTES) {
+        next_counters(&hi, &lo, b, WAYS);
+        encrypt_zmm(rk, key->rounds, b, WAYS);
+#pragma GCC unroll 4
+        for(int k=0; k<WAYS; k++) {
+            __m512i data = _mm512_loadu_si512(src + i + k * ZMM_BYTES);
+            _mm512_storeu_si512(dst + i + k * ZMM_BYTES, _mm512_xor_si512(data, b[k]));
+        }
+    }
+    for(; i + ZMM_BYTES <= len; i += ZMM_BYTES) {
+        next_counters(&hi, &lo, b, 1);
+        encrypt_zmm(rk, key->rounds, b, 1);
+        _mm512_storeu_si512(dst + i, _mm512_xor_si512(_mm512_loadu_si512(src + i), b[0]));
+    }
+    if(i < len) {
+        __mmask64 mask = ((__mmask64) 1 << (len - i)) - 1;
+        next_counters(&hi, &lo, b, 1);
+        encrypt_zmm(rk, key->rounds, b, 1);
+        _mm512_mask_storeu_epi8(dst + i, mask, _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, src + i), b[0]));
+    }
+    _mm256_zeroupper();
+}
+
+//unreduced products of all four lanes
+static inline void clmul_wide512(__m512i a, __m512i b, __m512i *lo, __m512i *hi) {
+    __m512i ll = _mm512_clmulepi64_epi128(a, b, 0x00);
+    __m512i mid = _mm512_xor_si512(_mm512_clmulepi64_epi128(a, b, 0x10), _mm512_clmulepi64_epi128(a, b, 0x01));
+    __m512i hh = _mm512_clmulepi64_epi128(a, b, 0x11);
+    *lo = _mm512_xor_si512(ll, _mm512_bslli_epi128(mid, 8));
+    *hi = _mm512_xor_si512(hh, _mm512_bsrli_epi128(mid, 8));
+}
+
+//lanes H^first, H^(first - 1), ... for four consecutive blocks
+static inline __m512i power_lanes(const struct ghash_key *key, int first) {
+    __m512i powers = _mm512_castsi128_si512(POWER(key, first));
+    powers = _mm512_inserti32x4(powers, POWER(key, first - 1), 1);
+    powers = _mm512_inserti32x4(powers, POWER(key, first - 2), 2);
+    return _mm512_inserti32x4(powers, POWER(key, first - 3), 3);
+}
+
+//16 blocks are multiplied by H^16..H^1 and summed, so there is one reduction per 256 bytes
+void ghash_vpclmul(const struct ghash_key *key, uint8_t x[AES_BLOCK], const uint8_t *data, size_t blocks) {
+    const __m512i h[WAYS] = {power_lanes(key, 16), power_lanes(key, 12), power_lanes(key, 8), power_lanes(key, 4)};
+    __m128i acc = ghash_reflect(_mm_loadu_si128((const __m128i *) x));
+    size_t i = 0;
+
+    for(; i + WAYS * LANES <= blocks; i += WAYS * LANES) {
+        __m512i lo, hi, lo_k, hi_k;
+        __m512i first = reflect512(_mm512_loadu_si512(data + i * AES_BLOCK));
+        clmul_wide512(_mm512_xor_si512(first, _mm512_inserti32x4(_mm512_setzero_si512(), acc, 0)), h[0], &lo, &hi);
+#pragma GCC unroll 4
+        for(int k=1; k<WAYS; k++) {
+            clmul_wide512(reflect512(_mm512_loadu_si512(data + i * AES_BLOCK + k * ZMM_BYTES)), h[k], &lo_k, &hi_k);
+            lo = _mm512_xor_si512(lo, lo_k);
+            hi = _mm512_xor_si512(hi, hi_k);
+        }
+        acc = ghash_reduce(fold_lanes(lo), fold_lanes(hi));
+    }
+    for(; i + LANES <= blocks; i += LANES) {
+        __m512i lo, hi;
+        __m512i first = reflect512(_mm512_loadu_si512(data + i * AES_BLOCK));
+        clmul_wide512(_mm512_xor_si512(first, _mm512_inserti32x4(_mm512_setzero_si512(), acc, 0)), h[WAYS - 1], &lo, &hi);
+        acc = ghash_reduce(fold_lanes(lo), fold_lanes(hi));
+    }
+    for(; i<blocks; i++) {
+        acc = ghash_mul(_mm_xor_si128(acc, ghash_reflect(_mm_loadu_si128((const __m128i *) (data + i * AES_BLOCK)))),
+                        POWER(key, 1));
+    }
+    _mm_storeu_si128((__m128i *) x, ghash_reflect(acc));
+    _mm256_zeroupper();
+}
+
+void vaes_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    aes_ctr_vaes(&ctx->aes, ctx->iv, ctx->dst, ctx->src, ctx->bytes);
+}
+
+void vpclmulqdq_run(void *arg) {
+    struct crypto_ctx *ctx = arg;
+    ghash_vpclmul(&ctx->ghash, ctx->x, ctx->src, ctx->bytes / AES_BLOCK);
+}
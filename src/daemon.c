@@ -0,0 +1,319 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//continuous probing for fleet monitoring: a few short calibrated probes per interval, published with rolling
+//statistics and drift flags in a shared memory ring that monitoring agents can read without talking to us
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "memory.h"
+#include "freq.h"
+#include "abm.h"
+#include "daemon.h"
+
+#define EWMA_WEIGHT (1.0 / 16.0)
+
+//readers depend on these, a change needs a new DAEMON_VERSION
+_Static_assert(sizeof(struct daemon_sample) == 48, "daemon_sample layout changed");
+_Static_assert(sizeof(struct daemon_stats) == 56, "daemon_stats layout changed");
+_Static_assert(sizeof(struct daemon_shm) == 240, "daemon_shm layout changed");
+
+static const char *const probe_names[DAEMON_PROBE_CNT] = {"chain", "latency", "popcount"};
+static volatile sig_atomic_t stop_requested;
+
+static void request_stop(int sig) {
+    (void) sig;
+    stop_requested = 1;
+}
+
+static uint64_t clock_ns_of(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+//***********************************************
+//*******************PROBES**********************
+//***********************************************
+
+struct probe_state {
+    void **chase;               //current position of the latency chase
+    void *popcnt_ctx;
+    uint64_t popcnt_ops;
+    bench_fn popcnt;
+};
+
+static double probe_chain(void) {
+    double ghz = 0.0;
+    for(uint32_t i=0; i<DAEMON_REPEATS; i++) {
+        double probe = freq_probe();
+        ghz = probe > ghz ? probe : ghz;
+    }
+    return ghz > 0.0 ? 1.0 / ghz : 0.0;
+}
+
+static double probe_latency(struct probe_state *state) {
+    double best = 0.0;
+    for(uint32_t r=0; r<DAEMON_REPEATS; r++) {
+        void **p = state->chase;
+        uint64_t start = timing_start();
+        for(uint32_t i=0; i<DAEMON_CHASE_STEPS; i+=4) {
+            p = *p; p = *p; p = *p; p = *p;
+        }
+        uint64_t stop = timing_stop();
+        state->chase = p;
+        double ns = timing_to_ns((double) timing_elapsed(start, stop)) / DAEMON_CHASE_STEPS;
+        best = (r == 0 || ns < best) ? ns : best;
+    }
+    return best;
+}
+
+//the kernel runs once untimed first, between two rounds its code and operands leave the caches
+static double probe_popcount(struct probe_state *state) {
+    double best = 0.0;
+    abm_prepare(state->popcnt_ctx);
+    state->popcnt(state->popcnt_ctx);
+    for(uint32_t r=0; r<DAEMON_REPEATS; r++) {
+        abm_prepare(state->popcnt_ctx);
+        uint64_t start = timing_start();
+        state->popcnt(state->popcnt_ctx);
+        uint64_t stop = timing_stop();
+        double ns = timing_to_ns((double) timing_elapsed(start, stop)) / state->popcnt_ops;
+        best = (r == 0 || ns < best) ? ns : best;
+    }
+    return best;
+}
+
+//***********************************************
+//*****************STATISTICS********************
+//***********************************************
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+//median and scaled median absolute deviation of the learning rounds, values is reordered
+static void learn_baseline(double *values, struct daemon_stats *stats) {
+    double deviation[DAEMON_LEARN_ROUNDS];
+    qsort(values, DAEMON_LEARN_ROUNDS, sizeof(*values), compare_double);
+    stats->baseline = (values[(DAEMON_LEARN_ROUNDS - 1) / 2] + values[DAEMON_LEARN_ROUNDS / 2]) / 2.0;
+    for(uint32_t i=0; i<DAEMON_LEARN_ROUNDS; i++) {
+        deviation[i] = values[i] > stats->baseline ? values[i] - stats->baseline : stats->baseline - values[i];
+    }
+    qsort(deviation, DAEMON_LEARN_ROUNDS, sizeof(*deviation), compare_double);
+    stats->spread = 1.4826 * (deviation[(DAEMON_LEARN_ROUNDS - 1) / 2] + deviation[DAEMON_LEARN_ROUNDS / 2]) / 2.0;
+}
+
+//only slowdowns count: a probe that got faster is no health problem, and the baseline stays as learned
+//so that a slow decline (aging cooling, creeping load) is not learned away
+static bool update_stats(struct daemon_stats *stats, double value, uint64_t round) {
+    stats->last = value;
+    stats->ewma = round == 1 ? value : stats->ewma + EWMA_WEIGHT * (value - stats->ewma);
+    stats->min = (round == 1 || value < stats->min) ? value : stats->min;
+    stats->max = (round == 1 || value > stats->max) ? value : stats->max;
+    if(stats->baseline == 0.0) {
+        return false;
+    }
+    const bool beyond = value > stats->baseline * (1.0 + DAEMON_DRIFT_REL) &&
+                        value > stats->baseline + DAEMON_DRIFT_SIGMA * stats->spread;
+    stats->drifting = beyond ? stats->drifting + 1 : 0;
+    if(stats->drifting == DAEMON_DRIFT_ROUNDS) {
+        stats->events++;
+    }
+    return stats->drifting >= DAEMON_DRIFT_ROUNDS;
+}
+
+//***********************************************
+//*******************DAEMON**********************
+//***********************************************
+
+//pid of the daemon that owns the existing object name if it is still running, 0 if that daemon is gone,
+//-1 if the object holds no daemon header (someone else's object, or a daemon still setting it up)
+static pid_t shm_owner(const char *name) {
+    struct daemon_shm header;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if(fd < 0) {
+        return 0;
+    }
+    ssize_t got = read(fd, &header, sizeof(header));
+    close(fd);
+    if(got != (ssize_t) sizeof(header) || memcmp(header.magic, DAEMON_MAGIC, sizeof(header.magic)) != 0 ||
+       header.pid <= 0) {
+        return -1;
+    }
+    return kill((pid_t) header.pid, 0) == 0 || errno == EPERM ? (pid_t) header.pid : 0;
+}
+
+//creates name exclusively, so a second daemon cannot take over (and later unlink) a live segment;
+//an object left behind by a daemon that died is reclaimed
+static struct daemon_shm *shm_create(const char *name, size_t bytes) {
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0 && errno == EEXIST) {
+        pid_t owner = shm_owner(name);
+        if(owner > 0) {
+            printf("Shared memory object %s is in use by the daemon with pid %d\r\n", name, (int) owner);
+            errno = EEXIST;
+            return NULL;
+        }
+        if(owner < 0) {
+            printf("Shared memory object %s exists but holds no daemon header\r\n", name);
+            errno = EEXIST;
+            return NULL;
+        }
+        printf("Reclaiming %s, its daemon is no longer running\r\n", name);
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if(fd < 0) {
+        return NULL;
+    }
+    if(ftruncate(fd, (off_t) bytes) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    void *shm = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(shm == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+    memset(shm, 0, bytes);
+    return shm;
+}
+
+//sleeps until deadline (CLOCK_MONOTONIC ns), returns early on SIGINT/SIGTERM
+static void sleep_until(uint64_t deadline) {
+    struct timespec ts = {(time_t) (deadline / 1000000000ull), (long) (deadline % 1000000000ull)};
+    while(!stop_requested && clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+//probes every interval until SIGINT/SIGTERM (or config->rounds rounds) and publishes the results in the
+//shared memory object config->shm_name, which is removed again on exit
+int daemon_run(const struct bench_env *env, const struct daemon_config *config) {
+    const size_t bytes = sizeof(struct daemon_shm) + DAEMON_CAPACITY * sizeof(struct daemon_sample);
+    double learning[DAEMON_PROBE_CNT][DAEMON_LEARN_ROUNDS];
+    struct probe_state state;
+    struct sigaction action;
+
+    void **chase = arena_alloc(&env->corpus->arena, DAEMON_CHASE_BYTES);
+    state.popcnt_ctx = popcnt_setup(env, &state.popcnt_ops);
+    state.popcnt = dispatch_supported(env->cpu_info, REQUIRES(ISA(POPCNT))) ? popcnt_run : popcnt_run_emulated;
+    if(chase == NULL || state.popcnt_ctx == NULL) {
+        printf("Could not allocate the probes\r\n");
+        return 1;
+    }
+    chase_build(chase, DAEMON_CHASE_BYTES, &env->corpus->rng);
+    state.chase = chase;
+
+    struct daemon_shm *shm = shm_create(config->shm_name, bytes);
+    if(shm == NULL) {
+        printf("Could not create the shared memory object %s: %s\r\n", config->shm_name, strerror(errno));
+        return 1;
+    }
+    memcpy(shm->magic, DAEMON_MAGIC, sizeof(shm->magic));
+    shm->version = DAEMON_VERSION;
+    shm->header_bytes = sizeof(struct daemon_shm);
+    shm->sample_bytes = sizeof(struct daemon_sample);
+    shm->capacity = DAEMON_CAPACITY;
+    shm->probe_cnt = DAEMON_PROBE_CNT;
+    shm->pid = getpid();
+    shm->interval = config->interval;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("Daemon: probes %s, %s, %s every %g s into shared memory %s, baseline after %u rounds\r\n",
+           probe_names[0], probe_names[1], probe_names[2], config->interval, config->shm_name, DAEMON_LEARN_ROUNDS);
+    fflush(stdout);
+
+    const uint64_t start_wall = clock_ns_of(CLOCK_MONOTONIC);
+    const uint64_t start_cpu = clock_ns_of(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t next = start_wall;
+    for(uint64_t round=1; !stop_requested && (config->rounds == 0 || round <= config->rounds); round++) {
+        struct daemon_sample sample = {round, 0, {probe_chain(), probe_latency(&state), probe_popcount(&state)}, 0, 0};
+        sample.time_ns = clock_ns_of(CLOCK_REALTIME);
+
+        //seqlock: readers retry while seq is odd or changed under them
+        atomic_fetch_add_explicit(&shm->seq, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for(uint32_t p=0; p<DAEMON_PROBE_CNT; p++) {
+            struct daemon_stats *stats = &shm->stats[p];
+            const uint32_t events = stats->events;
+            if(update_stats(stats, sample.value[p], round)) {
+                sample.flags |= 1u << p;
+            }
+            if(round <= DAEMON_LEARN_ROUNDS) {
+                learning[p][round - 1] = sample.value[p];
+                if(round == DAEMON_LEARN_ROUNDS) {
+                    learn_baseline(learning[p], stats);
+                }
+            }
+            if(stats->events != events) {
+                printf("round %llu: %s drifted to %.3f ns (baseline %.3f ns)\r\n", (unsigned long long) round,
+                       probe_names[p], sample.value[p], stats->baseline);
+            }
+        }
+        shm->samples[(round - 1) % DAEMON_CAPACITY] = sample;
+        shm->flags = sample.flags;
+        shm->rounds = round;
+
+        //all rounds together may take at most DAEMON_BUDGET of the wall time up to the next one,
+        //the interval grows if they do not fit
+        const uint64_t cpu = clock_ns_of(CLOCK_PROCESS_CPUTIME_ID);
+        const uint64_t earliest = start_wall + (uint64_t) ((cpu - start_cpu) / DAEMON_BUDGET);
+        const uint64_t last = next;
+        next += (uint64_t) (config->interval * 1e9);
+        next = next > earliest ? next : earliest;
+        shm->interval = (next - last) / 1e9;
+        //whole periods (every round with the sleep after it), the span the budget is enforced over
+        shm->duty = (double) (cpu - start_cpu) / (next - start_wall);
+        atomic_fetch_add_explicit(&shm->seq, 1, memory_order_release);
+
+        if(round == DAEMON_LEARN_ROUNDS) {
+            printf("Baseline: chain %.3f ns, latency %.2f ns, popcount %.3f ns\r\n", shm->stats[0].baseline,
+                   shm->stats[1].baseline, shm->stats[2].baseline);
+        }
+        fflush(stdout);
+        if(config->rounds == 0 || round < config->rounds) {
+            sleep_until(next);
+        }
+    }
+
+    printf("Daemon stopped after %llu rounds, CPU duty %.4f%% over the round periods\r\n",
+           (unsigned long long) shm->rounds, shm->duty * 100.0);
+    for(uint32_t p=0; p<DAEMON_PROBE_CNT; p++) {
+        const struct daemon_stats *stats = &shm->stats[p];
+        printf("%-9s last %.3f ns, ewma %.3f, min %.3f, max %.3f, baseline %.3f +- %.3f, %u drift events\r\n",
+               probe_names[p], stats->last, stats->ewma, stats->min, stats->max, stats->baseline, stats->spread,
+               stats->events);
+    }
+    munmap(shm, bytes);
+    shm_unlink(config->shm_name);
+    return 0;
+}
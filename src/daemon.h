@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef DAEMON
+#define DAEMON
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define DAEMON_SHM_NAME "/cpu-benchmark-probes" //default POSIX shared memory object
+#define DAEMON_INTERVAL 60.0                    //default seconds between two probe rounds
+#define DAEMON_BUDGET 0.001                     //CPU time / wall time the daemon may use, rounds are spaced out to meet it
+#define DAEMON_MAGIC "CPUPROBE"
+#define DAEMON_VERSION 1
+#define DAEMON_CAPACITY 1024                    //samples in the ring
+#define DAEMON_REPEATS 3                        //timed calls per probe and round, the fastest one counts
+#define DAEMON_CHASE_BYTES ((size_t) 32 << 20)  //latency probe working set, beyond most L3 slices a core can use alone
+#define DAEMON_CHASE_STEPS 1024                 //dependent loads per latency probe call
+#define DAEMON_LEARN_ROUNDS 16                  //rounds the baseline is learned from
+#define DAEMON_DRIFT_REL 0.15                   //a probe this much slower than its baseline ...
+#define DAEMON_DRIFT_SIGMA 4.0                  //... and this many spreads above it counts as drifting
+#define DAEMON_DRIFT_ROUNDS 3                   //consecutive drifting rounds before the flag is raised
+
+enum daemon_probe {
+    DAEMON_PROBE_CHAIN,     //ns per dependent integer add, rises when the core clock drops (throttling)
+    DAEMON_PROBE_LATENCY,   //ns per dependent load over DAEMON_CHASE_BYTES (noisy neighbours, memory)
+    DAEMON_PROBE_POPCOUNT,  //ns per operation of the popcnt registry kernel (microcode, frequency)
+    DAEMON_PROBE_CNT
+};
+
+//shared memory layout, version 1; all fields are little endian and naturally aligned, new fields are only ever
+//appended (header_bytes/sample_bytes tell readers where the samples start and how large they are)
+//readers copy what they need between two reads of seq and retry if it was odd or changed (seqlock)
+
+//one round of probes
+struct daemon_sample {
+    uint64_t round;                         //1 for the first round
+    uint64_t time_ns;                       //CLOCK_REALTIME at the end of the round
+    double value[DAEMON_PROBE_CNT];         //ns per operation
+    uint32_t flags;                         //bit p: probe p is drifting
+    uint32_t reserved;
+};
+
+//rolling statistics of one probe
+struct daemon_stats {
+    double last;
+    double ewma;                            //exponentially weighted mean, weight 1/16 for the newest round
+    double min;
+    double max;
+    double baseline;                        //median of the learning rounds, 0 while learning
+    double spread;                          //1.4826 * median absolute deviation of the learning rounds
+    uint32_t drifting;                      //consecutive rounds beyond the threshold
+    uint32_t events;                        //times the drift flag was raised
+};
+
+struct daemon_shm {
+    char magic[8];                          //DAEMON_MAGIC, no terminating NUL
+    uint32_t version;
+    uint32_t header_bytes;                  //offset of samples[0]
+    uint32_t sample_bytes;
+    uint32_t capacity;                      //samples in the ring, sample of round r is samples[(r - 1) % capacity]
+    uint32_t probe_cnt;
+    uint32_t flags;                         //flags of the latest sample, nonzero means attention
+    _Atomic uint64_t seq;                   //odd while the writer updates the segment
+    uint64_t rounds;                        //rounds written so far
+    int64_t pid;                            //writer process
+    double interval;                        //seconds between rounds actually used
+    double duty;                            //CPU time / wall time since the start, up to the end of the current period
+    struct daemon_stats stats[DAEMON_PROBE_CNT];
+    struct daemon_sample samples[];
+};
+
+struct daemon_config {
+    const char *shm_name;
+    double interval;                        //seconds, stretched if the rounds would exceed DAEMON_BUDGET
+    uint64_t rounds;                        //0 runs until SIGINT/SIGTERM
+};
+
+struct bench_env;
+int daemon_run(const struct bench_env *env, const struct daemon_config *config);
+
+#endif
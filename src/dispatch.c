@@ -0,0 +1,25 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cpuinfo.h"
+#include "dispatch.h"
+
+//returns true if every extension in requires is reported by cpu_info
+bool dispatch_supported(const struct cpu_info *info, const size_t requires[DISPATCH_REQUIRES_MAX]) {
+    for(size_t i=0; i<DISPATCH_REQUIRES_MAX && requires[i] != 0; i++) {
+        if(!*(const bool *) ((const char *) info + requires[i])) {
+            return false;
+        }
+    }
+    return true;
+}
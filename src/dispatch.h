@@ -0,0 +1,30 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef DISPATCH
+#define DISPATCH
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cpuinfo.h"
+
+//kernels that need an extension are compiled in their own translation unit with a matching
+//#pragma GCC target, everything else is built for the baseline x86-64 ISA. Callers pick the
+//variant once with dispatch_supported(), so no feature check ever ends up in a timed region.
+
+#define DISPATCH_REQUIRES_MAX 4
+
+//offset of a cpu_info flag, offset 0 (BIT_VERSION) marks an unused requirement slot
+#define ISA(name) offsetof(struct cpu_info, name)
+#define REQUIRES(...) ((const size_t[DISPATCH_REQUIRES_MAX]) {__VA_ARGS__})
+
+bool dispatch_supported(const struct cpu_info *info, const size_t requires[DISPATCH_REQUIRES_MAX]);
+
+#endif
@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+#include <emmintrin.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "parallel.h"
+#include "flops.h"
+#include "flops_kernels.h"
+#include "freq.h"
+
+#define VARIANT_CNT (sizeof(variants) / sizeof(variants[0]))
+#define NAME_WIDTH 12
+#define COLUMN_WIDTH 11
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+//SSE2 is part of the x86-64 baseline, so these kernels need no dispatch
+#define ADD_PS(x) _mm_add_ps(x, a)
+#define MUL_PS(x) _mm_mul_ps(x, m)
+#define ADD_PD(x) _mm_add_pd(x, a)
+#define MUL_PD(x) _mm_mul_pd(x, m)
+
+FLOPS_KERNEL(add_ps128, __m128, _mm_set1_ps, _mm_cvtss_f32, ADD_PS)
+FLOPS_KERNEL(mul_ps128, __m128, _mm_set1_ps, _mm_cvtss_f32, MUL_PS)
+FLOPS_KERNEL(add_pd128, __m128d, _mm_set1_pd, _mm_cvtsd_f64, ADD_PD)
+FLOPS_KERNEL(mul_pd128, __m128d, _mm_set1_pd, _mm_cvtsd_f64, MUL_PD)
+
+//***********************************************
+//*******************REGISTRY********************
+//***********************************************
+
+//operands of every kernel, the values keep all chains away from overflow and denormals
+void flops_init(struct flops_ctx *ctx) {
+    ctx->iters = FLOPS_ITERS;
+    ctx->mul = 1.0;
+    ctx->add = 1.0 / 1024;
+    ctx->start = 1.0;
+    ctx->result = 0.0;
+}
+
+//ops are instructions of a throughput kernel
+void *flops_setup(const struct bench_env *env, uint64_t *ops) {
+    struct flops_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    if(ctx == NULL) {
+        return NULL;
+    }
+    flops_init(ctx);
+    *ops = (uint64_t) FLOPS_ITERS * FLOPS_ACCUMULATORS;
+    return ctx;
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//one instruction form
+struct flops_variant {
+    const char *name;
+    bench_fn latency;
+    bench_fn throughput;
+    uint32_t width;    //vector bits
+    uint32_t element;  //32 for float, 64 for double
+    bool fma;          //counts as two floating point operations per element
+    bool supported;
+};
+
+#define VARIANT(name, kernel, width, element, fma, ok) \
+    {name, kernel##_latency, kernel##_throughput, width, element, fma, ok}
+
+//median ns per instruction of a single-threaded kernel, 0 on failure
+static double measure_single(const struct bench_env *env, bench_fn run, uint64_t ops) {
+    struct flops_ctx ctx;
+    struct measure_result result;
+    flops_init(&ctx);
+    struct measure_kernel kernel = {NULL, run, &ctx, ops};
+    return measure_run(&kernel, env->config, &result) == 0 ? result.median : 0.0;
+}
+
+//instructions per second in millions on all logical CPUs, 0 on failure
+static double measure_all(const struct bench_env *env, bench_fn run, struct flops_ctx *ctxs,
+                          struct worker *workers, const uint32_t *order) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    struct parallel_result result;
+
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        flops_init(&ctxs[i]);
+        workers[i].run = run;
+        workers[i].prepare = NULL;
+        workers[i].ctx = &ctxs[i];
+        workers[i].ops = (uint64_t) FLOPS_ITERS * FLOPS_ACCUMULATORS;
+    }
+    return parallel_measure(workers, topology->cpu_cnt, topology, order, &result) == 0 ? result.total : 0.0;
+}
+
+//latency of add/mul/FMA in core cycles, then peak throughput of every instruction form on one core
+//and on all CPUs; the effective number of units per core is the measured instructions per cycle
+//rounded to an integer, the theoretical peak assumes that many units on every physical core
+int flops_suite(const struct bench_env *env) {
+    const struct cpu_info *info = env->cpu_info;
+    const struct cpu_topology *topology = &info->topology;
+    const bool avx = dispatch_supported(info, REQUIRES(ISA(AVX)));
+    const bool fma3 = dispatch_supported(info, REQUIRES(ISA(AVX), ISA(FMA3)));
+    const bool fma4 = dispatch_supported(info, REQUIRES(ISA(AVX), ISA(FMA4)));
+    const bool avx512 = dispatch_supported(info, REQUIRES(ISA(AVX512F)));
+    const struct flops_variant variants[] = {
+        VARIANT("add ps128", add_ps128, 128, 32, false, true),
+        VARIANT("mul ps128", mul_ps128, 128, 32, false, true),
+        VARIANT("fma ps128", fma_ps128, 128, 32, true, fma3),
+        VARIANT("fma4 ps128", fma4_ps128, 128, 32, true, fma4),
+        VARIANT("add pd128", add_pd128, 128, 64, false, true),
+        VARIANT("mul pd128", mul_pd128, 128, 64, false, true),
+        VARIANT("fma pd128", fma_pd128, 128, 64, true, fma3),
+        VARIANT("fma4 pd128", fma4_pd128, 128, 64, true, fma4),
+        VARIANT("add ps256", add_ps256, 256, 32, false, avx),
+        VARIANT("mul ps256", mul_ps256, 256, 32, false, avx),
+        VARIANT("fma ps256", fma_ps256, 256, 32, true, fma3),
+        VARIANT("fma4 ps256", fma4_ps256, 256, 32, true, fma4),
+        VARIANT("add pd256", add_pd256, 256, 64, false, avx),
+        VARIANT("mul pd256", mul_pd256, 256, 64, false, avx),
+        VARIANT("fma pd256", fma_pd256, 256, 64, true, fma3),
+        VARIANT("fma4 pd256", fma4_pd256, 256, 64, true, fma4),
+        VARIANT("add ps512", add_ps512, 512, 32, false, avx512),
+        VARIANT("mul ps512", mul_ps512, 512, 32, false, avx512),
+        VARIANT("fma ps512", fma_ps512, 512, 32, true, avx512),
+        VARIANT("add pd512", add_pd512, 512, 64, false, avx512),
+        VARIANT("mul pd512", mul_pd512, 512, 64, false, avx512),
+        VARIANT("fma pd512", fma_pd512, 512, 64, true, avx512),
+    };
+    const uint32_t cpu_cnt = topology->cpu_cnt;
+    const uint32_t cores = info->CORES_PHYSICAL ? info->CORES_PHYSICAL : 1;
+    uint32_t fma_units[3] = {0}; //128, 256 and 512 bit, 0 if not measured
+    double best_sp = 0.0, best_dp = 0.0;
+    int status = 0;
+
+    const double ghz = freq_core_ghz(env);
+    struct flops_ctx *ctxs = calloc(cpu_cnt, sizeof(*ctxs));
+    struct worker *workers = calloc(cpu_cnt, sizeof(*workers));
+    uint32_t *order = calloc(cpu_cnt, sizeof(*order));
+    if(ghz == 0.0 || ctxs == NULL || workers == NULL || order == NULL) {
+        status = -1;
+        goto out;
+    }
+    placement_order(topology, PLACEMENT_SPREAD, order);
+
+    printf("Core clock (integer add chain): %.2f GHz, cycles below are core cycles\r\n", ghz);
+    printf("%-*s%*s%*s%*s%*s%*s%*s%*s\r\n", NAME_WIDTH, "instruction", COLUMN_WIDTH, "latency",
+           COLUMN_WIDTH, "instr/cyc", COLUMN_WIDTH, "FLOP/cyc", COLUMN_WIDTH, "GFLOPS 1",
+           COLUMN_WIDTH, "GFLOPS all", COLUMN_WIDTH, "peak all", COLUMN_WIDTH, "% peak");
+    for(size_t k=0; k<VARIANT_CNT; k++) {
+        const struct flops_variant *variant = &variants[k];
+        printf("%-*s", NAME_WIDTH, variant->name);
+        if(!variant->supported) {
+            printf("%*s\r\n", COLUMN_WIDTH, "-");
+            continue;
+        }
+        double latency = measure_single(env, variant->latency, (uint64_t) FLOPS_ITERS * FLOPS_LATENCY_CHAIN);
+        double throughput = measure_single(env, variant->throughput, (uint64_t) FLOPS_ITERS * FLOPS_ACCUMULATORS);
+        double all = measure_all(env, variant->throughput, ctxs, workers, order);
+        if(latency == 0.0 || throughput == 0.0 || all == 0.0) {
+            printf("\r\n");
+            status = -1;
+            goto out;
+        }
+        const uint32_t flops = variant->width / variant->element * (variant->fma ? 2 : 1);
+        double per_cycle = 1.0 / (throughput * ghz);
+        double units = fmax(1.0, round(per_cycle));
+        double gflops_all = all * flops / 1e3;
+        double peak_all = units * flops * ghz * cores;
+        printf("%*.2f%*.2f%*.1f%*.1f%*.1f%*.1f%*.1f\r\n", COLUMN_WIDTH, latency * ghz, COLUMN_WIDTH, per_cycle,
+               COLUMN_WIDTH, per_cycle * flops, COLUMN_WIDTH, flops / throughput,
+               COLUMN_WIDTH, gflops_all, COLUMN_WIDTH, peak_all, COLUMN_WIDTH, 100.0 * gflops_all / peak_all);
+
+        if(variant->fma) {
+            size_t width = variant->width == 128 ? 0 : (variant->width == 256 ? 1 : 2);
+            fma_units[width] = fma_units[width] > (uint32_t) units ? fma_units[width] : (uint32_t) units;
+        }
+        if(variant->element == 32) {
+            best_sp = fmax(best_sp, flops / throughput);
+        } else {
+            best_dp = fmax(best_dp, flops / throughput);
+        }
+        fflush(stdout);
+    }
+
+    printf("Effective FMA units per core: %u (128 bit), %u (256 bit), %u (512 bit)\r\n",
+           fma_units[0], fma_units[1], fma_units[2]);
+    printf("Best per core: %.1f GFLOPS single, %.1f GFLOPS double precision\r\n", best_sp, best_dp);
+
+out:
+    free(ctxs);
+    free(workers);
+    free(order);
+    return status;
+}
@@ -0,0 +1,69 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef FLOPS
+#define FLOPS
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define FLOPS_ITERS 1024         //loop iterations per sample
+#define FLOPS_LATENCY_CHAIN 8    //dependent operations per iteration of a latency kernel
+#define FLOPS_ACCUMULATORS 12    //independent chains of a throughput kernel, enough for 2 ports with latency 6
+
+//operands of a kernel, mul and add are runtime values so the compiler can not fold the operation away
+struct flops_ctx {
+    uint64_t iters;
+    double mul;   //1.0, keeps mul chains away from overflow and denormals
+    double add;
+    double start; //value of the first accumulator
+    double result;
+};
+
+//every kernel family provides a latency (one dependent chain) and a throughput (FLOPS_ACCUMULATORS
+//independent chains) variant, the suffix names operation, element type and vector width
+#define FLOPS_DECLARE(name) \
+    void name##_latency(void *ctx); \
+    void name##_throughput(void *ctx)
+
+//baseline SSE2 (flops.c)
+FLOPS_DECLARE(add_ps128);
+FLOPS_DECLARE(mul_ps128);
+FLOPS_DECLARE(add_pd128);
+FLOPS_DECLARE(mul_pd128);
+//AVX (flops_avx.c)
+FLOPS_DECLARE(add_ps256);
+FLOPS_DECLARE(mul_ps256);
+FLOPS_DECLARE(add_pd256);
+FLOPS_DECLARE(mul_pd256);
+//FMA3 (flops_fma.c)
+FLOPS_DECLARE(fma_ps128);
+FLOPS_DECLARE(fma_pd128);
+FLOPS_DECLARE(fma_ps256);
+FLOPS_DECLARE(fma_pd256);
+//FMA4 (flops_fma4.c)
+FLOPS_DECLARE(fma4_ps128);
+FLOPS_DECLARE(fma4_pd128);
+FLOPS_DECLARE(fma4_ps256);
+FLOPS_DECLARE(fma4_pd256);
+//AVX-512F (flops_avx512.c)
+FLOPS_DECLARE(add_ps512);
+FLOPS_DECLARE(mul_ps512);
+FLOPS_DECLARE(fma_ps512);
+FLOPS_DECLARE(add_pd512);
+FLOPS_DECLARE(mul_pd512);
+FLOPS_DECLARE(fma_pd512);
+
+struct bench_env;
+void flops_init(struct flops_ctx *ctx);
+void *flops_setup(const struct bench_env *env, uint64_t *ops);
+int flops_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,28 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//256 bit add and mul, this translation unit is compiled for AVX
+//nothing in here may be called unless dispatch_supported() confirmed it
+#pragma GCC target("avx")
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "flops.h"
+#include "flops_kernels.h"
+
+#define ADD_PS(x) _mm256_add_ps(x, a)
+#define MUL_PS(x) _mm256_mul_ps(x, m)
+#define ADD_PD(x) _mm256_add_pd(x, a)
+#define MUL_PD(x) _mm256_mul_pd(x, m)
+
+FLOPS_KERNEL(add_ps256, __m256, _mm256_set1_ps, _mm256_cvtss_f32, ADD_PS)
+FLOPS_KERNEL(mul_ps256, __m256, _mm256_set1_ps, _mm256_cvtss_f32, MUL_PS)
+FLOPS_KERNEL(add_pd256, __m256d, _mm256_set1_pd, _mm256_cvtsd_f64, ADD_PD)
+FLOPS_KERNEL(mul_pd256, __m256d, _mm256_set1_pd, _mm256_cvtsd_f64, MUL_PD)
@@ -0,0 +1,32 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//512 bit add, mul and fused multiply-add, this translation unit is compiled for AVX512F
+//nothing in here may be called unless dispatch_supported() confirmed it
+#pragma GCC target("avx512f")
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "flops.h"
+#include "flops_kernels.h"
+
+#define ADD_PS(x) _mm512_add_ps(x, a)
+#define MUL_PS(x) _mm512_mul_ps(x, m)
+#define FMA_PS(x) _mm512_fmadd_ps(x, m, a)
+#define ADD_PD(x) _mm512_add_pd(x, a)
+#define MUL_PD(x) _mm512_mul_pd(x, m)
+#define FMA_PD(x) _mm512_fmadd_pd(x, m, a)
+
+FLOPS_KERNEL(add_ps512, __m512, _mm512_set1_ps, _mm512_cvtss_f32, ADD_PS)
+FLOPS_KERNEL(mul_ps512, __m512, _mm512_set1_ps, _mm512_cvtss_f32, MUL_PS)
+FLOPS_KERNEL(fma_ps512, __m512, _mm512_set1_ps, _mm512_cvtss_f32, FMA_PS)
+FLOPS_KERNEL(add_pd512, __m512d, _mm512_set1_pd, _mm512_cvtsd_f64, ADD_PD)
+FLOPS_KERNEL(mul_pd512, __m512d, _mm512_set1_pd, _mm512_cvtsd_f64, MUL_PD)
+FLOPS_KERNEL(fma_pd512, __m512d, _mm512_set1_pd, _mm512_cvtsd_f64, FMA_PD)
@@ -0,0 +1,28 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//128 and 256 bit fused multiply-add, this translation unit is compiled for AVX and FMA3
+//nothing in here may be called unless dispatch_supported() confirmed both
+#pragma GCC target("avx,fma")
+
+#include <stdint.h>
+#include <immintrin.h>
+#include "flops.h"
+#include "flops_kernels.h"
+
+#define FMA_PS128(x) _mm_fmadd_ps(x, m, a)
+#define FMA_PD128(x) _mm_fmadd_pd(x, m, a)
+#define FMA_PS256(x) _mm256_fmadd_ps(x, m, a)
+#define FMA_PD256(x) _mm256_fmadd_pd(x, m, a)
+
+FLOPS_KERNEL(fma_ps128, __m128, _mm_set1_ps, _mm_cvtss_f32, FMA_PS128)
+FLOPS_KERNEL(fma_pd128, __m128d, _mm_set1_pd, _mm_cvtsd_f64, FMA_PD128)
+FLOPS_KERNEL(fma_ps256, __m256, _mm256_set1_ps, _mm256_cvtss_f32, FMA_PS256)
+FLOPS_KERNEL(fma_pd256, __m256d, _mm256_set1_pd, _mm256_cvtsd_f64, FMA_PD256)
@@ -0,0 +1,28 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AMD four operand fused multiply-add, this translation unit is compiled for AVX and FMA4
+//nothing in here may be called unless dispatch_supported() confirmed both
+#pragma GCC target("avx,fma4")
+
+#include <stdint.h>
+#include <x86intrin.h>
+#include "flops.h"
+#include "flops_kernels.h"
+
+#define FMA4_PS128(x) _mm_macc_ps(x, m, a)
+#define FMA4_PD128(x) _mm_macc_pd(x, m, a)
+#define FMA4_PS256(x) _mm256_macc_ps(x, m, a)
+#define FMA4_PD256(x) _mm256_macc_pd(x, m, a)
+
+FLOPS_KERNEL(fma4_ps128, __m128, _mm_set1_ps, _mm_cvtss_f32, FMA4_PS128)
+FLOPS_KERNEL(fma4_pd128, __m128d, _mm_set1_pd, _mm_cvtsd_f64, FMA4_PD128)
+FLOPS_KERNEL(fma4_ps256, __m256, _mm256_set1_ps, _mm256_cvtss_f32, FMA4_PS256)
+FLOPS_KERNEL(fma4_pd256, __m256d, _mm256_set1_pd, _mm256_cvtsd_f64, FMA4_PD256)
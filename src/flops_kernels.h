@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//kernel generator shared by the floating point translation units. The functions use whatever
+//vector extension the including file enables with #pragma GCC target, so include it after that.
+//OP(x) is the operation applied to accumulator x, it may use the broadcast operands m and a
+//(each operation uses only one of them, hence the casts to void).
+
+#ifndef FLOPS_KERNELS
+#define FLOPS_KERNELS
+#include <stdint.h>
+#include "flops.h"
+
+#define FLOPS_KERNEL(name, vec, set1, first, OP)                                             \
+void name##_latency(void *arg) {                                                             \
+    struct flops_ctx *ctx = arg;                                                             \
+    const vec m = set1(ctx->mul), a = set1(ctx->add);                                        \
+    (void) m; (void) a;                                                                      \
+    vec x = set1(ctx->start);                                                                \
+    for(uint64_t i=0; i<ctx->iters; i++) {                                                   \
+        x = OP(x); x = OP(x); x = OP(x); x = OP(x);                                          \
+        x = OP(x); x = OP(x); x = OP(x); x = OP(x);                                          \
+    }                                                                                        \
+    ctx->result = first(x);                                                                  \
+}                                                                                            \
+                                                                                             \
+void name##_throughput(void *arg) {                                                          \
+    struct flops_ctx *ctx = arg;                                                             \
+    const vec m = set1(ctx->mul), a = set1(ctx->add);                                        \
+    (void) m; (void) a;                                                                      \
+    vec x0 = set1(ctx->start), x1 = set1(ctx->start + 1), x2 = set1(ctx->start + 2);         \
+    vec x3 = set1(ctx->start + 3), x4 = set1(ctx->start + 4), x5 = set1(ctx->start + 5);     \
+    vec x6 = set1(ctx->start + 6), x7 = set1(ctx->start + 7), x8 = set1(ctx->start + 8);     \
+    vec x9 = set1(ctx->start + 9), x10 = set1(ctx->start + 10), x11 = set1(ctx->start + 11); \
+    for(uint64_t i=0; i<ctx->iters; i++) {                                                   \
+        x0 = OP(x0); x1 = OP(x1); x2 = OP(x2); x3 = OP(x3);                                  \
+        x4 = OP(x4); x5 = OP(x5); x6 = OP(x6); x7 = OP(x7);                                  \
+        x8 = OP(x8); x9 = OP(x9); x10 = OP(x10); x11 = OP(x11);                              \
+    }                                                                                        \
+    ctx->result = first(x0) + first(x1) + first(x2) + first(x3) + first(x4) + first(x5) +    \
+                first(x6) + first(x7) + first(x8) + first(x9) + first(x10) + first(x11);     \
+}
+
+#endif
@@ -0,0 +1,354 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//effective core clock and how it reacts to sustained scalar, 256 bit and 512 bit load. The clock is
+//measured by timing a chain of dependent integer adds (one per core cycle) against the TSC, so it is
+//the clock the core actually runs at, including turbo and AVX licence reductions.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "flops.h"
+#include "freq.h"
+
+#define STRINGIFY(x) #x
+#define EXPAND(x) STRINGIFY(x)
+#define LOAD_CNT (sizeof(loads) / sizeof(loads[0]))
+#define BEFORE_POINTS (FREQ_BEFORE_NS / FREQ_INTERVAL_NS)
+#define LOAD_POINTS (FREQ_LOAD_NS / FREQ_INTERVAL_NS)
+#define AFTER_POINTS (FREQ_AFTER_NS / FREQ_INTERVAL_NS)
+#define POINT_CNT (BEFORE_POINTS + LOAD_POINTS + AFTER_POINTS)
+#define DRIFT_POINTS (LOAD_POINTS / 10)  //points at the start and the end of the load compared for drift
+#define SETTLED_BATCHES 64               //steady batches in a row that end the transition
+#define DETAIL_NS 4000000ull             //every point is printed this long after a phase starts
+#define PRINT_NS 10000000ull             //spacing of printed points in the rest of a phase
+#define NAME_WIDTH 10
+#define COLUMN_WIDTH 11
+
+//***********************************************
+//********************PROBE**********************
+//***********************************************
+
+//a chain of dependent register adds retires one add per core clock on every x86 core
+//(immediate adds are not used, newer cores fold chains of them at rename)
+static inline uint64_t add_chain(uint64_t x, uint64_t iters) {
+    const uint64_t step = x | 1;
+    for(uint64_t i=0; i<iters; i++) {
+        __asm__ volatile (".rept " EXPAND(FREQ_PROBE_CHAIN) "\n\t"
+                          "add %1, %0 \n\t"
+                          ".endr"
+            :"+r"(x)
+            :"r"(step)
+        );
+    }
+    return x;
+}
+
+static void add_chain_run(void *arg) {
+    uint64_t *value = arg;
+    *value = add_chain(*value, FREQ_CORE_ITERS);
+}
+
+//core clock in GHz from one short chain, cheap enough to sample the clock every few microseconds;
+//interrupts only ever make it lower, so callers keep the fastest of a few probes
+double freq_probe(void) {
+    uint64_t start = timing_start();
+    (void) add_chain(start, FREQ_PROBE_ITERS); //the asm is volatile, the chain runs even though x is unused
+    uint64_t stop = timing_stop();
+    double ns = timing_to_ns((double) timing_elapsed(start, stop));
+    return ns > 0.0 ? (double) FREQ_PROBE_ITERS * FREQ_PROBE_CHAIN / ns : 0.0;
+}
+
+//core clock in GHz while running scalar integer code, 0 if the measurement failed
+double freq_core_ghz(const struct bench_env *env) {
+    struct measure_result result;
+    uint64_t value = 0;
+    struct measure_kernel kernel = {NULL, add_chain_run, &value, (uint64_t) FREQ_CORE_ITERS * FREQ_PROBE_CHAIN};
+    if(measure_run(&kernel, env->config, &result) != 0 || result.median <= 0.0) {
+        return 0.0;
+    }
+    return 1.0 / result.median;
+}
+
+static double probe_best(void) {
+    double best = 0.0;
+    for(uint32_t i=0; i<FREQ_PROBES; i++) {
+        double ghz = freq_probe();
+        best = ghz > best ? ghz : best;
+    }
+    return best;
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//one kind of sustained load, run is called with a struct flops_ctx
+struct freq_load {
+    const char *name;
+    bench_fn run;
+    bool supported;
+};
+
+//clock reaction of one load, the recovery time is the first point after the load from which on the
+//clock stays within FREQ_TOLERANCE of the clock before it
+struct freq_summary {
+    double before;   //GHz, median of the scalar phase before the load
+    double load;     //GHz, median of the second half of the load
+    double start;    //GHz, median of the first DRIFT_POINTS of the load
+    double end;      //GHz, median of the last DRIFT_POINTS of the load
+    double after;    //GHz, first point after the load
+    double recovery; //ns after the end of the load, negative if the clock did not recover
+};
+
+//transition into wide code after a scalar phase, medians over FREQ_STALL_REPEATS
+struct freq_stall {
+    double first;  //ns of the first batch
+    double steady; //ns of a batch once the transition is over
+    double slow;   //ns until batches reach the steady state
+    double stall;  //ns lost compared to running at the steady state from the first batch on
+};
+
+static void scalar_run(void *arg) {
+    struct flops_ctx *ctx = arg;
+    ctx->result = (double) add_chain(ctx->iters, ctx->iters);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+//median of n values, copies them to scratch first
+static double median(const double *values, uint32_t n, double *scratch) {
+    memcpy(scratch, values, n * sizeof(*values));
+    qsort(scratch, n, sizeof(*scratch), compare_double);
+    return n % 2 ? scratch[n / 2] : (scratch[n / 2 - 1] + scratch[n / 2]) / 2.0;
+}
+
+//runs the before, load and after phases back to back and stores one clock sample per FREQ_INTERVAL_NS
+//in series; the load runs until the next point is due, the scalar phases spin on probes instead
+static void record_series(const struct freq_load *load, double *series) {
+    struct flops_ctx ctx;
+    flops_init(&ctx);
+    const uint64_t start = clock_ns();
+    for(uint32_t i=0; i<POINT_CNT; i++) {
+        const uint64_t due = start + (uint64_t) (i + 1) * FREQ_INTERVAL_NS;
+        const bool loaded = i >= BEFORE_POINTS && i < BEFORE_POINTS + LOAD_POINTS;
+        while(clock_ns() < due) {
+            if(loaded) {
+                load->run(&ctx);
+            } else {
+                freq_probe();
+            }
+        }
+        series[i] = probe_best();
+    }
+}
+
+static void summarize_series(const double *series, double *scratch, struct freq_summary *summary) {
+    const double *load = series + BEFORE_POINTS;
+    const double *after = load + LOAD_POINTS;
+    summary->before = median(series, BEFORE_POINTS, scratch);
+    summary->load = median(load + LOAD_POINTS / 2, LOAD_POINTS - LOAD_POINTS / 2, scratch);
+    summary->start = median(load, DRIFT_POINTS, scratch);
+    summary->end = median(load + LOAD_POINTS - DRIFT_POINTS, DRIFT_POINTS, scratch);
+    summary->after = after[0];
+
+    //a single slow point later on is an interrupt or a preempted probe, a licence holds for milliseconds
+    const double slow = summary->before * (1.0 - FREQ_TOLERANCE);
+    uint32_t recovered = 0; //index of the first point of the recovered tail
+    for(uint32_t i=0; i<AFTER_POINTS; i++) {
+        if(after[i] < slow && (i == 0 || after[i - 1] < slow)) {
+            recovered = i + 1;
+        }
+    }
+    summary->recovery = recovered < AFTER_POINTS ? (double) (recovered + 1) * FREQ_INTERVAL_NS : -1.0;
+}
+
+//spins on scalar probes for FREQ_QUIET_NS, then times FREQ_STALL_BATCHES batches of the wide kernel back
+//to back; the transition lasts until SETTLED_BATCHES batches in a row run no slower than
+//FREQ_SLOW_FACTOR times the steady state (median of the second half)
+static void record_transition(const struct freq_load *load, double *batch_ns, double *scratch,
+                              struct freq_stall *stall) {
+    struct flops_ctx ctx;
+    flops_init(&ctx);
+    ctx.iters = FREQ_STALL_ITERS;
+    const uint64_t quiet = clock_ns() + FREQ_QUIET_NS;
+    while(clock_ns() < quiet) {
+        freq_probe();
+    }
+
+    uint64_t prev = timing_start();
+    for(uint32_t i=0; i<FREQ_STALL_BATCHES; i++) {
+        load->run(&ctx);
+        uint64_t now = timing_stop();
+        batch_ns[i] = timing_to_ns((double) (now - prev));
+        prev = now;
+    }
+
+    stall->steady = median(batch_ns + FREQ_STALL_BATCHES / 2, FREQ_STALL_BATCHES / 2, scratch);
+    uint32_t slow = 0, settled = 0;
+    for(uint32_t i=0; i<FREQ_STALL_BATCHES && settled<SETTLED_BATCHES; i++) {
+        if(batch_ns[i] > stall->steady * FREQ_SLOW_FACTOR) {
+            slow = i + 1;
+            settled = 0;
+        } else {
+            settled++;
+        }
+    }
+    stall->first = batch_ns[0];
+    stall->slow = 0.0;
+    for(uint32_t i=0; i<slow; i++) {
+        stall->slow += batch_ns[i];
+    }
+    stall->stall = stall->slow > slow * stall->steady ? stall->slow - slow * stall->steady : 0.0;
+}
+
+//prints a point for every FREQ_INTERVAL_NS right after a phase starts and every PRINT_NS after that
+static bool point_printed(uint32_t i) {
+    const uint64_t t = (uint64_t) (i + 1) * FREQ_INTERVAL_NS;
+    uint64_t phase = 0;
+    if(t > FREQ_BEFORE_NS + FREQ_LOAD_NS) {
+        phase = FREQ_BEFORE_NS + FREQ_LOAD_NS;
+    } else if(t > FREQ_BEFORE_NS) {
+        phase = FREQ_BEFORE_NS;
+    }
+    return t - phase <= DETAIL_NS || (t - phase) % PRINT_NS == 0;
+}
+
+static void print_series(const struct freq_load *loads, size_t load_cnt, const double *series) {
+    printf("Core clock in GHz, load from 0 to %.0f ms, scalar code before and after\r\n", FREQ_LOAD_NS / 1e6);
+    printf("%*s", NAME_WIDTH, "t ms");
+    for(size_t k=0; k<load_cnt; k++) {
+        printf("%*s", COLUMN_WIDTH, loads[k].name);
+    }
+    printf("\r\n");
+    for(uint32_t i=0; i<POINT_CNT; i++) {
+        if(!point_printed(i)) {
+            continue;
+        }
+        const double t = ((double) (i + 1) * FREQ_INTERVAL_NS - (double) FREQ_BEFORE_NS) / 1e6;
+        printf("%*.1f", NAME_WIDTH, t);
+        for(size_t k=0; k<load_cnt; k++) {
+            if(loads[k].supported) {
+                printf("%*.2f", COLUMN_WIDTH, series[k * POINT_CNT + i]);
+            } else {
+                printf("%*s", COLUMN_WIDTH, "-");
+            }
+        }
+        printf("\r\n");
+    }
+}
+
+//clock before, during and after sustained scalar, 256 bit FMA and 512 bit FMA load on the current CPU
+//(downclock and recovery time), then the stall when the first wide instruction runs after scalar code
+int freq_suite(const struct bench_env *env) {
+    const struct cpu_info *info = env->cpu_info;
+    const struct freq_load loads[] = {
+        {"scalar", scalar_run, true},
+        {"fma256", fma_ps256_throughput, dispatch_supported(info, REQUIRES(ISA(AVX), ISA(FMA3)))},
+        {"fma512", fma_ps512_throughput, dispatch_supported(info, REQUIRES(ISA(AVX512F)))},
+    };
+    const size_t scratch_cnt = POINT_CNT > FREQ_STALL_BATCHES ? POINT_CNT : FREQ_STALL_BATCHES;
+    double *series = calloc(LOAD_CNT * POINT_CNT, sizeof(*series));
+    double *batch_ns = calloc(FREQ_STALL_BATCHES, sizeof(*batch_ns));
+    double *scratch = calloc(scratch_cnt, sizeof(*scratch));
+    double *repeats = calloc(4 * FREQ_STALL_REPEATS, sizeof(*repeats));
+    int status = 0;
+    if(series == NULL || batch_ns == NULL || scratch == NULL || repeats == NULL) {
+        status = -1;
+        goto out;
+    }
+
+    //the series is only meaningful if every point is taken on the same core
+    cpu_set_t saved, pinned;
+    const int cpu = sched_getcpu();
+    const bool pin = cpu >= 0 && sched_getaffinity(0, sizeof(saved), &saved) == 0;
+    if(pin) {
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        sched_setaffinity(0, sizeof(pinned), &pinned);
+    }
+
+    for(size_t k=0; k<LOAD_CNT; k++) {
+        if(loads[k].supported) {
+            record_series(&loads[k], series + k * POINT_CNT);
+        }
+    }
+    print_series(loads, LOAD_CNT, series);
+
+    printf("%-*s%*s%*s%*s%*s%*s%*s\r\n", NAME_WIDTH, "load", COLUMN_WIDTH, "before", COLUMN_WIDTH, "load",
+           COLUMN_WIDTH, "drop %", COLUMN_WIDTH, "drift %", COLUMN_WIDTH, "after", COLUMN_WIDTH, "recover ms");
+    for(size_t k=0; k<LOAD_CNT; k++) {
+        struct freq_summary summary;
+        printf("%-*s", NAME_WIDTH, loads[k].name);
+        if(!loads[k].supported) {
+            printf("%*s\r\n", COLUMN_WIDTH, "-");
+            continue;
+        }
+        summarize_series(series + k * POINT_CNT, scratch, &summary);
+        printf("%*.2f%*.2f%*.1f%*.1f%*.2f", COLUMN_WIDTH, summary.before, COLUMN_WIDTH, summary.load,
+               COLUMN_WIDTH, 100.0 * (1.0 - summary.load / summary.before),
+               COLUMN_WIDTH, 100.0 * (1.0 - summary.end / summary.start), COLUMN_WIDTH, summary.after);
+        if(summary.recovery < 0.0) {
+            char text[16];
+            snprintf(text, sizeof(text), ">%.0f", FREQ_AFTER_NS / 1e6);
+            printf("%*s\r\n", COLUMN_WIDTH, text);
+        } else {
+            printf("%*.1f\r\n", COLUMN_WIDTH, summary.recovery / 1e6);
+        }
+    }
+
+    printf("First wide instruction after %.0f ms of scalar code, batches of %d instructions\r\n",
+           FREQ_QUIET_NS / 1e6, FREQ_STALL_ITERS * FLOPS_ACCUMULATORS);
+    printf("%-*s%*s%*s%*s%*s\r\n", NAME_WIDTH, "load", COLUMN_WIDTH, "first ns", COLUMN_WIDTH, "steady ns",
+           COLUMN_WIDTH, "slow us", COLUMN_WIDTH, "stall us");
+    for(size_t k=1; k<LOAD_CNT; k++) {
+        printf("%-*s", NAME_WIDTH, loads[k].name);
+        if(!loads[k].supported) {
+            printf("%*s\r\n", COLUMN_WIDTH, "-");
+            continue;
+        }
+        for(uint32_t r=0; r<FREQ_STALL_REPEATS; r++) {
+            struct freq_stall stall;
+            record_transition(&loads[k], batch_ns, scratch, &stall);
+            repeats[r] = stall.first;
+            repeats[FREQ_STALL_REPEATS + r] = stall.steady;
+            repeats[2 * FREQ_STALL_REPEATS + r] = stall.slow;
+            repeats[3 * FREQ_STALL_REPEATS + r] = stall.stall;
+        }
+        printf("%*.0f%*.0f%*.2f%*.2f\r\n", COLUMN_WIDTH, median(repeats, FREQ_STALL_REPEATS, scratch),
+               COLUMN_WIDTH, median(repeats + FREQ_STALL_REPEATS, FREQ_STALL_REPEATS, scratch),
+               COLUMN_WIDTH, median(repeats + 2 * FREQ_STALL_REPEATS, FREQ_STALL_REPEATS, scratch) / 1e3,
+               COLUMN_WIDTH, median(repeats + 3 * FREQ_STALL_REPEATS, FREQ_STALL_REPEATS, scratch) / 1e3);
+    }
+
+    if(pin) {
+        sched_setaffinity(0, sizeof(saved), &saved);
+    }
+
+out:
+    free(series);
+    free(batch_ns);
+    free(scratch);
+    free(repeats);
+    return status;
+}
@@ -0,0 +1,36 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef FREQ
+#define FREQ
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FREQ_PROBE_CHAIN 64                //dependent integer adds per iteration of a clock probe
+#define FREQ_CORE_ITERS 1024               //iterations of freq_core_ghz() per sample
+#define FREQ_PROBE_ITERS 64                //iterations of one freq_probe(), about 1.5 us at 3 GHz
+#define FREQ_PROBES 4                      //probes per point of a series, the fastest one is kept
+#define FREQ_INTERVAL_NS 500000ull         //time between two points of a series
+#define FREQ_BEFORE_NS 10000000ull         //scalar only phase before the load
+#define FREQ_LOAD_NS 100000000ull          //sustained load
+#define FREQ_AFTER_NS 40000000ull          //scalar only phase after the load
+#define FREQ_TOLERANCE 0.05                //a clock within 5% of the one before the load counts as recovered
+#define FREQ_QUIET_NS 20000000ull          //scalar only code before the first wide instruction
+#define FREQ_STALL_BATCHES 4096            //timed batches after the first wide instruction
+#define FREQ_STALL_ITERS 16                //kernel iterations per batch (192 instructions)
+#define FREQ_STALL_REPEATS 5
+#define FREQ_SLOW_FACTOR 1.5               //a batch this much slower than the steady state is still stalled
+
+struct bench_env;
+double freq_probe(void);
+double freq_core_ghz(const struct bench_env *env);
+int freq_suite(const struct bench_env *env);
+
+#endif
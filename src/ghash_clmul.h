@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//GHASH building blocks shared by the PCLMULQDQ and VPCLMULQDQ kernels. The inline functions
+//use PCLMULQDQ and SSSE3, so this header may only be included after a matching #pragma GCC target.
+//All values are byte reflected, which turns the bit reflected GCM field into plain polynomials.
+
+#ifndef GHASH_CLMUL
+#define GHASH_CLMUL
+#include <immintrin.h>
+
+static inline __m128i ghash_reflect(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+//unreduced 256 bit product a * b, callers may xor several products before a single reduction
+static inline void clmul_wide(__m128i a, __m128i b, __m128i *lo, __m128i *hi) {
+    __m128i ll = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    __m128i hh = _mm_clmulepi64_si128(a, b, 0x11);
+    *lo = _mm_xor_si128(ll, _mm_slli_si128(mid, 8));
+    *hi = _mm_xor_si128(hh, _mm_srli_si128(mid, 8));
+}
+
+//shifts the product left by one bit (reflection) and reduces it modulo x^128 + x^7 + x^2 + x + 1
+static inline __m128i ghash_reduce(__m128i lo, __m128i hi) {
+    __m128i carry_lo = _mm_srli_epi32(lo, 31);
+    __m128i carry_hi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    hi = _mm_or_si128(hi, _mm_srli_si128(carry_lo, 12));
+    hi = _mm_or_si128(hi, _mm_slli_si128(carry_hi, 4));
+    lo = _mm_or_si128(lo, _mm_slli_si128(carry_lo, 4));
+
+    __m128i fold = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)),
+                                 _mm_slli_epi32(lo, 25));
+    __m128i fold_hi = _mm_srli_si128(fold, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(fold, 12));
+
+    __m128i rest = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)),
+                                 _mm_srli_epi32(lo, 7));
+    rest = _mm_xor_si128(rest, fold_hi);
+    return _mm_xor_si128(hi, _mm_xor_si128(lo, rest));
+}
+
+static inline __m128i ghash_mul(__m128i a, __m128i b) {
+    __m128i lo, hi;
+    clmul_wide(a, b, &lo, &hi);
+    return ghash_reduce(lo, hi);
+}
+
+#endif
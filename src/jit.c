@@ -0,0 +1,343 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//runtime generator of instruction latency/throughput kernels: every jit_spec is encoded into an
+//unrolled loop in an mmap'd buffer, once as a dependent chain and once as an independent stream,
+//so a new extension only needs table entries in jit_specs.c instead of hand written inline asm
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <xmmintrin.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "freq.h"
+#include "jit.h"
+
+#define REG_RAX 0
+#define REG_RBX 3
+#define REG_RSI 6
+#define REG_RDI 7
+#define GPR_SOURCE REG_RBX   //read by the throughput stream, never written
+#define VEC_SOURCE 12
+#define MXCSR_DAZ_FTZ 0x8040 //denormals would hit microcode assists and measure those instead
+#define NAME_WIDTH 33
+#define COLUMN_WIDTH 11
+
+//registers written by GPR streams; rdi is the loop counter, rsp and rbp stay untouched
+static const uint8_t gpr_chains[JIT_GPR_CHAINS] = {0, 1, 2, 6, 8, 9, 10, 11};
+
+//every register starts with this value: 1.0f in every float lane, and dense bits for integer work
+static const uint64_t initial[8] __attribute__((aligned(64))) = {
+    0x3f8000003f800000ull, 0x3f8000003f800000ull, 0x3f8000003f800000ull, 0x3f8000003f800000ull,
+    0x3f8000003f800000ull, 0x3f8000003f800000ull, 0x3f8000003f800000ull, 0x3f8000003f800000ull,
+};
+
+//***********************************************
+//********************BUFFER*********************
+//***********************************************
+
+int jit_init(struct jit_buffer *buf, size_t size) {
+    buf->code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    buf->size = size;
+    buf->used = 0;
+    buf->overflow = false;
+    return buf->code != MAP_FAILED ? 0 : -1;
+}
+
+//makes the generated code executable (and no longer writable), NULL on failure
+jit_fn jit_seal(struct jit_buffer *buf) {
+    if(buf->overflow || mprotect(buf->code, buf->size, PROT_READ | PROT_EXEC) != 0) {
+        return NULL;
+    }
+    return (jit_fn) (void *) buf->code;
+}
+
+void jit_free(struct jit_buffer *buf) {
+    if(buf->code != MAP_FAILED && buf->code != NULL) {
+        munmap(buf->code, buf->size);
+    }
+    buf->code = NULL;
+}
+
+static void emit(struct jit_buffer *buf, uint8_t byte) {
+    if(buf->used < buf->size) {
+        buf->code[buf->used++] = byte;
+    } else {
+        buf->overflow = true;
+    }
+}
+
+static void emit32(struct jit_buffer *buf, uint32_t value) {
+    for(int i=0; i<4; i++) {
+        emit(buf, (uint8_t) (value >> (8 * i)));
+    }
+}
+
+//***********************************************
+//*******************ENCODER*********************
+//***********************************************
+
+static uint8_t prefix_pp(uint8_t prefix) {
+    return prefix == 0x66 ? 1 : (prefix == 0xf3 ? 2 : (prefix == 0xf2 ? 3 : 0));
+}
+
+//one instruction with register operands (or [rsi] as rm if memory is set), length is the vector
+//length (0 128 bit or scalar, 1 256 bit, 2 512 bit); registers 16-31 are not used
+static void emit_insn(struct jit_buffer *buf, uint8_t encoding, uint8_t prefix, uint8_t map, uint8_t opcode,
+                      uint8_t w, uint8_t length, uint8_t reg, uint8_t vvvv, uint8_t rm, bool memory) {
+    const uint8_t r = (reg >> 3) & 1, b = (rm >> 3) & 1;
+
+    if(encoding == JIT_LEGACY) {
+        if(prefix) emit(buf, prefix);
+        uint8_t rex = 0x40 | (w << 3) | (r << 2) | b;
+        if(rex != 0x40) emit(buf, rex);
+        if(map != JIT_MAP1) emit(buf, 0x0f);
+        if(map == JIT_0F38) emit(buf, 0x38);
+        if(map == JIT_0F3A) emit(buf, 0x3a);
+    } else if(encoding == JIT_VEX) {
+        emit(buf, 0xc4);
+        emit(buf, (uint8_t) ((!r << 7) | (1 << 6) | (!b << 5) | map));
+        emit(buf, (uint8_t) ((w << 7) | ((~vvvv & 0xf) << 3) | ((length & 1) << 2) | prefix_pp(prefix)));
+    } else {
+        //R', X and V' are inverted as well, all three stay 1 for registers below 16
+        emit(buf, 0x62);
+        emit(buf, (uint8_t) ((!r << 7) | (1 << 6) | (!b << 5) | (1 << 4) | map));
+        emit(buf, (uint8_t) ((w << 7) | ((~vvvv & 0xf) << 3) | (1 << 2) | prefix_pp(prefix)));
+        emit(buf, (uint8_t) ((length << 5) | (1 << 3)));
+    }
+    emit(buf, opcode);
+    emit(buf, (uint8_t) ((memory ? 0x00 : 0xc0) | ((reg & 7) << 3) | (rm & 7)));
+}
+
+static uint8_t vector_length(const struct jit_spec *spec) {
+    return spec->regs == JIT_YMM ? 1 : (spec->regs == JIT_ZMM ? 2 : 0);
+}
+
+static void emit_spec(struct jit_buffer *buf, const struct jit_spec *spec, uint8_t dst, uint8_t src) {
+    uint8_t reg = dst, vvvv = 0, rm = src;
+    if(spec->shape == JIT_NDS) {
+        vvvv = src;
+    } else if(spec->shape == JIT_EXT) {
+        reg = spec->ext;
+        if(spec->encoding == JIT_LEGACY) {
+            rm = dst;
+        } else {
+            vvvv = dst;
+        }
+    }
+    emit_insn(buf, spec->encoding, spec->prefix, spec->map, spec->opcode, spec->w, vector_length(spec),
+              reg, vvvv, rm, false);
+    if(spec->imm != JIT_NO_IMM) {
+        emit(buf, (uint8_t) spec->imm);
+    }
+}
+
+//movups reg, [rsi] in the encoding and vector length of spec
+static void emit_vector_load(struct jit_buffer *buf, const struct jit_spec *spec, uint8_t reg) {
+    emit_insn(buf, spec->regs == JIT_XMM && spec->encoding == JIT_LEGACY ? JIT_LEGACY : spec->encoding,
+              0, JIT_0F, 0x10, 0, vector_length(spec), reg, 0, REG_RSI, true);
+}
+
+//***********************************************
+//******************GENERATOR********************
+//***********************************************
+
+//void kernel(uint64_t iters (rdi), const void *data (rsi)):
+//    push rbx; load every register used from [rsi]
+//    loop: JIT_UNROLL instructions; dec rdi; jnz loop
+//    vzeroupper (VEX/EVEX vector forms only, BMI is VEX on GPRs and must not need AVX state); pop rbx; ret
+//returns -1 if the buffer can not be made writable again or the code does not fit
+int jit_generate(struct jit_buffer *buf, const struct jit_spec *spec, bool latency) {
+    const bool vector = spec->regs != JIT_GPR;
+    if(mprotect(buf->code, buf->size, PROT_READ | PROT_WRITE) != 0) {
+        return -1;
+    }
+    buf->used = 0;
+    buf->overflow = false;
+
+    emit(buf, 0x53); //push rbx
+    if(vector) {
+        for(uint8_t reg=0; reg<=VEC_SOURCE; reg++) {
+            emit_vector_load(buf, spec, reg);
+        }
+    }
+    //mov reg, [rsi], rsi itself goes last
+    emit_insn(buf, JIT_LEGACY, 0, JIT_MAP1, 0x8b, 1, 0, GPR_SOURCE, 0, REG_RSI, true);
+    for(uint32_t i=0; i<JIT_GPR_CHAINS; i++) {
+        if(gpr_chains[i] != REG_RSI) {
+            emit_insn(buf, JIT_LEGACY, 0, JIT_MAP1, 0x8b, 1, 0, gpr_chains[i], 0, REG_RSI, true);
+        }
+    }
+    emit_insn(buf, JIT_LEGACY, 0, JIT_MAP1, 0x8b, 1, 0, REG_RSI, 0, REG_RSI, true);
+
+    const size_t loop = buf->used;
+    const uint8_t source = vector ? VEC_SOURCE : GPR_SOURCE;
+    for(uint32_t i=0; i<JIT_UNROLL; i++) {
+        if(latency) {
+            emit_spec(buf, spec, REG_RAX, REG_RAX);
+        } else {
+            emit_spec(buf, spec, vector ? (uint8_t) (i % JIT_VEC_CHAINS) : gpr_chains[i % JIT_GPR_CHAINS], source);
+        }
+    }
+    emit_insn(buf, JIT_LEGACY, 0, JIT_MAP1, 0xff, 1, 0, 1, 0, REG_RDI, false); //dec rdi
+    emit(buf, 0x0f); //jnz rel32
+    emit(buf, 0x85);
+    emit32(buf, (uint32_t) (loop - (buf->used + 4)));
+    if(vector && spec->encoding != JIT_LEGACY) {
+        emit(buf, 0xc5); //vzeroupper
+        emit(buf, 0xf8);
+        emit(buf, 0x77);
+    }
+    emit(buf, 0x5b); //pop rbx
+    emit(buf, 0xc3); //ret
+    return buf->overflow ? -1 : 0;
+}
+
+//***********************************************
+//*******************REGISTRY********************
+//***********************************************
+
+void jit_run(void *arg) {
+    struct jit_ctx *ctx = arg;
+    const unsigned int csr = _mm_getcsr();
+    _mm_setcsr(csr | MXCSR_DAZ_FTZ);
+    ctx->fn(JIT_ITERS, initial);
+    _mm_setcsr(csr);
+}
+
+static const struct jit_spec *jit_find(const char *name) {
+    for(size_t i=0; i<jit_spec_cnt; i++) {
+        if(strcmp(jit_specs[i].name, name) == 0) {
+            return &jit_specs[i];
+        }
+    }
+    return NULL;
+}
+
+//generates the throughput stream of the named form, or its latency chain if a flag dependency leaves it
+//without an independent stream; ops are instructions
+static void *jit_setup(const struct bench_env *env, const char *name, uint64_t *ops) {
+    const struct jit_spec *spec = jit_find(name);
+    struct jit_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    if(spec == NULL || ctx == NULL || jit_init(&ctx->buf, JIT_BUFFER_SIZE) != 0) {
+        return NULL;
+    }
+    if(jit_generate(&ctx->buf, spec, spec->flag_chain) != 0 || (ctx->fn = jit_seal(&ctx->buf)) == NULL) {
+        jit_free(&ctx->buf);
+        return NULL;
+    }
+    *ops = (uint64_t) JIT_ITERS * JIT_UNROLL;
+    return ctx;
+}
+
+void jit_teardown(void *arg) {
+    struct jit_ctx *ctx = arg;
+    jit_free(&ctx->buf);
+}
+
+#define JIT_SETUP(entry, form) \
+    void *entry##_setup(const struct bench_env *env, uint64_t *ops) { return jit_setup(env, form, ops); }
+
+JIT_SETUP(sse, "addps xmm, xmm")
+JIT_SETUP(sse2, "paddd xmm, xmm")
+JIT_SETUP(ssse3, "pshufb xmm, xmm")
+JIT_SETUP(sse41, "pmulld xmm, xmm")
+JIT_SETUP(cmov, "cmove r64, r64")
+JIT_SETUP(adx, "adcx r64, r64")
+JIT_SETUP(gfni, "gf2p8affineqb xmm, xmm, imm8")
+JIT_SETUP(f16c, "vcvtph2ps ymm, xmm")
+JIT_SETUP(avx512bw, "vpshufb zmm, zmm, zmm")
+JIT_SETUP(avx512dq, "vpmullq zmm, zmm, zmm")
+JIT_SETUP(avx512cd, "vplzcntd zmm, zmm")
+JIT_SETUP(avx512vbmi, "vpermb zmm, zmm, zmm")
+JIT_SETUP(avx512vbmi2, "vpshldd zmm, zmm, zmm, imm8")
+JIT_SETUP(avx512vnni, "vpdpbusd zmm, zmm, zmm")
+JIT_SETUP(avx512ifma, "vpmadd52luq zmm, zmm, zmm")
+JIT_SETUP(avx512bitalg, "vpopcntb zmm, zmm")
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//median core cycles per instruction of one generated form, 0 on failure
+static double measure_form(const struct bench_env *env, struct jit_buffer *buf, const struct jit_spec *spec,
+                           bool latency, double ghz) {
+    struct measure_result result;
+    struct jit_ctx ctx;
+    if(jit_generate(buf, spec, latency) != 0 || (ctx.fn = jit_seal(buf)) == NULL) {
+        return 0.0;
+    }
+    struct measure_kernel kernel = {NULL, jit_run, &ctx, (uint64_t) JIT_ITERS * JIT_UNROLL};
+    return measure_run(&kernel, env->config, &result) == 0 ? result.median * ghz : 0.0;
+}
+
+//names of the required extensions joined with '+'
+static void format_requires(const struct jit_spec *spec, char *text, size_t size) {
+    size_t len = 0;
+    text[0] = '\0';
+    for(size_t i=0; i<DISPATCH_REQUIRES_MAX && spec->requires[i] != 0; i++) {
+        for(size_t f=0; f<cpu_flag_cnt; f++) {
+            if(cpu_flags[f].offset == spec->requires[i] && len < size) {
+                len += snprintf(text + len, size - len, "%s%s", i ? "+" : "", cpu_flags[f].name);
+            }
+        }
+    }
+}
+
+//latency and reciprocal throughput in core cycles of every instruction in jit_specs the CPU supports
+int jit_suite(const struct bench_env *env) {
+    const double ghz = freq_core_ghz(env);
+    struct jit_buffer buf;
+    char requires[64];
+    int status = 0;
+    if(ghz == 0.0 || jit_init(&buf, JIT_BUFFER_SIZE) != 0) {
+        return -1;
+    }
+
+    printf("Core clock (integer add chain): %.2f GHz, cycles below are core cycles\r\n", ghz);
+    printf("latency: all operands in one register; throughput: %d GPR or %d vector registers written, "
+           "a separate one read\r\n", JIT_GPR_CHAINS, JIT_VEC_CHAINS);
+    printf("%-*s %-26s%*s%*s%*s\r\n", NAME_WIDTH, "instruction", "extension", COLUMN_WIDTH, "latency",
+           COLUMN_WIDTH, "recip tp", COLUMN_WIDTH, "instr/cyc");
+    for(size_t i=0; i<jit_spec_cnt; i++) {
+        const struct jit_spec *spec = &jit_specs[i];
+        format_requires(spec, requires, sizeof(requires));
+        printf("%-*s %-26s", NAME_WIDTH, spec->name, requires);
+        if(!dispatch_supported(env->cpu_info, spec->requires)) {
+            printf("%*s\r\n", COLUMN_WIDTH, "-");
+            continue;
+        }
+        double latency = measure_form(env, &buf, spec, true, ghz);
+        double throughput = spec->flag_chain ? -1.0 : measure_form(env, &buf, spec, false, ghz);
+        if(latency == 0.0 || throughput == 0.0) {
+            printf("\r\n");
+            status = -1;
+            break;
+        }
+        if(spec->flag_chain) {
+            printf("%*.2f%*s%*s  flag dependency, no independent stream\r\n", COLUMN_WIDTH, latency,
+                   COLUMN_WIDTH, "-", COLUMN_WIDTH, "-");
+        } else {
+            printf("%*.2f%*.2f%*.2f\r\n", COLUMN_WIDTH, latency, COLUMN_WIDTH, throughput, COLUMN_WIDTH,
+                   1.0 / throughput);
+        }
+        fflush(stdout);
+    }
+
+    jit_free(&buf);
+    return status;
+}
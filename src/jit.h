@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef JIT
+#define JIT
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "dispatch.h"
+
+#define JIT_UNROLL 64          //instructions per loop iteration of generated code
+#define JIT_ITERS 256          //loop iterations per sample
+#define JIT_BUFFER_SIZE 16384  //enough for JIT_UNROLL instructions of 15 bytes plus prologue
+#define JIT_GPR_CHAINS 8       //independent registers of a throughput stream
+#define JIT_VEC_CHAINS 12
+#define JIT_NO_IMM -1
+
+enum jit_encoding {
+    JIT_LEGACY, //[prefix] [REX] [map] opcode modrm
+    JIT_VEX,    //3 byte VEX
+    JIT_EVEX
+};
+
+//register file of the operands, the vector ones also set the vector length
+enum jit_regs {
+    JIT_GPR,
+    JIT_XMM,
+    JIT_YMM,
+    JIT_ZMM
+};
+
+//how destination and source map to the modrm.reg, VEX.vvvv and modrm.rm fields
+enum jit_shape {
+    JIT_RM,  //reg = destination, rm = source
+    JIT_NDS, //reg = destination, vvvv = rm = source (VEX/EVEX only)
+    JIT_EXT  //reg = ext; legacy: rm = destination (read-modify-write), VEX/EVEX: vvvv = destination, rm = source
+};
+
+enum jit_map {
+    JIT_MAP1,   //one byte opcodes
+    JIT_0F,
+    JIT_0F38,
+    JIT_0F3A
+};
+
+//one instruction form with register operands only; the latency chain uses the same register for all
+//operands, the throughput stream writes one of JIT_*_CHAINS registers and reads a register never written
+struct jit_spec {
+    const char *name;
+    size_t requires[DISPATCH_REQUIRES_MAX]; //ISA(...) like a registry entry
+    uint8_t encoding;
+    uint8_t regs;
+    uint8_t shape;
+    uint8_t prefix;  //mandatory prefix: 0, 0x66, 0xF3 or 0xF2
+    uint8_t map;
+    uint8_t opcode;
+    uint8_t w;       //REX.W, VEX.W or EVEX.W
+    uint8_t ext;     //opcode extension (/digit) of JIT_EXT
+    int16_t imm;     //imm8 or JIT_NO_IMM
+    bool flag_chain; //reads a flag it writes, independent registers do not break the dependency, no throughput
+};
+
+extern const struct jit_spec jit_specs[];
+extern const size_t jit_spec_cnt;
+
+//W^X code buffer, writable while code is generated and executable while it runs
+struct jit_buffer {
+    uint8_t *code;
+    size_t size;
+    size_t used;
+    bool overflow;
+};
+
+typedef void (*jit_fn)(uint64_t iters, const void *data);
+
+int jit_init(struct jit_buffer *buf, size_t size);
+int jit_generate(struct jit_buffer *buf, const struct jit_spec *spec, bool latency);
+jit_fn jit_seal(struct jit_buffer *buf);
+void jit_free(struct jit_buffer *buf);
+
+//registry entries for extensions without a hand written kernel: setup generates one form of jit_specs
+//(looked up by name), jit_run times it and jit_teardown unmaps the buffer
+struct jit_ctx {
+    jit_fn fn;
+    struct jit_buffer buf;
+};
+
+struct bench_env;
+void jit_run(void *ctx);
+void jit_teardown(void *ctx);
+void *sse_setup(const struct bench_env *env, uint64_t *ops);
+void *sse2_setup(const struct bench_env *env, uint64_t *ops);
+void *ssse3_setup(const struct bench_env *env, uint64_t *ops);
+void *sse41_setup(const struct bench_env *env, uint64_t *ops);
+void *cmov_setup(const struct bench_env *env, uint64_t *ops);
+void *adx_setup(const struct bench_env *env, uint64_t *ops);
+void *gfni_setup(const struct bench_env *env, uint64_t *ops);
+void *f16c_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512bw_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512dq_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512cd_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512vbmi_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512vbmi2_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512vnni_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512ifma_setup(const struct bench_env *env, uint64_t *ops);
+void *avx512bitalg_setup(const struct bench_env *env, uint64_t *ops);
+
+int jit_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//instruction forms measured by the jit suite; a new extension only needs rows here. Encodings follow
+//the Intel SDM: prefix and map of the opcode, W bit, and for JIT_EXT the /digit in modrm.reg.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cpuinfo.h"
+#include "dispatch.h"
+#include "jit.h"
+
+#define NO JIT_NO_IMM
+
+//name, requires, encoding, registers, shape, prefix, map, opcode, W, /digit, imm8, flag chain
+const struct jit_spec jit_specs[] = {
+    //general purpose
+    {"add r64, r64",              {ISA(X64)},      JIT_LEGACY, JIT_GPR, JIT_RM,  0x00, JIT_MAP1, 0x03, 1, 0, NO, 0},
+    {"imul r64, r64",             {ISA(X64)},      JIT_LEGACY, JIT_GPR, JIT_RM,  0x00, JIT_0F,   0xaf, 1, 0, NO, 0},
+    {"shl r64, imm8",             {ISA(X64)},      JIT_LEGACY, JIT_GPR, JIT_EXT, 0x00, JIT_MAP1, 0xc1, 1, 4, 3, 0},
+    {"ror r64, imm8",             {ISA(X64)},      JIT_LEGACY, JIT_GPR, JIT_EXT, 0x00, JIT_MAP1, 0xc1, 1, 1, 3, 0},
+    //cpu_info.CMOV comes from the AMD extended leaf, but every x86-64 CPU has cmov
+    {"cmove r64, r64",            {ISA(X64)},      JIT_LEGACY, JIT_GPR, JIT_RM,  0x00, JIT_0F,   0x44, 1, 0, NO, 0},
+    {"popcnt r64, r64",           {ISA(POPCNT)},   JIT_LEGACY, JIT_GPR, JIT_RM,  0xf3, JIT_0F,   0xb8, 1, 0, NO, 0},
+    {"lzcnt r64, r64",            {ISA(ABM)},      JIT_LEGACY, JIT_GPR, JIT_RM,  0xf3, JIT_0F,   0xbd, 1, 0, NO, 0},
+    {"crc32 r64, r64",            {ISA(SSE42)},    JIT_LEGACY, JIT_GPR, JIT_RM,  0xf2, JIT_0F38, 0xf1, 1, 0, NO, 0},
+    //adcx reads the CF it writes, its throughput stream is one chain through CF and would only repeat the latency
+    {"adcx r64, r64",             {ISA(INTEL_ADX)}, JIT_LEGACY, JIT_GPR, JIT_RM, 0x66, JIT_0F38, 0xf6, 1, 0, NO, 1},
+    //BMI1/BMI2
+    {"tzcnt r64, r64",            {ISA(BMI1)},     JIT_LEGACY, JIT_GPR, JIT_RM,  0xf3, JIT_0F,   0xbc, 1, 0, NO, 0},
+    {"andn r64, r64, r64",        {ISA(BMI1)},     JIT_VEX,    JIT_GPR, JIT_NDS, 0x00, JIT_0F38, 0xf2, 1, 0, NO, 0},
+    {"blsr r64, r64",             {ISA(BMI1)},     JIT_VEX,    JIT_GPR, JIT_EXT, 0x00, JIT_0F38, 0xf3, 1, 1, NO, 0},
+    {"bextr r64, r64, r64",       {ISA(BMI1)},     JIT_VEX,    JIT_GPR, JIT_NDS, 0x00, JIT_0F38, 0xf7, 1, 0, NO, 0},
+    {"pdep r64, r64, r64",        {ISA(BMI2)},     JIT_VEX,    JIT_GPR, JIT_NDS, 0xf2, JIT_0F38, 0xf5, 1, 0, NO, 0},
+    {"pext r64, r64, r64",        {ISA(BMI2)},     JIT_VEX,    JIT_GPR, JIT_NDS, 0xf3, JIT_0F38, 0xf5, 1, 0, NO, 0},
+    {"shlx r64, r64, r64",        {ISA(BMI2)},     JIT_VEX,    JIT_GPR, JIT_NDS, 0x66, JIT_0F38, 0xf7, 1, 0, NO, 0},
+    {"rorx r64, r64, imm8",       {ISA(BMI2)},     JIT_VEX,    JIT_GPR, JIT_RM,  0xf2, JIT_0F3A, 0xf0, 1, 0, 3, 0},
+    //SSE family
+    {"addps xmm, xmm",            {ISA(SSE)},      JIT_LEGACY, JIT_XMM, JIT_RM,  0x00, JIT_0F,   0x58, 0, 0, NO, 0},
+    {"sqrtps xmm, xmm",           {ISA(SSE)},      JIT_LEGACY, JIT_XMM, JIT_RM,  0x00, JIT_0F,   0x51, 0, 0, NO, 0},
+    {"mulpd xmm, xmm",            {ISA(SSE2)},     JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F,   0x59, 0, 0, NO, 0},
+    {"paddd xmm, xmm",            {ISA(SSE2)},     JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F,   0xfe, 0, 0, NO, 0},
+    {"pshufb xmm, xmm",           {ISA(SSSE3)},    JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F38, 0x00, 0, 0, NO, 0},
+    {"pmulld xmm, xmm",           {ISA(SSE41)},    JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F38, 0x40, 0, 0, NO, 0},
+    {"aesenc xmm, xmm",           {ISA(AES)},      JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F38, 0xdc, 0, 0, NO, 0},
+    {"pclmulqdq xmm, xmm, imm8",  {ISA(PCMULQDQ)}, JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F3A, 0x44, 0, 0, 0x00, 0},
+    {"sha1msg1 xmm, xmm",         {ISA(SHA)},      JIT_LEGACY, JIT_XMM, JIT_RM,  0x00, JIT_0F38, 0xc9, 0, 0, NO, 0},
+    {"gf2p8mulb xmm, xmm",        {ISA(GFNI)},     JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F38, 0xcf, 0, 0, NO, 0},
+    {"gf2p8affineqb xmm, xmm, imm8", {ISA(GFNI)},     JIT_LEGACY, JIT_XMM, JIT_RM,  0x66, JIT_0F3A, 0xce, 0, 0, 0x00, 0},
+    //AVX/AVX2/FMA3/F16C
+    {"vaddps ymm, ymm, ymm",      {ISA(AVX)},      JIT_VEX,    JIT_YMM, JIT_NDS, 0x00, JIT_0F,   0x58, 0, 0, NO, 0},
+    {"vmulps ymm, ymm, ymm",      {ISA(AVX)},      JIT_VEX,    JIT_YMM, JIT_NDS, 0x00, JIT_0F,   0x59, 0, 0, NO, 0},
+    {"vdivps ymm, ymm, ymm",      {ISA(AVX)},      JIT_VEX,    JIT_YMM, JIT_NDS, 0x00, JIT_0F,   0x5e, 0, 0, NO, 0},
+    {"vpaddd ymm, ymm, ymm",      {ISA(AVX2)},     JIT_VEX,    JIT_YMM, JIT_NDS, 0x66, JIT_0F,   0xfe, 0, 0, NO, 0},
+    {"vpmulld ymm, ymm, ymm",     {ISA(AVX2)},     JIT_VEX,    JIT_YMM, JIT_NDS, 0x66, JIT_0F38, 0x40, 0, 0, NO, 0},
+    {"vpshufb ymm, ymm, ymm",     {ISA(AVX2)},     JIT_VEX,    JIT_YMM, JIT_NDS, 0x66, JIT_0F38, 0x00, 0, 0, NO, 0},
+    {"vpermd ymm, ymm, ymm",      {ISA(AVX2)},     JIT_VEX,    JIT_YMM, JIT_NDS, 0x66, JIT_0F38, 0x36, 0, 0, NO, 0},
+    {"vpsllq ymm, ymm, imm8",     {ISA(AVX2)},     JIT_VEX,    JIT_YMM, JIT_EXT, 0x66, JIT_0F,   0x73, 0, 6, 3, 0},
+    {"vfmadd231ps ymm, ymm, ymm", {ISA(AVX), ISA(FMA3)}, JIT_VEX, JIT_YMM, JIT_NDS, 0x66, JIT_0F38, 0xb8, 0, 0, NO, 0},
+    {"vfmadd231pd ymm, ymm, ymm", {ISA(AVX), ISA(FMA3)}, JIT_VEX, JIT_YMM, JIT_NDS, 0x66, JIT_0F38, 0xb8, 1, 0, NO, 0},
+    {"vcvtph2ps ymm, xmm",        {ISA(AVX), ISA(F16)}, JIT_VEX, JIT_YMM, JIT_RM,  0x66, JIT_0F38, 0x13, 0, 0, NO, 0},
+    //AVX-512
+    {"vaddps zmm, zmm, zmm",      {ISA(AVX512F)},  JIT_EVEX,   JIT_ZMM, JIT_NDS, 0x00, JIT_0F,   0x58, 0, 0, NO, 0},
+    {"vfmadd231ps zmm, zmm, zmm", {ISA(AVX512F)},  JIT_EVEX,   JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0xb8, 0, 0, NO, 0},
+    {"vpaddd zmm, zmm, zmm",      {ISA(AVX512F)},  JIT_EVEX,   JIT_ZMM, JIT_NDS, 0x66, JIT_0F,   0xfe, 0, 0, NO, 0},
+    {"vpermd zmm, zmm, zmm",      {ISA(AVX512F)},  JIT_EVEX,   JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0x36, 0, 0, NO, 0},
+    {"vpternlogd zmm, zmm, zmm, imm8", {ISA(AVX512F)}, JIT_EVEX,  JIT_ZMM, JIT_NDS, 0x66, JIT_0F3A, 0x25, 0, 0, 0x96, 0},
+    {"vpsllq zmm, zmm, imm8",     {ISA(AVX512F)},  JIT_EVEX,   JIT_ZMM, JIT_EXT, 0x66, JIT_0F,   0x73, 1, 6, 3, 0},
+    {"vpaddb zmm, zmm, zmm",      {ISA(AVX512F), ISA(AVX512BW)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F, 0xfc, 0, 0, NO, 0},
+    {"vpshufb zmm, zmm, zmm",     {ISA(AVX512F), ISA(AVX512BW)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0x00, 0, 0, NO, 0},
+    {"vpmullq zmm, zmm, zmm",     {ISA(AVX512F), ISA(AVX512DQ)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0x40, 1, 0, NO, 0},
+    {"vplzcntd zmm, zmm",         {ISA(AVX512F), ISA(AVX512CD)}, JIT_EVEX, JIT_ZMM, JIT_RM, 0x66, JIT_0F38, 0x44, 0, 0, NO, 0},
+    {"vpopcntd zmm, zmm",         {ISA(AVX512F), ISA(AVX512VPOPCNTDQ)}, JIT_EVEX, JIT_ZMM, JIT_RM, 0x66, JIT_0F38, 0x55, 0, 0, NO, 0},
+    {"vpopcntb zmm, zmm",         {ISA(AVX512F), ISA(AVX512BITALG)}, JIT_EVEX, JIT_ZMM, JIT_RM, 0x66, JIT_0F38, 0x54, 0, 0, NO, 0},
+    {"vpdpbusd zmm, zmm, zmm",    {ISA(AVX512F), ISA(AVX512VNNI)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0x50, 0, 0, NO, 0},
+    {"vpmadd52luq zmm, zmm, zmm", {ISA(AVX512F), ISA(AVX512IFMA)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0xb4, 1, 0, NO, 0},
+    {"vpermb zmm, zmm, zmm",      {ISA(AVX512F), ISA(AVX512VBMI)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0x8d, 0, 0, NO, 0},
+    {"vpshldd zmm, zmm, zmm, imm8",  {ISA(AVX512F), ISA(AVX512VBMI2)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F3A, 0x71, 0, 0, 3, 0},
+    {"vaesenc zmm, zmm, zmm",     {ISA(AVX512F), ISA(VAES)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F38, 0xdc, 0, 0, NO, 0},
+    {"vpclmulqdq zmm, zmm, zmm, imm8", {ISA(AVX512F), ISA(VPCLMULQDQ)}, JIT_EVEX, JIT_ZMM, JIT_NDS, 0x66, JIT_0F3A, 0x44, 0, 0, 0x00, 0},
+};
+
+const size_t jit_spec_cnt = sizeof(jit_specs) / sizeof(jit_specs[0]);
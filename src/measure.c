@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+
+#define MAD_SCALE 1.4826     //MAD of a normal distribution times MAD_SCALE equals its stddev
+#define MAD_THRESHOLD 3.5    //modified z-score above which a sample counts as outlier
+#define Z_95 1.96
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+//returns the p-th percentile (0..1) of a sorted array by linear interpolation
+static double percentile(const double *sorted, uint32_t n, double p) {
+    double pos = p * (n - 1);
+    uint32_t lo = (uint32_t) pos;
+    uint32_t hi = lo + 1 < n ? lo + 1 : lo;
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+//sorts samples, drops outliers in place and fills result from the remaining ones
+//scratch needs room for n doubles
+static void evaluate(double *samples, uint32_t n, double *scratch, struct measure_result *result) {
+    qsort(samples, n, sizeof(samples[0]), compare_double);
+    double median = percentile(samples, n, 0.5);
+
+    for(uint32_t i=0; i<n; i++) {
+        scratch[i] = fabs(samples[i] - median);
+    }
+    qsort(scratch, n, sizeof(scratch[0]), compare_double);
+    double mad = percentile(scratch, n, 0.5) * MAD_SCALE;
+
+    //samples are sorted, so the inliers form one contiguous range
+    uint32_t first = 0, last = n;
+    if(mad > 0.0) {
+        while(first < n && (median - samples[first]) / mad > MAD_THRESHOLD) first++;
+        while(last > first && (samples[last - 1] - median) / mad > MAD_THRESHOLD) last--;
+    }
+    double *kept = samples + first;
+    uint32_t cnt = last - first;
+
+    double sum = 0.0;
+    for(uint32_t i=0; i<cnt; i++) {
+        sum += kept[i];
+    }
+    double mean = sum / cnt;
+    double sq_sum = 0.0;
+    for(uint32_t i=0; i<cnt; i++) {
+        sq_sum += (kept[i] - mean) * (kept[i] - mean);
+    }
+
+    result->samples = n;
+    result->outliers = n - cnt;
+    result->min = kept[0];
+    result->median = percentile(kept, cnt, 0.5);
+    result->mean = mean;
+    result->p90 = percentile(kept, cnt, 0.90);
+    result->p99 = percentile(kept, cnt, 0.99);
+    result->stddev = cnt > 1 ? sqrt(sq_sum / (cnt - 1)) : 0.0;
+    result->ci95 = Z_95 * result->stddev / sqrt(cnt);
+    result->rel_error = result->median > 0.0 ? result->ci95 / result->median : 0.0;
+}
+
+void measure_default_config(struct measure_config *config) {
+    config->warmup = 1000;
+    config->min_samples = 100;
+    config->max_samples = 100000;
+    config->target_rel_error = 0.01;
+    config->max_seconds = 2.0;
+    config->counters = NULL;
+}
+
+//runs kernel until the relative error of the median drops below the target or a limit is hit
+//returns 0 on success and -1 if the sample buffers could not be allocated
+int measure_run(const struct measure_kernel *kernel, const struct measure_config *config,
+                struct measure_result *result) {
+    uint32_t max_samples = config->max_samples > config->min_samples ? config->max_samples : config->min_samples;
+    double *samples = malloc(sizeof(double) * max_samples);
+    double *scratch = malloc(sizeof(double) * max_samples);
+    if(samples == NULL || scratch == NULL) {
+        free(samples);
+        free(scratch);
+        return -1;
+    }
+
+    //warmup may use a tenth of the time budget, large kernels would spend seconds on it otherwise
+    const uint64_t warmup_deadline = clock_ns() + (uint64_t) (config->max_seconds * 1e8);
+    for(uint32_t i=0; i<config->warmup && clock_ns() < warmup_deadline; i++) {
+        if(kernel->prepare) kernel->prepare(kernel->ctx);
+        kernel->run(kernel->ctx);
+    }
+
+    const uint64_t deadline = clock_ns() + (uint64_t) (config->max_seconds * 1e9);
+    uint32_t n = 0;
+    uint32_t next_check = config->min_samples > 0 ? config->min_samples : 1;
+    memset(result, 0, sizeof(*result));
+
+    if(config->counters) counters_reset(config->counters);
+    while(n < max_samples) {
+        if(kernel->prepare) kernel->prepare(kernel->ctx);
+        if(config->counters) counters_start(config->counters);
+        uint64_t start = timing_start();
+        kernel->run(kernel->ctx);
+        uint64_t stop = timing_stop();
+        if(config->counters) counters_stop(config->counters);
+        samples[n++] = timing_to_ns((double) timing_elapsed(start, stop)) / kernel->ops;
+
+        bool expired = clock_ns() >= deadline;
+        if(n == next_check || n == max_samples || expired) {
+            //sample order carries no information, so sorting in place is fine
+            evaluate(samples, n, scratch, result);
+            if(result->rel_error <= config->target_rel_error || expired) {
+                break;
+            }
+            next_check = n + (config->min_samples > 0 ? config->min_samples : 1);
+        }
+    }
+
+    if(config->counters && counters_read(config->counters, &result->counters) == 0) {
+        result->counted = true;
+        result->counters.ops = (uint64_t) n * kernel->ops;
+    }
+
+    free(samples);
+    free(scratch);
+    return 0;
+}
@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef MEASURE
+#define MEASURE
+#include <stdint.h>
+#include <stdbool.h>
+#include "counters.h"
+
+//a benchmark kernel as seen by the measurement engine
+struct measure_kernel {
+    void (*prepare)(void *ctx); //optional, called before every sample outside of the timed region
+    void (*run)(void *ctx);     //timed region of one sample
+    void *ctx;                  //passed to prepare and run
+    uint64_t ops;               //operations executed by one call of run
+};
+
+struct measure_config {
+    uint32_t warmup;          //untimed calls of run before sampling starts
+    uint32_t min_samples;     //samples taken before the error is checked the first time
+    uint32_t max_samples;     //hard limit of samples per kernel
+    double target_rel_error;  //stop once ci95 / median drops below this value
+    double max_seconds;       //stop after this much wall time even if the target is not reached
+    struct counters *counters; //optional, counted around the timed region of every sample
+};
+
+//all values except samples/outliers are in ns per operation
+struct measure_result {
+    uint32_t samples;   //samples taken
+    uint32_t outliers;  //samples rejected by the MAD filter
+    double min;
+    double median;
+    double mean;
+    double p90;
+    double p99;
+    double stddev;
+    double ci95;        //half width of the 95% confidence interval of the mean
+    double rel_error;   //ci95 / median
+    bool counted;       //counters holds the events of all samples, outliers included
+    struct counter_values counters;
+};
+
+void measure_default_config(struct measure_config *config);
+int measure_run(const struct measure_kernel *kernel, const struct measure_config *config,
+                struct measure_result *result);
+
+#endif
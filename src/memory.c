@@ -0,0 +1,217 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "parallel.h"
+#include "memory.h"
+
+#define PTRS_PER_LINE (MEMORY_LINE / sizeof(void *))
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+//links all cache lines of buf into one cycle in random order, so neither the prefetchers
+//nor the out-of-order engine can run ahead of the chain
+void chase_build(void **buf, size_t bytes, struct rng *rng) {
+    size_t lines = bytes / MEMORY_LINE;
+    uint32_t *order = malloc(lines * sizeof(*order));
+
+    if(order == NULL) {
+        //sequential fallback still measures a dependent load per line
+        for(size_t i=0; i<lines; i++) {
+            buf[i * PTRS_PER_LINE] = &buf[((i + 1) % lines) * PTRS_PER_LINE];
+        }
+        return;
+    }
+    for(size_t i=0; i<lines; i++) {
+        order[i] = (uint32_t) i;
+    }
+    for(size_t i=lines - 1; i>0; i--) {
+        size_t k = rng_below(rng, i + 1);
+        uint32_t tmp = order[i];
+        order[i] = order[k];
+        order[k] = tmp;
+    }
+    for(size_t i=0; i<lines; i++) {
+        buf[order[i] * PTRS_PER_LINE] = &buf[order[(i + 1) % lines] * PTRS_PER_LINE];
+    }
+    free(order);
+}
+
+void chase_run(void *arg) {
+    struct chase_ctx *ctx = arg;
+    void **p = ctx->pos;
+
+    for(uint32_t i=0; i<CHASE_STEPS; i+=8) {
+        p = *p; p = *p; p = *p; p = *p;
+        p = *p; p = *p; p = *p; p = *p;
+    }
+    ctx->pos = p;
+}
+
+//SSE2 is part of the x86-64 baseline, so these kernels need no dispatch
+void stream_read(void *arg) {
+    struct stream_ctx *ctx = arg;
+    const __m128i *src = (const __m128i *) ctx->buf;
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    __m128i acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+
+    for(size_t i=0; i<ctx->bytes / sizeof(__m128i); i+=4) {
+        acc0 = _mm_xor_si128(acc0, _mm_load_si128(src + i));
+        acc1 = _mm_xor_si128(acc1, _mm_load_si128(src + i + 1));
+        acc2 = _mm_xor_si128(acc2, _mm_load_si128(src + i + 2));
+        acc3 = _mm_xor_si128(acc3, _mm_load_si128(src + i + 3));
+    }
+    acc0 = _mm_xor_si128(_mm_xor_si128(acc0, acc1), _mm_xor_si128(acc2, acc3));
+    ctx->sink += (uint64_t) _mm_cvtsi128_si64(acc0);
+}
+
+void stream_write(void *arg) {
+    struct stream_ctx *ctx = arg;
+    __m128i *dst = (__m128i *) ctx->buf;
+    const __m128i val = _mm_set1_epi64x((long long) ctx->sink);
+
+    for(size_t i=0; i<ctx->bytes / sizeof(__m128i); i+=4) {
+        _mm_store_si128(dst + i, val);
+        _mm_store_si128(dst + i + 1, val);
+        _mm_store_si128(dst + i + 2, val);
+        _mm_store_si128(dst + i + 3, val);
+    }
+    ctx->sink++;
+}
+
+void stream_copy(void *arg) {
+    struct stream_ctx *ctx = arg;
+    const size_t half = ctx->bytes / 2 / sizeof(__m128i);
+    const __m128i *src = (const __m128i *) ctx->buf;
+    __m128i *dst = (__m128i *) ctx->buf + half;
+
+    for(size_t i=0; i<half; i+=4) {
+        _mm_store_si128(dst + i, _mm_load_si128(src + i));
+        _mm_store_si128(dst + i + 1, _mm_load_si128(src + i + 1));
+        _mm_store_si128(dst + i + 2, _mm_load_si128(src + i + 2));
+        _mm_store_si128(dst + i + 3, _mm_load_si128(src + i + 3));
+    }
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//prints a marker for every cache level whose size lies in (prev, bytes]
+static void print_boundaries(const struct cpu_topology *topology, size_t prev, size_t bytes) {
+    for(uint8_t level=1; level<=4; level++) {
+        const struct cache_info *cache = topology_cache(topology, level);
+        if(cache != NULL && cache->size > prev && cache->size <= bytes) {
+            printf("  ---- L%u: %u KiB ----\r\n", level, cache->size >> 10);
+        }
+    }
+}
+
+//measures one single-threaded kernel, result in ns per op
+static double measure_single(bench_fn run, void *ctx, uint64_t ops, const struct measure_config *config) {
+    struct measure_kernel kernel = {NULL, run, ctx, ops};
+    struct measure_result result;
+    return measure_run(&kernel, config, &result) == 0 ? result.median : 0.0;
+}
+
+//same kernel on every CPU with a private buffer of the same size, returns GB/s in total (0 on failure)
+static double measure_all_cores(const struct bench_env *env, bench_fn run, struct stream_ctx *ctxs,
+                                struct worker *workers, const uint32_t *order, uint64_t bytes_per_run) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    struct parallel_result result;
+
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        workers[i].run = run;
+        workers[i].prepare = NULL;
+        workers[i].ctx = &ctxs[i];
+        workers[i].ops = bytes_per_run;
+    }
+    //ops are bytes, so Mops/s are MB/s
+    return parallel_measure(workers, topology->cpu_cnt, topology, order, &result) == 0 ? result.total / 1e3 : 0.0;
+}
+
+//load-to-use latency and read/write/copy bandwidth for every working set size from
+//MEMORY_MIN_BYTES to MEMORY_MAX_BYTES, with the cache boundaries from CPUID marked
+int memory_suite(const struct bench_env *env) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    const uint32_t cpu_cnt = topology->cpu_cnt;
+    struct arena *arena = &env->corpus->arena;
+    struct stream_ctx stream;
+    struct chase_ctx chase;
+    int status = 0;
+
+    uint8_t *buf = arena_alloc(arena, MEMORY_MAX_BYTES);
+    struct stream_ctx *ctxs = calloc(cpu_cnt, sizeof(*ctxs));
+    struct worker *workers = calloc(cpu_cnt, sizeof(*workers));
+    uint32_t *order = calloc(cpu_cnt, sizeof(*order));
+    if(buf == NULL || ctxs == NULL || workers == NULL || order == NULL) {
+        status = -1;
+        goto out;
+    }
+    placement_order(topology, PLACEMENT_SPREAD, order);
+
+    printf("Bandwidth in GB/s, the all-* columns run on all %u CPUs with a private buffer each:\r\n", cpu_cnt);
+    printf("%10s %10s %10s %10s %10s %10s  | %10s %10s %10s\r\n", "size", "lat ns", "lat cyc",
+           "read", "write", "copy", "all-read", "all-write", "all-copy");
+    for(size_t bytes=MEMORY_MIN_BYTES, prev=0; bytes<=MEMORY_MAX_BYTES; prev=bytes, bytes*=2) {
+        print_boundaries(topology, prev, bytes);
+
+        chase_build((void **) buf, bytes, &env->corpus->rng);
+        chase.pos = (void **) buf;
+        double latency = measure_single(chase_run, &chase, CHASE_STEPS, env->config);
+
+        stream.buf = buf;
+        stream.bytes = bytes;
+        stream.sink = 0;
+        double read = measure_single(stream_read, &stream, bytes, env->config);
+        double write = measure_single(stream_write, &stream, bytes, env->config);
+        double copy = measure_single(stream_copy, &stream, bytes / 2, env->config);
+        printf("%6zu %s %10.2f %10.1f %10.2f %10.2f %10.2f  |", bytes >= ((size_t) 1 << 20) ? bytes >> 20 : bytes >> 10,
+               bytes >= ((size_t) 1 << 20) ? "MiB" : "KiB", latency, latency * timer_info.cycles_per_ns,
+               read > 0.0 ? 1.0 / read : 0.0, write > 0.0 ? 1.0 / write : 0.0, copy > 0.0 ? 1.0 / copy : 0.0);
+
+        //private buffers per CPU, released again before the next size
+        size_t mark = arena->used;
+        bool allocated = true;
+        for(uint32_t i=0; i<cpu_cnt && allocated; i++) {
+            ctxs[i].buf = arena_alloc(arena, bytes);
+            ctxs[i].bytes = bytes;
+            allocated = ctxs[i].buf != NULL;
+            if(allocated) memset(ctxs[i].buf, 0, bytes); //commit the pages before timing
+        }
+        if(allocated) {
+            printf(" %10.2f %10.2f %10.2f\r\n", measure_all_cores(env, stream_read, ctxs, workers, order, bytes),
+                   measure_all_cores(env, stream_write, ctxs, workers, order, bytes),
+                   measure_all_cores(env, stream_copy, ctxs, workers, order, bytes / 2));
+        } else {
+            printf(" not enough memory\r\n");
+        }
+        arena->used = mark;
+        fflush(stdout);
+    }
+
+out:
+    free(ctxs);
+    free(workers);
+    free(order);
+    return status;
+}
@@ -0,0 +1,43 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef MEMORY
+#define MEMORY
+#include <stdint.h>
+#include <stddef.h>
+
+#define MEMORY_MIN_BYTES ((size_t) 4 << 10)
+#define MEMORY_MAX_BYTES ((size_t) 256 << 20)
+#define MEMORY_LINE 64
+#define CHASE_STEPS 16384 //dependent loads per latency sample
+
+//pointer chase through a randomly ordered cycle of cache lines
+struct chase_ctx {
+    void **pos;
+};
+
+//buffer for the bandwidth kernels, copy uses the first half as source and the second as destination
+struct stream_ctx {
+    uint8_t *buf;
+    size_t bytes;
+    uint64_t sink;
+};
+
+struct rng;
+void chase_build(void **buf, size_t bytes, struct rng *rng);
+void chase_run(void *ctx);
+void stream_read(void *ctx);
+void stream_write(void *ctx);
+void stream_copy(void *ctx);
+
+struct bench_env;
+int memory_suite(const struct bench_env *env);
+
+#endif
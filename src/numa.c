@@ -0,0 +1,302 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//NUMA placement: a thread pinned to a CPU of every node reads memory bound to every node, the latency and
+//bandwidth matrices next to the SLIT distances show what a remote access costs on this machine
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "cpuinfo.h"
+#include "topology.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "parallel.h"
+#include "memory.h"
+#include "numa.h"
+
+#define NODE_MASK_LONGS (CPU_SETSIZE / (8 * sizeof(unsigned long)))
+
+//libnuma is not linked, mbind and get_mempolicy go through syscall()
+static long sys_mbind(void *addr, size_t len, int mode, const unsigned long *mask, unsigned long maxnode,
+                      unsigned flags) {
+    return syscall(SYS_mbind, addr, len, mode, mask, maxnode, flags);
+}
+
+//node the page at addr was allocated on, -1 if unknown
+static int page_node(void *addr) {
+    int node = -1;
+    if(syscall(SYS_get_mempolicy, &node, NULL, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+//***********************************************
+//*******************MAPPINGS********************
+//***********************************************
+
+void *numa_alloc_on(size_t bytes, uint32_t node, bool unbound_ok, bool *bound) {
+    unsigned long mask[NODE_MASK_LONGS] = {0};
+    if(node >= CPU_SETSIZE) {
+        return NULL;
+    }
+    void *buf = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(buf == MAP_FAILED) {
+        return NULL;
+    }
+    mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    //maxnode counts one bit more than the kernel reads
+    *bound = sys_mbind(buf, bytes, MPOL_BIND, mask, CPU_SETSIZE + 1, MPOL_MF_STRICT) == 0;
+    //containers without CAP_SYS_NICE get EPERM from the default seccomp profile, kernels without NUMA ENOSYS
+    if(!*bound && !unbound_ok && errno != ENOSYS && errno != EPERM) {
+        munmap(buf, bytes);
+        return NULL;
+    }
+    memset(buf, 0, bytes); //fault every page in (on the bound node) before timing
+    return buf;
+}
+
+void numa_free(void *buf, size_t bytes) {
+    munmap(buf, bytes);
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//measurements of one (CPU node, memory node) pair, 0 where it could not be measured
+struct numa_pair {
+    double latency;     //ns per dependent load
+    double single;      //GB/s of one thread
+    double node;        //GB/s of all CPUs of the CPU node together
+};
+
+//first CPU of node id this process may run on, -1 if there is none
+static int topology_node_cpu(const struct cpu_topology *topology, uint32_t id) {
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        if(topology->cpus[i].node == id) {
+            return (int) topology->cpus[i].cpu;
+        }
+    }
+    return -1;
+}
+
+static int pin_thread(uint32_t cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+//latency and single thread bandwidth from the first CPU of cpu_node, then all its CPUs reading a slice each
+static int measure_pair(const struct bench_env *env, const struct measure_config *config, uint32_t cpu_node,
+                        uint8_t *buf, struct worker *workers, struct stream_ctx *ctxs, uint32_t *order,
+                        struct numa_pair *pair) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    struct measure_result result;
+    struct parallel_result parallel;
+    uint32_t threads = 0;
+
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        if(topology->cpus[i].node == cpu_node) {
+            order[threads++] = i;
+        }
+    }
+    if(threads == 0 || pin_thread(topology->cpus[order[0]].cpu) != 0) {
+        return -1;
+    }
+
+    struct chase_ctx chase = {(void **) buf};
+    struct measure_kernel kernel = {NULL, chase_run, &chase, CHASE_STEPS};
+    if(measure_run(&kernel, config, &result) != 0) {
+        return -1;
+    }
+    pair->latency = result.median;
+
+    struct stream_ctx stream = {buf, NUMA_BYTES, 0};
+    kernel = (struct measure_kernel) {NULL, stream_read, &stream, NUMA_BYTES};
+    if(measure_run(&kernel, config, &result) != 0) {
+        return -1;
+    }
+    pair->single = 1.0 / result.median;
+
+    //slices stay multiples of a line, every thread streams its own part of the node's buffer
+    const size_t slice = NUMA_BYTES / threads & ~(size_t) (MEMORY_LINE - 1);
+    for(uint32_t i=0; i<threads; i++) {
+        ctxs[i] = (struct stream_ctx) {buf + i * slice, slice, 0};
+        workers[i].run = stream_read;
+        workers[i].prepare = NULL;
+        workers[i].ctx = &ctxs[i];
+        workers[i].ops = slice;
+    }
+    if(parallel_measure(workers, threads, topology, order, &parallel) != 0) {
+        return -1;
+    }
+    pair->node = parallel.total / 1e3; //ops are bytes, so Mops/s are MB/s
+    return 0;
+}
+
+//"node<id>" padded to width, negative widths align left
+static void print_node(uint32_t id, int width) {
+    char label[16];
+    snprintf(label, sizeof(label), "node%u", id);
+    printf("%*s", width, label);
+}
+
+//one matrix, rows are CPU nodes and columns memory nodes; field selects latency, single or node
+static void print_matrix(const struct cpu_topology *topology, const struct numa_pair *pairs, const char *title,
+                         size_t field, const char *format) {
+    const uint32_t n = topology->node_cnt;
+    printf("%s\r\n%-10s", title, "cpu\\mem");
+    for(uint32_t m=0; m<n; m++) {
+        print_node(topology->nodes[m].id, 12);
+    }
+    printf("\r\n");
+    for(uint32_t c=0; c<n; c++) {
+        if(topology->nodes[c].cpu_cnt == 0) continue;
+        print_node(topology->nodes[c].id, -10);
+        for(uint32_t m=0; m<n; m++) {
+            const double value = *(const double *) ((const uint8_t *) &pairs[c * n + m] + field);
+            if(value == 0.0) {
+                printf("%12s", "-");
+            } else {
+                printf(format, value);
+            }
+        }
+        printf("\r\n");
+    }
+}
+
+//average local value against the worst remote one, only on machines with more than one node
+static void print_penalty(const struct cpu_topology *topology, const struct numa_pair *pairs) {
+    const uint32_t n = topology->node_cnt;
+    double local_lat = 0.0, local_bw = 0.0, remote_lat = 0.0, remote_bw = 0.0;
+    uint32_t local = 0;
+
+    for(uint32_t c=0; c<n; c++) {
+        for(uint32_t m=0; m<n; m++) {
+            const struct numa_pair *pair = &pairs[c * n + m];
+            if(pair->latency == 0.0) continue;
+            if(c == m) {
+                local_lat += pair->latency;
+                local_bw += pair->node;
+                local++;
+            } else {
+                remote_lat = pair->latency > remote_lat ? pair->latency : remote_lat;
+                remote_bw = (remote_bw == 0.0 || pair->node < remote_bw) ? pair->node : remote_bw;
+            }
+        }
+    }
+    if(local > 0 && remote_lat > 0.0) {
+        printf("Worst remote pair against the local average: latency x%.2f, node bandwidth x%.2f\r\n",
+               remote_lat / (local_lat / local), remote_bw / (local_bw / local));
+    }
+}
+
+//latency, single thread and node-wide read bandwidth for every (CPU node, memory node) pair with the memory
+//bound by mbind, plus the distance matrix; a machine without NUMA reports its single node
+int numa_suite(const struct bench_env *env) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    const uint32_t n = topology->node_cnt;
+    struct measure_config config = *env->config;
+    cpu_set_t saved;
+
+    if(pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) != 0) {
+        return -1;
+    }
+    struct numa_pair *pairs = calloc((size_t) n * n, sizeof(*pairs));
+    struct worker *workers = calloc(topology->cpu_cnt, sizeof(*workers));
+    struct stream_ctx *ctxs = calloc(topology->cpu_cnt, sizeof(*ctxs));
+    uint32_t *order = calloc(topology->cpu_cnt, sizeof(*order));
+    int status = 0;
+    if(pairs == NULL || workers == NULL || ctxs == NULL || order == NULL) {
+        status = -1;
+        goto out;
+    }
+    config.max_seconds = config.max_seconds < NUMA_POINT_SECONDS ? config.max_seconds : NUMA_POINT_SECONDS;
+
+    if(n == 1) {
+        printf("Single NUMA node, only local memory is measured\r\n");
+    }
+    printf("Node distances (SLIT, 10 is local):\r\n%10s", "");
+    for(uint32_t m=0; m<n; m++) {
+        print_node(topology->nodes[m].id, 9);
+    }
+    printf("\r\n");
+    for(uint32_t c=0; c<n; c++) {
+        print_node(topology->nodes[c].id, -10);
+        for(uint32_t m=0; m<n; m++) {
+            printf("%9u", topology->nodes[c].distance[m]);
+        }
+        printf("  %u CPUs%s\r\n", topology->nodes[c].cpu_cnt, topology->nodes[c].memory ? "" : ", no memory");
+    }
+
+    for(uint32_t m=0; m<n && status==0; m++) {
+        const struct numa_node *mem = &topology->nodes[m];
+        if(!mem->memory) continue;
+        //unbound pages land where they are first touched, so the allocating thread runs on the node if it can
+        const int local = topology_node_cpu(topology, mem->id);
+        if(local >= 0 && pin_thread((uint32_t) local) != 0) {
+            status = -1;
+            break;
+        }
+        bool bound;
+        uint8_t *buf = numa_alloc_on(NUMA_BYTES, mem->id, n == 1, &bound);
+        if(buf == NULL) {
+            printf("node %u: could not bind %zu MiB, skipped\r\n", mem->id, NUMA_BYTES >> 20);
+            continue;
+        }
+        if(!bound) {
+            printf("node %u: mbind failed (%s), pages placed by first touch%s\r\n", mem->id, strerror(errno),
+                   local >= 0 ? " from a CPU of the node" : ", placement unknown");
+        }
+        int placed = page_node(buf);
+        if(placed >= 0 && (uint32_t) placed != mem->id) {
+            printf("node %u: pages landed on node %d, skipped\r\n", mem->id, placed);
+            numa_free(buf, NUMA_BYTES);
+            continue;
+        }
+        chase_build((void **) buf, NUMA_BYTES, &env->corpus->rng);
+        for(uint32_t c=0; c<n && status==0; c++) {
+            if(topology->nodes[c].cpu_cnt == 0) continue;
+            status = measure_pair(env, &config, topology->nodes[c].id, buf, workers, ctxs, order, &pairs[c * n + m]);
+        }
+        numa_free(buf, NUMA_BYTES);
+        printf("memory node %u measured\r\n", mem->id);
+        fflush(stdout);
+    }
+    if(status == 0) {
+        print_matrix(topology, pairs, "Load-to-use latency in ns:", offsetof(struct numa_pair, latency), "%12.1f");
+        print_matrix(topology, pairs, "Read bandwidth of one thread in GB/s:", offsetof(struct numa_pair, single),
+                     "%12.2f");
+        print_matrix(topology, pairs, "Read bandwidth of all CPUs of the node in GB/s:",
+                     offsetof(struct numa_pair, node), "%12.2f");
+        print_penalty(topology, pairs);
+    }
+
+out:
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    free(pairs);
+    free(workers);
+    free(ctxs);
+    free(order);
+    return status;
+}
@@ -0,0 +1,29 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef NUMA
+#define NUMA
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define NUMA_BYTES ((size_t) 256 << 20)   //buffer per memory node, far beyond any last level cache
+#define NUMA_POINT_SECONDS 0.5            //time budget per measurement of a (CPU node, memory node) pair
+
+//mmap'd buffer whose pages are bound to one node with mbind(MPOL_BIND) and faulted in, *bound tells whether
+//the binding took; without NUMA support (ENOSYS), without permission (EPERM) or with unbound_ok the buffer is
+//placed by first touch instead, any other refusal returns NULL
+void *numa_alloc_on(size_t bytes, uint32_t node, bool unbound_ok, bool *bound);
+void numa_free(void *buf, size_t bytes);
+
+struct bench_env;
+int numa_suite(const struct bench_env *env);
+
+#endif
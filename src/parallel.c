@@ -0,0 +1,226 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "registry.h"
+#include "parallel.h"
+
+#define CPUS_PER_LINE 8
+
+static const struct cpu_topology *sort_topology;
+
+static int compare_spread(const void *a, const void *b) {
+    const struct logical_cpu *x = &sort_topology->cpus[*(const uint32_t *) a];
+    const struct logical_cpu *y = &sort_topology->cpus[*(const uint32_t *) b];
+    if(x->smt != y->smt) return x->smt < y->smt ? -1 : 1;
+    if(x->package != y->package) return x->package < y->package ? -1 : 1;
+    return (x->core > y->core) - (x->core < y->core);
+}
+
+static int compare_packed(const void *a, const void *b) {
+    const struct logical_cpu *x = &sort_topology->cpus[*(const uint32_t *) a];
+    const struct logical_cpu *y = &sort_topology->cpus[*(const uint32_t *) b];
+    if(x->package != y->package) return x->package < y->package ? -1 : 1;
+    if(x->core != y->core) return x->core < y->core ? -1 : 1;
+    return (x->smt > y->smt) - (x->smt < y->smt);
+}
+
+//fills order with indices into topology->cpus in placement order, returns their number
+uint32_t placement_order(const struct cpu_topology *topology, enum placement placement, uint32_t *order) {
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        order[i] = i;
+    }
+    sort_topology = topology;
+    qsort(order, topology->cpu_cnt, sizeof(*order), placement == PLACEMENT_SPREAD ? compare_spread : compare_packed);
+    return topology->cpu_cnt;
+}
+
+static void *worker_main(void *arg) {
+    struct worker *worker = arg;
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    worker->pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+
+    //spinning instead of sleeping in a pthread barrier lets all workers start within a few hundred cycles
+    atomic_fetch_add(worker->ready, 1);
+    while(!atomic_load_explicit(worker->go, memory_order_acquire)) {
+        __builtin_ia32_pause();
+    }
+    uint64_t start = clock_ns();
+    uint64_t done = 0;
+    while(worker->pinned && !atomic_load_explicit(worker->stop, memory_order_relaxed)) {
+        if(worker->prepare) worker->prepare(worker->ctx);
+        worker->run(worker->ctx);
+        done += worker->ops;
+    }
+    worker->elapsed_ns = clock_ns() - start;
+    worker->done = done;
+    return NULL;
+}
+
+//runs the first threads workers pinned to the first CPUs of order for PARALLEL_WINDOW_NS
+//run, prepare, ctx and ops of every worker have to be set by the caller, returns -1 if a thread failed to start
+//or could not be pinned to its CPU, the numbers would not belong to the placement they are reported under
+int parallel_measure(struct worker *workers, uint32_t threads, const struct cpu_topology *topology,
+                     const uint32_t *order, struct parallel_result *result) {
+    atomic_uint ready = 0;
+    atomic_bool go = false;
+    atomic_bool stop = false;
+    struct timespec window = {PARALLEL_WINDOW_NS / 1000000000ull, PARALLEL_WINDOW_NS % 1000000000ull};
+    uint32_t started = 0;
+
+    for(; started<threads; started++) {
+        workers[started].cpu = topology->cpus[order[started]].cpu;
+        workers[started].ready = &ready;
+        workers[started].go = &go;
+        workers[started].stop = &stop;
+        if(pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) {
+            break;
+        }
+    }
+    if(started < threads) {
+        //release the workers that did start straight into their stop check
+        atomic_store(&stop, true);
+        atomic_store(&go, true);
+        for(uint32_t i=0; i<started; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        return -1;
+    }
+
+    while(atomic_load(&ready) < threads) {
+        sched_yield(); //the main thread may share its CPU with a worker
+    }
+    atomic_store_explicit(&go, true, memory_order_release);
+    nanosleep(&window, NULL);
+    atomic_store(&stop, true);
+
+    result->total = result->min = result->max = 0.0;
+    bool pinned = true;
+    for(uint32_t i=0; i<threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        double mops = workers[i].mops = (double) workers[i].done / (double) workers[i].elapsed_ns * 1e3;
+        pinned = pinned && workers[i].pinned;
+        result->total += mops;
+        result->min = (i == 0 || mops < result->min) ? mops : result->min;
+        result->max = (i == 0 || mops > result->max) ? mops : result->max;
+    }
+    return pinned ? 0 : -1;
+}
+
+//1, 2, 4, ... threads and finally all CPUs
+uint32_t parallel_next_threads(uint32_t threads, uint32_t cpu_cnt) {
+    if(threads == cpu_cnt) return 0;
+    return threads * 2 < cpu_cnt ? threads * 2 : cpu_cnt;
+}
+
+//total and range on the first line, then every thread as cpu and Mops/s
+static void print_parallel_result(const struct worker *workers, uint32_t threads, const struct parallel_result *result) {
+    printf("%12.1f Mops/s (%8.1f .. %8.1f per thread)\r\n", result->total, result->min, result->max);
+    for(uint32_t i=0; i<threads; i++) {
+        printf("%s cpu %3u %8.1f", i % CPUS_PER_LINE == 0 ? "             " : ",", workers[i].cpu, workers[i].mops);
+        if(i % CPUS_PER_LINE == CPUS_PER_LINE - 1 || i + 1 == threads) {
+            printf("\r\n");
+        }
+    }
+}
+
+//scaling of one entry over thread counts, spread vs packed placement
+
+static int parallel_entry(const struct bench_env *env, const struct bench_entry *entry) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    const uint32_t cpu_cnt = topology->cpu_cnt;
+    const bool smt = env->cpu_info->CORES_LOGICAL > env->cpu_info->CORES_PHYSICAL;
+    struct parallel_result result;
+    bool emulated;
+    bench_fn run = registry_resolve(entry, env->cpu_info, &emulated);
+    if(run == NULL) {
+        printf("%s: unsupported, skipped\r\n", entry->name);
+        return 0;
+    }
+
+    struct worker *workers = calloc(cpu_cnt, sizeof(*workers));
+    uint32_t *spread = calloc(cpu_cnt, sizeof(*spread));
+    uint32_t *packed = calloc(cpu_cnt, sizeof(*packed));
+    int status = 0;
+    if(workers == NULL || spread == NULL || packed == NULL) {
+        status = -1;
+        goto out;
+    }
+
+    //every worker gets its own ctx, so results are never written to a shared cache line
+    corpus_reset(env->corpus);
+    for(uint32_t i=0; i<cpu_cnt; i++) {
+        uint64_t ops = 1;
+        workers[i].ctx = entry->setup ? entry->setup(env, &ops) : NULL;
+        if(entry->setup && workers[i].ctx == NULL) {
+            status = -1;
+            goto teardown;
+        }
+        workers[i].run = run;
+        workers[i].prepare = entry->prepare;
+        workers[i].ops = ops;
+    }
+    placement_order(topology, PLACEMENT_SPREAD, spread);
+    placement_order(topology, PLACEMENT_PACKED, packed);
+
+    printf("%s%s scaling over %u CPUs (%u cores):\r\n", entry->name, emulated ? " (emulated)" : "",
+           cpu_cnt, env->cpu_info->CORES_PHYSICAL);
+    for(uint32_t threads=1; threads!=0 && status==0; threads=parallel_next_threads(threads, cpu_cnt)) {
+        printf("%4u threads  spread:", threads);
+        status = parallel_measure(workers, threads, topology, spread, &result);
+        if(status == 0) print_parallel_result(workers, threads, &result);
+        if(status == 0 && smt && threads > 1) {
+            printf("%21s", "packed (SMT):");
+            status = parallel_measure(workers, threads, topology, packed, &result);
+            if(status == 0) print_parallel_result(workers, threads, &result);
+        }
+        if(status != 0) printf(" a worker could not be started or pinned\r\n");
+        fflush(stdout);
+    }
+
+teardown:
+    for(uint32_t i=0; i<cpu_cnt && entry->teardown; i++) {
+        if(workers[i].ctx) entry->teardown(workers[i].ctx);
+    }
+out:
+    free(workers);
+    free(spread);
+    free(packed);
+    return status;
+}
+
+//runs the scaling study for every selected entry, returns the number of entries that failed
+int parallel_run(const struct bench_env *env, char *const patterns[], size_t pattern_cnt) {
+    int failed = 0;
+
+    for(size_t i=0; i<bench_registry_cnt; i++) {
+        if(!registry_selected(&bench_registry[i], patterns, pattern_cnt)) {
+            continue;
+        }
+        if(parallel_entry(env, &bench_registry[i]) != 0) {
+            printf("%s: parallel run failed\r\n", bench_registry[i].name);
+            failed++;
+        }
+    }
+    return failed;
+}
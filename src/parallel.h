@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef PARALLEL
+#define PARALLEL
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "registry.h"
+
+#define PARALLEL_WINDOW_NS 200000000ull //every thread count runs for 200 ms
+
+//order in which logical CPUs are handed to workers
+enum placement {
+    PLACEMENT_SPREAD, //one thread per physical core first, SMT siblings only once all cores are busy
+    PLACEMENT_PACKED  //all SMT siblings of a core before the next core
+};
+
+//one pinned thread of parallel_measure(), run/prepare/ctx/ops are filled in by the caller
+struct worker {
+    pthread_t thread;
+    uint32_t cpu;
+    bench_fn run;
+    void (*prepare)(void *ctx);
+    void *ctx;
+    uint64_t ops;               //operations per call of run
+    atomic_uint *ready;         //start barrier: workers that arrived
+    atomic_bool *go;            //start barrier: released by the main thread
+    atomic_bool *stop;
+    bool pinned;                //false if the thread could not be moved to cpu, it then runs nothing
+    uint64_t done;              //operations completed
+    uint64_t elapsed_ns;
+    double mops;                //throughput of this thread in million operations per second
+};
+
+//throughput of one parallel_measure() in million operations per second
+struct parallel_result {
+    double total;
+    double min;  //slowest thread
+    double max;  //fastest thread
+};
+
+uint32_t placement_order(const struct cpu_topology *topology, enum placement placement, uint32_t *order);
+uint32_t parallel_next_threads(uint32_t threads, uint32_t cpu_cnt);
+int parallel_measure(struct worker *workers, uint32_t threads, const struct cpu_topology *topology,
+                     const uint32_t *order, struct parallel_result *result);
+int parallel_run(const struct bench_env *env, char *const patterns[], size_t pattern_cnt);
+
+#endif
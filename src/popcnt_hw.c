@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//POPCNT variants of the ABM kernels, this translation unit is compiled for POPCNT only
+//nothing in here may be called unless dispatch_supported() confirmed POPCNT
+#pragma GCC target("popcnt")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "abm.h"
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+//Hamming weights and Hamming distance of all operand pairs with POPCNT
+void popcnt_run(void *arg) {
+    struct abm_ctx *ctx = arg;
+
+    for(uint8_t h=0; h<ABM_STRING_CNT; h++) {
+        //Hamming Weight calculation
+        __asm__ volatile ("popcntq %2, %0 \n\t"  //Hamming Weight of first string
+                          "popcntq %3, %1 \n\t" //Hamming Weight of second string
+            :"=&r"(ctx->fir_str_hw[h]), "=r"(ctx->sec_str_hw[h])
+            :"r"(ctx->fir_str_num[h]), "r"(ctx->sec_str_num[h])
+            :
+        );
+
+        //Hamming Distance of first string and second string
+        //Hamming Distance calculation HammingDistance(bitstring, bitstring2) == HammingWeight(bitstring ^ bitstring2)
+        ctx->temp[h] = ctx->fir_str_num[h] ^ ctx->sec_str_num[h];
+        __asm__ volatile ("popcntq %1, %0"
+            :"=r"(ctx->hamming_distance[h])
+            :"r"(ctx->temp[h])
+            :
+        );
+    }
+}
+
+//***********************************************
+//*****************BULK_KERNELS******************
+//***********************************************
+
+uint64_t popcnt_throughput(const uint64_t *data, size_t cnt) {
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t i = 0;
+
+    for(; i + 4 <= cnt; i += 4) {
+        acc0 += _mm_popcnt_u64(data[i]);
+        acc1 += _mm_popcnt_u64(data[i + 1]);
+        acc2 += _mm_popcnt_u64(data[i + 2]);
+        acc3 += _mm_popcnt_u64(data[i + 3]);
+    }
+    for(; i < cnt; i++) {
+        acc0 += _mm_popcnt_u64(data[i]);
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+//the xor with fresh data keeps the operands realistic, it adds one cycle to every link of the chain
+uint64_t popcnt_latency(const uint64_t *data, size_t cnt) {
+    uint64_t x = 0;
+
+    for(size_t i=0; i<cnt; i++) {
+        x = _mm_popcnt_u64(x ^ data[i]);
+    }
+    return x;
+}
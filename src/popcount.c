@@ -0,0 +1,135 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "throughput.h"
+#include "abm.h"
+#include "popcount.h"
+
+#define COLUMN_WIDTH 20
+#define VARIANT_CNT (sizeof(variants) / sizeof(variants[0]))
+
+//lengths around every unroll boundary of the variants, checked from an aligned and a misaligned start
+static const size_t check_lengths[] = {0, 1, 3, 4, 7, 8, 15, 16, 31, 32, 63, 64, 65, 127, 128, 129, 255, 256, 1000, 4099};
+
+//***********************************************
+//*******************REGISTRY********************
+//***********************************************
+
+void *popcount_setup(const struct bench_env *env, uint64_t *ops) {
+    struct popcount_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    if(ctx == NULL) {
+        return NULL;
+    }
+    ctx->data = corpus_u64(env->corpus, POPCOUNT_BLOCK_CNT);
+    ctx->sink = 0;
+    *ops = POPCOUNT_BLOCK_CNT;
+    return ctx->data ? ctx : NULL;
+}
+
+void popcount_run_emulated(void *arg) {
+    struct popcount_ctx *ctx = arg;
+    ctx->sink += popcnt_throughput_emulated(ctx->data, POPCOUNT_BLOCK_CNT);
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+//compares kernel against the SWAR reference for every check length, returns false on a mismatch
+static bool popcount_verify(const struct bulk_kernel *kernel, const uint64_t *data) {
+    for(size_t i=0; i<sizeof(check_lengths) / sizeof(check_lengths[0]); i++) {
+        for(size_t offset=0; offset<2; offset++) {
+            uint64_t expected = popcnt_throughput_emulated(data + offset, check_lengths[i]);
+            uint64_t actual = kernel->fn(data + offset, check_lengths[i]);
+            if(actual != expected) {
+                printf("%s: wrong result for %zu words at offset %zu (%llu instead of %llu), excluded\r\n",
+                       kernel->name, check_lengths[i], offset, (unsigned long long) actual,
+                       (unsigned long long) expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//every popcount variant over buffers from L1 to DRAM size in bytes per (TSC) cycle,
+//recommends the variant with the best geometric mean over all sizes
+int popcount_suite(const struct bench_env *env) {
+    const struct cpu_info *info = env->cpu_info;
+    struct bulk_kernel variants[] = {
+        {"popcnt", popcnt_throughput, dispatch_supported(info, REQUIRES(ISA(POPCNT)))},
+        {"swar", popcnt_throughput_emulated, true},
+        {"avx2-lut", popcount_avx2_lut, dispatch_supported(info, REQUIRES(ISA(AVX2)))},
+        {"avx2-harley-seal", popcount_avx2_harley_seal, dispatch_supported(info, REQUIRES(ISA(AVX2)))},
+        {"avx512-vpopcntq", popcount_avx512_vpopcntq,
+            dispatch_supported(info, REQUIRES(ISA(AVX512F), ISA(AVX512VPOPCNTDQ)))},
+    };
+    double log_sum[VARIANT_CNT] = {0};
+    uint32_t sizes = 0;
+    struct measure_result result;
+
+    const uint64_t *data = corpus_u64(env->corpus, THROUGHPUT_MAX_BYTES / sizeof(uint64_t));
+    if(data == NULL) {
+        return -1;
+    }
+    for(size_t k=0; k<VARIANT_CNT; k++) {
+        if(variants[k].supported) {
+            variants[k].supported = popcount_verify(&variants[k], data);
+        }
+    }
+
+    printf("Popcount in bytes/cycle:\r\n%10s", "size");
+    for(size_t k=0; k<VARIANT_CNT; k++) {
+        printf("%*s", COLUMN_WIDTH, variants[k].name);
+    }
+    printf("\r\n");
+
+    for(size_t bytes=THROUGHPUT_MIN_BYTES; bytes<=THROUGHPUT_MAX_BYTES; bytes*=THROUGHPUT_STEP, sizes++) {
+        printf("%6zu %s", bytes >= ((size_t) 1 << 20) ? bytes >> 20 : bytes >> 10,
+               bytes >= ((size_t) 1 << 20) ? "MiB" : "KiB");
+        for(size_t k=0; k<VARIANT_CNT; k++) {
+            if(!variants[k].supported) {
+                printf("%*s", COLUMN_WIDTH, "-");
+                continue;
+            }
+            if(throughput_measure(&variants[k], data, bytes / sizeof(*data), env->config, &result) != 0) {
+                printf("\r\n");
+                return -1;
+            }
+            double bytes_per_cycle = sizeof(*data) / (result.median * timer_info.cycles_per_ns);
+            log_sum[k] += log(bytes_per_cycle);
+            printf("%*.2f", COLUMN_WIDTH, bytes_per_cycle);
+        }
+        printf("\r\n");
+        fflush(stdout);
+    }
+
+    size_t best = VARIANT_CNT;
+    for(size_t k=0; k<VARIANT_CNT; k++) {
+        if(variants[k].supported && (best == VARIANT_CNT || log_sum[k] > log_sum[best])) {
+            best = k;
+        }
+    }
+    if(best < VARIANT_CNT) {
+        printf("Recommended popcount for this CPU: %s (geometric mean %.2f bytes/cycle)\r\n",
+               variants[best].name, exp(log_sum[best] / sizes));
+    }
+    return 0;
+}
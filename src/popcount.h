@@ -0,0 +1,35 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef POPCOUNT
+#define POPCOUNT
+#include <stdint.h>
+#include <stddef.h>
+
+#define POPCOUNT_BLOCK_CNT 512 //64 bit words per sample of the registry entry (4 KiB, L1 resident)
+
+//bulk popcount over cnt 64 bit words, every variant returns the total number of set bits
+uint64_t popcount_avx2_lut(const uint64_t *data, size_t cnt);
+uint64_t popcount_avx2_harley_seal(const uint64_t *data, size_t cnt);
+uint64_t popcount_avx512_vpopcntq(const uint64_t *data, size_t cnt);
+
+struct popcount_ctx {
+    const uint64_t *data;
+    uint64_t sink;
+};
+
+struct bench_env;
+void *popcount_setup(const struct bench_env *env, uint64_t *ops);
+void avx2_run(void *ctx);
+void vpopcntdq_run(void *ctx);
+void popcount_run_emulated(void *ctx);
+int popcount_suite(const struct bench_env *env);
+
+#endif
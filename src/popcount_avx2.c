@@ -0,0 +1,122 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AVX2 popcount variants, this translation unit is compiled for AVX2
+//nothing in here may be called unless dispatch_supported() confirmed AVX2
+#pragma GCC target("avx2")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "abm.h"
+#include "popcount.h"
+
+#define WORDS_PER_VECTOR 4
+
+//per byte popcount by looking up both nibbles in a 16 entry table (Mula)
+static inline __m256i popcount_bytes(__m256i v) {
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+}
+
+//popcount of every 64 bit lane
+static inline __m256i popcount_lanes(__m256i v) {
+    return _mm256_sad_epu8(popcount_bytes(v), _mm256_setzero_si256());
+}
+
+static inline uint64_t sum_lanes(__m256i v) {
+    return (uint64_t) _mm256_extract_epi64(v, 0) + (uint64_t) _mm256_extract_epi64(v, 1)
+         + (uint64_t) _mm256_extract_epi64(v, 2) + (uint64_t) _mm256_extract_epi64(v, 3);
+}
+
+uint64_t popcount_avx2_lut(const uint64_t *data, size_t cnt) {
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+
+    //byte counters hold at most 8 per vector, so 31 vectors fit before they have to be widened
+    while(i + WORDS_PER_VECTOR <= cnt) {
+        __m256i bytes = _mm256_setzero_si256();
+        for(uint32_t k=0; k<31 && i + WORDS_PER_VECTOR <= cnt; k++, i+=WORDS_PER_VECTOR) {
+            bytes = _mm256_add_epi8(bytes, popcount_bytes(_mm256_loadu_si256((const __m256i *) (data + i))));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+
+    uint64_t sum = sum_lanes(total);
+    for(; i<cnt; i++) {
+        sum += emulated_popcnt(data[i]);
+    }
+    return sum;
+}
+
+//carry-save adder: h:l = a + b + c bitwise
+#define CSA(h, l, a, b, c) do { \
+    __m256i u = _mm256_xor_si256(a, b); \
+    h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c)); \
+    l = _mm256_xor_si256(u, c); \
+} while(0)
+
+#define LOAD(idx) _mm256_loadu_si256((const __m256i *) (data + (idx) * WORDS_PER_VECTOR))
+
+//Harley-Seal: a tree of carry-save adders reduces 16 vectors to one, only that one is counted
+//(Mula, Kurz, Lemire: Faster Population Counts Using AVX2 Instructions)
+uint64_t popcount_avx2_harley_seal(const uint64_t *data, size_t cnt) {
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256();
+    __m256i twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256();
+    __m256i eights = _mm256_setzero_si256();
+    __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+    const size_t vectors = cnt / WORDS_PER_VECTOR;
+    size_t v = 0;
+
+    for(; v + 16 <= vectors; v += 16) {
+        CSA(twos_a, ones, ones, LOAD(v), LOAD(v + 1));
+        CSA(twos_b, ones, ones, LOAD(v + 2), LOAD(v + 3));
+        CSA(fours_a, twos, twos, twos_a, twos_b);
+        CSA(twos_a, ones, ones, LOAD(v + 4), LOAD(v + 5));
+        CSA(twos_b, ones, ones, LOAD(v + 6), LOAD(v + 7));
+        CSA(fours_b, twos, twos, twos_a, twos_b);
+        CSA(eights_a, fours, fours, fours_a, fours_b);
+        CSA(twos_a, ones, ones, LOAD(v + 8), LOAD(v + 9));
+        CSA(twos_b, ones, ones, LOAD(v + 10), LOAD(v + 11));
+        CSA(fours_a, twos, twos, twos_a, twos_b);
+        CSA(twos_a, ones, ones, LOAD(v + 12), LOAD(v + 13));
+        CSA(twos_b, ones, ones, LOAD(v + 14), LOAD(v + 15));
+        CSA(fours_b, twos, twos, twos_a, twos_b);
+        CSA(eights_b, fours, fours, fours_a, fours_b);
+        CSA(sixteens, eights, eights, eights_a, eights_b);
+        total = _mm256_add_epi64(total, popcount_lanes(sixteens));
+    }
+
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_lanes(twos), 1));
+    total = _mm256_add_epi64(total, popcount_lanes(ones));
+    for(; v<vectors; v++) {
+        total = _mm256_add_epi64(total, popcount_lanes(LOAD(v)));
+    }
+
+    uint64_t sum = sum_lanes(total);
+    for(size_t i=vectors * WORDS_PER_VECTOR; i<cnt; i++) {
+        sum += emulated_popcnt(data[i]);
+    }
+    return sum;
+}
+
+void avx2_run(void *arg) {
+    struct popcount_ctx *ctx = arg;
+    ctx->sink += popcount_avx2_harley_seal(ctx->data, POPCOUNT_BLOCK_CNT);
+}
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AVX-512 popcount variants, this translation unit is compiled for AVX512F and AVX512_VPOPCNTDQ
+//nothing in here may be called unless dispatch_supported() confirmed both
+#pragma GCC target("avx512f,avx512vpopcntdq")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "popcount.h"
+
+#define WORDS_PER_VECTOR 8
+
+//four accumulators hide the latency of vpopcntq and vpaddq
+uint64_t popcount_avx512_vpopcntq(const uint64_t *data, size_t cnt) {
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512();
+    __m512i acc3 = _mm512_setzero_si512();
+    size_t i = 0;
+
+    for(; i + 4 * WORDS_PER_VECTOR <= cnt; i += 4 * WORDS_PER_VECTOR) {
+        acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i)));
+        acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + WORDS_PER_VECTOR)));
+        acc2 = _mm512_add_epi64(acc2, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 2 * WORDS_PER_VECTOR)));
+        acc3 = _mm512_add_epi64(acc3, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 3 * WORDS_PER_VECTOR)));
+    }
+    for(; i + WORDS_PER_VECTOR <= cnt; i += WORDS_PER_VECTOR) {
+        acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i)));
+    }
+    //the tail is read with a masked load, which never touches memory past the buffer
+    if(i < cnt) {
+        __mmask8 mask = (__mmask8) ((1u << (cnt - i)) - 1);
+        acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(mask, data + i)));
+    }
+
+    acc0 = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1), _mm512_add_epi64(acc2, acc3));
+    return (uint64_t) _mm512_reduce_add_epi64(acc0);
+}
+
+void vpopcntdq_run(void *arg) {
+    struct popcount_ctx *ctx = arg;
+    ctx->sink += popcount_avx512_vpopcntq(ctx->data, POPCOUNT_BLOCK_CNT);
+}
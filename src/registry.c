@@ -0,0 +1,285 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <fnmatch.h>
+#include <sched.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "dispatch.h"
+#include "registry.h"
+#include "report.h"
+#include "abm.h"
+#include "bmi.h"
+#include "popcount.h"
+#include "memory.h"
+#include "copy.h"
+#include "crypto.h"
+#include "flops.h"
+#include "freq.h"
+#include "branch.h"
+#include "jit.h"
+#include "c2c.h"
+#include "atomics.h"
+#include "text.h"
+#include "tlb.h"
+#include "numa.h"
+
+#define SLOT(name) offsetof(struct execution_time, name)
+
+//***********************************************
+//*******************REGISTRY********************
+//***********************************************
+
+//name, required extension, execution_time slot, kernel, emulated kernel, setup, prepare, teardown
+const struct bench_entry bench_registry[] = {
+    {"abm",    {ISA(ABM), ISA(POPCNT)}, SLOT(ABM),    abm_run,    abm_run_emulated,    abm_setup,    abm_prepare, NULL},
+    {"popcnt", {ISA(POPCNT)},           SLOT(POPCNT), popcnt_run, popcnt_run_emulated, popcnt_setup, abm_prepare, NULL},
+    {"bmi1",   {ISA(BMI1)},             SLOT(BMI1),   bmi1_run,   bmi1_run_emulated,   bmi_setup,    NULL, NULL},
+    {"bmi2",   {ISA(BMI2)},             SLOT(BMI2),   bmi2_run,   bmi2_run_emulated,   bmi_setup,    NULL, NULL},
+    {"avx512vpopcntdq", {ISA(AVX512F), ISA(AVX512VPOPCNTDQ)}, SLOT(AVX512VPOPCNTDQ),
+        vpopcntdq_run, popcount_run_emulated, popcount_setup, NULL, NULL},
+    {"aes",    {ISA(AES), ISA(SSSE3)},  SLOT(AES),    aes_run,    aes_run_emulated,    crypto_setup, NULL, NULL},
+    {"vaes",   {ISA(VAES), ISA(AES), ISA(AVX512F), ISA(AVX512BW)}, SLOT(VAES),
+        vaes_run, aes_run_emulated, crypto_setup, NULL, NULL},
+    {"pclmulqdq", {ISA(PCMULQDQ), ISA(SSSE3)}, SLOT(PCMULQDQ), pclmulqdq_run, ghash_run_emulated, crypto_setup, NULL, NULL},
+    {"vpclmulqdq", {ISA(VPCLMULQDQ), ISA(PCMULQDQ), ISA(AVX512F), ISA(AVX512BW)}, SLOT(VPCLMULQDQ),
+        vpclmulqdq_run, ghash_run_emulated, crypto_setup, NULL, NULL},
+    {"sha",    {ISA(SHA), ISA(SSSE3), ISA(SSE41)}, SLOT(SHA), sha_run, sha_run_emulated, crypto_setup, NULL, NULL},
+    {"sse42",  {ISA(SSE42)},            SLOT(SSE42),  crc32c_run, crc32c_run_emulated, text_setup,  NULL, NULL},
+    {"cx16",   {ISA(CX16)},             SLOT(CX16),   cx16_run,   cx16_run_emulated,   atomics_setup, NULL, NULL},
+    {"rtm",    {ISA(RTM)},              SLOT(RTM),    rtm_elided_run, ttas_run,        atomics_setup, NULL, NULL},
+    {"erms",   {ISA(ERMS)},             SLOT(ERMS),   erms_run,   erms_run_emulated,   copy_setup,   NULL, NULL},
+    {"avx",    {ISA(AVX)},              SLOT(AVX),    add_ps256_throughput, NULL, flops_setup, NULL, NULL},
+    {"avx2",   {ISA(AVX2)},             SLOT(AVX2),   avx2_run,   popcount_run_emulated, popcount_setup, NULL, NULL},
+    {"fma3",   {ISA(AVX), ISA(FMA3)},   SLOT(FMA3),   fma_ps256_throughput, NULL, flops_setup, NULL, NULL},
+    {"fma4",   {ISA(AVX), ISA(FMA4)},   SLOT(FMA4),   fma4_ps256_throughput, NULL, flops_setup, NULL, NULL},
+    {"avx512f", {ISA(AVX512F)},         SLOT(AVX512F), fma_ps512_throughput, NULL, flops_setup, NULL, NULL},
+    //one form of jit_specs each, see jit.c
+    {"sse",    {ISA(SSE)},              SLOT(SSE),    jit_run, NULL, sse_setup,   NULL, jit_teardown},
+    {"sse2",   {ISA(SSE2)},             SLOT(SSE2),   jit_run, NULL, sse2_setup,  NULL, jit_teardown},
+    {"ssse3",  {ISA(SSSE3)},            SLOT(SSSE3),  jit_run, NULL, ssse3_setup, NULL, jit_teardown},
+    {"sse41",  {ISA(SSE41)},            SLOT(SSE41),  jit_run, NULL, sse41_setup, NULL, jit_teardown},
+    {"cmov",   {ISA(X64)},              SLOT(CMOV),   jit_run, NULL, cmov_setup,  NULL, jit_teardown},
+    {"adx",    {ISA(INTEL_ADX)},        SLOT(INTEL_ADX), jit_run, NULL, adx_setup, NULL, jit_teardown},
+    {"gfni",   {ISA(GFNI)},             SLOT(GFNI),   jit_run, NULL, gfni_setup,  NULL, jit_teardown},
+    {"f16c",   {ISA(AVX), ISA(F16)},    SLOT(F16),    jit_run, NULL, f16c_setup,  NULL, jit_teardown},
+    {"avx512bw", {ISA(AVX512F), ISA(AVX512BW)}, SLOT(AVX512BW), jit_run, NULL, avx512bw_setup, NULL, jit_teardown},
+    {"avx512dq", {ISA(AVX512F), ISA(AVX512DQ)}, SLOT(AVX512DQ), jit_run, NULL, avx512dq_setup, NULL, jit_teardown},
+    {"avx512cd", {ISA(AVX512F), ISA(AVX512CD)}, SLOT(AVX512CD), jit_run, NULL, avx512cd_setup, NULL, jit_teardown},
+    {"avx512vbmi", {ISA(AVX512F), ISA(AVX512VBMI)}, SLOT(AVX512VBMI), jit_run, NULL, avx512vbmi_setup, NULL,
+        jit_teardown},
+    {"avx512vbmi2", {ISA(AVX512F), ISA(AVX512VBMI2)}, SLOT(AVX512VBMI2), jit_run, NULL, avx512vbmi2_setup, NULL,
+        jit_teardown},
+    {"avx512vnni", {ISA(AVX512F), ISA(AVX512VNNI)}, SLOT(AVX512VNNI), jit_run, NULL, avx512vnni_setup, NULL,
+        jit_teardown},
+    {"avx512ifma", {ISA(AVX512F), ISA(AVX512IFMA)}, SLOT(AVX512IFMA), jit_run, NULL, avx512ifma_setup, NULL,
+        jit_teardown},
+    {"avx512bitalg", {ISA(AVX512F), ISA(AVX512BITALG)}, SLOT(AVX512BITALG), jit_run, NULL, avx512bitalg_setup, NULL,
+        jit_teardown},
+};
+
+const size_t bench_registry_cnt = sizeof(bench_registry) / sizeof(bench_registry[0]);
+
+//name, run
+const struct suite_entry suite_registry[] = {
+    {"abm-throughput", abm_throughput_suite},
+    {"abm-latency",    abm_latency_suite},
+    {"bmi",            bmi_suite},
+    {"popcount",       popcount_suite},
+    {"memory",         memory_suite},
+    {"copy",           copy_suite},
+    {"crypto",         crypto_suite},
+    {"flops",          flops_suite},
+    {"frequency",      freq_suite},
+    {"branch",         branch_suite},
+    {"instructions",   jit_suite},
+    {"c2c",            c2c_suite},
+    {"atomics",        atomics_suite},
+    {"text",           text_suite},
+    {"tlb",            tlb_suite},
+    {"numa",           numa_suite},
+};
+
+const size_t suite_registry_cnt = sizeof(suite_registry) / sizeof(suite_registry[0]);
+
+//***********************************************
+//*******************HARNESS*********************
+//***********************************************
+
+static void print_result(const char *name, const char *core_type, bool emulated, const struct measure_result *result) {
+    if(core_type) {
+        printf("%s [%s]", name, core_type);
+    } else {
+        printf("%s", name);
+    }
+    printf("%s: median %.3f ns/op (%.3f cycles/op), min %.3f, p90 %.3f, p99 %.3f, "
+           "stddev %.3f, 95%% CI +-%.3f (%.2f%%), %u samples, %u outliers\r\n",
+           emulated ? " (emulated)" : "", result->median, result->median * timer_info.cycles_per_ns,
+           result->min, result->p90, result->p99, result->stddev, result->ci95, result->rel_error * 100.0,
+           result->samples, result->outliers);
+    if(result->counted) {
+        counters_print(&result->counters);
+    }
+}
+
+//returns the kernel to run on this CPU, NULL if the extension is missing and there is no emulation
+bench_fn registry_resolve(const struct bench_entry *entry, const struct cpu_info *cpu_info, bool *emulated) {
+    *emulated = !dispatch_supported(cpu_info, entry->requires);
+    return *emulated ? entry->run_emulated : entry->run;
+}
+
+void registry_list(const struct cpu_info *cpu_info) {
+    for(size_t i=0; i<bench_registry_cnt; i++) {
+        const struct bench_entry *entry = &bench_registry[i];
+        bool supported = dispatch_supported(cpu_info, entry->requires);
+        printf("%-24s %s\r\n", entry->name,
+               supported ? "hardware" : (entry->run_emulated ? "emulated" : "unsupported"));
+    }
+    for(size_t i=0; i<suite_registry_cnt; i++) {
+        printf("%-24s suite\r\n", suite_registry[i].name);
+    }
+}
+
+//an empty pattern list selects everything, otherwise the name has to match one of the shell globs
+static bool name_selected(const char *name, char *const patterns[], size_t pattern_cnt) {
+    if(pattern_cnt == 0) {
+        return true;
+    }
+    for(size_t i=0; i<pattern_cnt; i++) {
+        if(fnmatch(patterns[i], name, 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool registry_selected(const struct bench_entry *entry, char *const patterns[], size_t pattern_cnt) {
+    return name_selected(entry->name, patterns, pattern_cnt);
+}
+
+//setup, measure_run and teardown of one entry, returns -1 if setup or the measurement failed
+static int measure_entry(const struct bench_env *env, const struct bench_entry *entry, bench_fn run,
+                         struct measure_result *result) {
+    uint64_t ops = 1;
+    corpus_reset(env->corpus);
+    void *ctx = entry->setup ? entry->setup(env, &ops) : NULL;
+    if(entry->setup && ctx == NULL) {
+        printf("%s: setup failed\r\n", entry->name);
+        return -1;
+    }
+
+    struct measure_kernel kernel = {entry->prepare, run, ctx, ops};
+    int status = measure_run(&kernel, env->config, result);
+    if(status != 0) {
+        printf("%s: measurement failed\r\n", entry->name);
+    }
+    if(entry->teardown) {
+        entry->teardown(ctx);
+    }
+    return status;
+}
+
+//on hybrid CPUs the calling thread moves to a CPU of the given core type, elsewhere nothing happens
+static void pin_core_type(const struct cpu_topology *topology, uint32_t index) {
+    cpu_set_t set;
+    if(topology->core_type_cnt < 2) {
+        return;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(topology_core_type_cpu(topology, topology->core_types[index]), &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+//runs every selected entry on hardware or, if an extension is missing, its emulation
+//the kernel is resolved before measure_run, so the timed region contains no feature checks
+//on hybrid CPUs every entry runs pinned once per core type and the results are compared, execution_time
+//keeps the P-core result
+//stores the median ns/op in execution_time and, if report is not NULL, the full result in report
+//returns the number of entries that failed
+int registry_run(const struct bench_env *env, char *const patterns[], size_t pattern_cnt,
+                 struct execution_time *execution_time, struct report *report) {
+    const struct cpu_topology *topology = &env->cpu_info->topology;
+    const uint32_t type_cnt = topology->core_type_cnt > 1 ? topology->core_type_cnt : 1;
+    struct measure_result result;
+    double medians[TOPOLOGY_MAX_CORE_TYPES];
+    cpu_set_t saved;
+    int failed = 0;
+
+    if(sched_getaffinity(0, sizeof(saved), &saved) != 0) {
+        return 1;
+    }
+    for(size_t i=0; i<bench_registry_cnt; i++) {
+        const struct bench_entry *entry = &bench_registry[i];
+        if(!registry_selected(entry, patterns, pattern_cnt)) {
+            continue;
+        }
+        bool emulated;
+        bench_fn run = registry_resolve(entry, env->cpu_info, &emulated);
+        if(run == NULL) {
+            printf("%s: unsupported, skipped\r\n", entry->name);
+            continue;
+        }
+
+        uint32_t done = 0;
+        for(; done<type_cnt; done++) {
+            const char *core_type = type_cnt > 1 ? topology_core_type_name(topology->core_types[done]) : NULL;
+            pin_core_type(topology, done);
+            if(measure_entry(env, entry, run, &result) != 0) {
+                failed++;
+                break;
+            }
+            if(done == 0) {
+                *(double *) ((char *) execution_time + entry->slot) = result.median;
+            }
+            medians[done] = result.median;
+            print_result(entry->name, core_type, emulated, &result);
+            if(report) {
+                report_add(report, entry->name, core_type, emulated, &result);
+            }
+        }
+        //side by side, relative to the P-cores
+        if(type_cnt > 1 && done == type_cnt) {
+            printf("%s:", entry->name);
+            for(uint32_t t=0; t<type_cnt; t++) {
+                printf(" %s %.3f ns/op (%.2fx)%s", topology_core_type_name(topology->core_types[t]), medians[t],
+                       medians[t] / medians[0], t + 1 < type_cnt ? " |" : "");
+            }
+            printf("\r\n");
+        }
+    }
+    sched_setaffinity(0, sizeof(saved), &saved);
+    return failed;
+}
+
+//runs every suite matching one of the patterns, returns the number of suites that failed
+int registry_run_suites(const struct bench_env *env, char *const patterns[], size_t pattern_cnt) {
+    int failed = 0;
+
+    for(size_t i=0; i<suite_registry_cnt; i++) {
+        if(!name_selected(suite_registry[i].name, patterns, pattern_cnt)) {
+            continue;
+        }
+        printf("== %s ==\r\n", suite_registry[i].name);
+        corpus_reset(env->corpus);
+        if(suite_registry[i].run(env) != 0) {
+            printf("%s: suite failed\r\n", suite_registry[i].name);
+            failed++;
+        }
+        fflush(stdout);
+    }
+    return failed;
+}
@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef REGISTRY
+#define REGISTRY
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cpuinfo.h"
+#include "corpus.h"
+#include "measure.h"
+#include "dispatch.h"
+
+//everything a benchmark may use while it sets itself up
+struct bench_env {
+    const struct cpu_info *cpu_info;
+    struct corpus *corpus;              //reset before every setup
+    const struct measure_config *config;
+    const char *c2c_csv;                //--c2c-csv FILE for the core-to-core matrix, NULL if not asked for
+};
+
+typedef void (*bench_fn)(void *ctx);
+
+struct report;
+
+//one row of the benchmark table
+struct bench_entry {
+    const char *name;
+    size_t requires[DISPATCH_REQUIRES_MAX]; //extensions the hardware kernel needs, see ISA()
+    size_t slot;                        //offsetof(struct execution_time, ...) the median is stored in
+    bench_fn run;                       //hardware kernel (timed)
+    bench_fn run_emulated;              //fallback if an extension is missing, NULL if there is none
+    void *(*setup)(const struct bench_env *env, uint64_t *ops); //returns ctx (NULL on failure) and ops per run
+    void (*prepare)(void *ctx);         //optional, called before every sample (not timed)
+    void (*teardown)(void *ctx);        //optional, releases what setup acquired
+};
+
+//a sweep that reports its own table (buffer sizes, variants, ...) instead of a single ns/op
+struct suite_entry {
+    const char *name;
+    int (*run)(const struct bench_env *env); //returns 0 on success, -1 on failure
+};
+
+extern const struct bench_entry bench_registry[];
+extern const size_t bench_registry_cnt;
+extern const struct suite_entry suite_registry[];
+extern const size_t suite_registry_cnt;
+
+bench_fn registry_resolve(const struct bench_entry *entry, const struct cpu_info *cpu_info, bool *emulated);
+void registry_list(const struct cpu_info *cpu_info);
+bool registry_selected(const struct bench_entry *entry, char *const patterns[], size_t pattern_cnt);
+int registry_run(const struct bench_env *env, char *const patterns[], size_t pattern_cnt,
+                 struct execution_time *execution_time, struct report *report);
+int registry_run_suites(const struct bench_env *env, char *const patterns[], size_t pattern_cnt);
+
+#endif
@@ -0,0 +1,326 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//structured output of the registry benchmarks (JSON and CSV) and comparison against a baseline
+//written by an earlier --json run. Every file carries the CPU identity, so results of different
+//machines or microcode revisions can be told apart by the dashboards reading them.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "counters.h"
+#include "report.h"
+
+#define LINE_MAX_LEN 4096
+#define NAME_MAX_LEN 64
+
+int report_init(struct report *report, const struct cpu_info *cpu_info, const struct measure_config *config,
+                uint64_t seed, size_t capacity) {
+    report->cpu_info = cpu_info;
+    report->config = config;
+    report->seed = seed;
+    report->cnt = 0;
+    report->capacity = capacity;
+    report->entries = calloc(capacity, sizeof(*report->entries));
+    return report->entries != NULL ? 0 : -1;
+}
+
+void report_add(struct report *report, const char *name, const char *core_type, bool emulated,
+                const struct measure_result *result) {
+    if(report->cnt < report->capacity) {
+        report->entries[report->cnt].name = name;
+        report->entries[report->cnt].core_type = core_type;
+        report->entries[report->cnt].emulated = emulated;
+        report->entries[report->cnt].result = *result;
+        report->cnt++;
+    }
+}
+
+void report_free(struct report *report) {
+    free(report->entries);
+    report->entries = NULL;
+    report->cnt = report->capacity = 0;
+}
+
+static bool flag_set(const struct cpu_info *info, size_t flag) {
+    return *(const bool *) ((const char *) info + cpu_flags[flag].offset);
+}
+
+//***********************************************
+//*********************JSON**********************
+//***********************************************
+
+static void json_string(FILE *file, const char *text) {
+    fputc('"', file);
+    for(const unsigned char *c=(const unsigned char *) text; *c; c++) {
+        if(*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if(*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+//one result per line, report_compare() relies on that
+static void json_result(FILE *file, const struct report_entry *entry) {
+    const struct measure_result *r = &entry->result;
+    fprintf(file, "    {\"name\": ");
+    json_string(file, entry->name);
+    if(entry->core_type) {
+        fprintf(file, ", \"core_type\": ");
+        json_string(file, entry->core_type);
+    }
+    fprintf(file, ", \"emulated\": %s, \"median_ns\": %.9g, \"min_ns\": %.9g, \"mean_ns\": %.9g, "
+            "\"p90_ns\": %.9g, \"p99_ns\": %.9g, \"stddev_ns\": %.9g, \"ci95_ns\": %.9g, \"rel_error\": %.9g, "
+            "\"samples\": %u, \"outliers\": %u", entry->emulated ? "true" : "false", r->median, r->min, r->mean,
+            r->p90, r->p99, r->stddev, r->ci95, r->rel_error, r->samples, r->outliers);
+    if(r->counted) {
+        const double ops = r->counters.ops ? (double) r->counters.ops : 1.0;
+        fprintf(file, ", \"counters_per_op\": {");
+        const char *separator = "";
+        for(uint32_t e=0; e<COUNTER_CNT; e++) {
+            if(r->counters.valid[e]) {
+                fprintf(file, "%s\"%s\": %.9g", separator, counters_name(e), r->counters.count[e] / ops);
+                separator = ", ";
+            }
+        }
+        fprintf(file, "}");
+    }
+    fprintf(file, "}");
+}
+
+int report_write_json(const struct report *report, const char *path) {
+    const struct cpu_info *info = report->cpu_info;
+    const struct measure_config *config = report->config;
+    FILE *file = fopen(path, "w");
+    if(file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "{\n  \"schema\": %d,\n  \"cpu\": {\n    \"vendor\": ", REPORT_SCHEMA);
+    json_string(file, info->VENDOR);
+    fprintf(file, ",\n    \"brand\": ");
+    json_string(file, info->BRAND);
+    fprintf(file, ",\n    \"family\": %u,\n    \"model\": %u,\n    \"stepping\": %u,\n    \"microcode\": \"0x%llx\",\n",
+            info->FAMILY, info->MODEL, info->STEPPING, (unsigned long long) info->MICROCODE);
+    fprintf(file, "    \"packages\": %u,\n    \"cores\": %u,\n    \"logical_cpus\": %u,\n    \"flags\": {\n",
+            info->PACKAGES, info->CORES_PHYSICAL, info->CORES_LOGICAL);
+    for(size_t i=0; i<cpu_flag_cnt; i++) {
+        fprintf(file, "      \"%s\": %s%s\n", cpu_flags[i].name, flag_set(info, i) ? "true" : "false",
+                i + 1 < cpu_flag_cnt ? "," : "");
+    }
+    fprintf(file, "    }\n  },\n");
+    fprintf(file, "  \"timer\": {\"source\": \"%s\", \"tsc_ghz\": %.6f, \"overhead_ticks\": %llu},\n",
+            timer_info.tsc ? "tsc" : "clock_gettime", timer_info.cycles_per_ns,
+            (unsigned long long) timer_info.overhead);
+    fprintf(file, "  \"config\": {\"seed\": \"0x%016llx\", \"warmup\": %u, \"min_samples\": %u, \"max_samples\": %u, "
+            "\"rel_error\": %g, \"max_seconds\": %g},\n", (unsigned long long) report->seed, config->warmup,
+            config->min_samples, config->max_samples, config->target_rel_error, config->max_seconds);
+    fprintf(file, "  \"results\": [\n");
+    for(size_t i=0; i<report->cnt; i++) {
+        json_result(file, &report->entries[i]);
+        fprintf(file, "%s\n", i + 1 < report->cnt ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+//***********************************************
+//*********************CSV***********************
+//***********************************************
+
+//quotes a field and doubles the quotes inside it
+static void csv_string(FILE *file, const char *text) {
+    fputc('"', file);
+    for(const char *c=text; *c; c++) {
+        if(*c == '"') fputc('"', file);
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+//one row per result, the CPU identity is repeated on every row so rows can be concatenated across machines
+int report_write_csv(const struct report *report, const char *path) {
+    const struct cpu_info *info = report->cpu_info;
+    FILE *file = fopen(path, "w");
+    if(file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "vendor,brand,family,model,stepping,microcode,flags,name,core_type,emulated,median_ns,min_ns,"
+            "mean_ns,p90_ns,p99_ns,stddev_ns,ci95_ns,rel_error,samples,outliers");
+    for(uint32_t e=0; e<COUNTER_CNT; e++) {
+        fprintf(file, ",%s_per_op", counters_name(e));
+    }
+    fprintf(file, "\n");
+
+    for(size_t i=0; i<report->cnt; i++) {
+        const struct report_entry *entry = &report->entries[i];
+        const struct measure_result *r = &entry->result;
+        csv_string(file, info->VENDOR);
+        fputc(',', file);
+        csv_string(file, info->BRAND);
+        fprintf(file, ",%u,%u,%u,0x%llx,\"", info->FAMILY, info->MODEL, info->STEPPING,
+                (unsigned long long) info->MICROCODE);
+        const char *separator = "";
+        for(size_t f=0; f<cpu_flag_cnt; f++) {
+            if(flag_set(info, f)) {
+                fprintf(file, "%s%s", separator, cpu_flags[f].name);
+                separator = " ";
+            }
+        }
+        fprintf(file, "\",");
+        csv_string(file, entry->name);
+        fputc(',', file);
+        if(entry->core_type) {
+            csv_string(file, entry->core_type);
+        }
+        fprintf(file, ",%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%u,%u", entry->emulated, r->median, r->min,
+                r->mean, r->p90, r->p99, r->stddev, r->ci95, r->rel_error, r->samples, r->outliers);
+        const double ops = r->counted && r->counters.ops ? (double) r->counters.ops : 1.0;
+        for(uint32_t e=0; e<COUNTER_CNT; e++) {
+            if(r->counted && r->counters.valid[e]) {
+                fprintf(file, ",%.9g", r->counters.count[e] / ops);
+            } else {
+                fprintf(file, ",");
+            }
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+//***********************************************
+//*******************COMPARE*********************
+//***********************************************
+
+//value of "key": in a line written by json_result(), false if the key is missing
+static bool json_number(const char *line, const char *key, double *value) {
+    char pattern[NAME_MAX_LEN + 4];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *at = strstr(line, pattern);
+    if(at == NULL) {
+        return false;
+    }
+    char *end;
+    *value = strtod(at + strlen(pattern), &end);
+    return end != at + strlen(pattern);
+}
+
+//string value of "key": in a line written by json_result(), false if the key is missing; benchmark
+//names and core types never contain quotes or backslashes, so the first quote ends the string
+static bool json_text(const char *line, const char *key, char *text, size_t size) {
+    char pattern[NAME_MAX_LEN + 8];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char *at = strstr(line, pattern);
+    if(at == NULL) {
+        return false;
+    }
+    at += strlen(pattern);
+    const char *end = strchr(at, '"');
+    if(end == NULL || (size_t) (end - at) >= size) {
+        return false;
+    }
+    memcpy(text, at, end - at);
+    text[end - at] = '\0';
+    return true;
+}
+
+//an empty core_type matches entries that were not run per core type
+static const struct report_entry *find_entry(const struct report *report, const char *name, const char *core_type) {
+    for(size_t i=0; i<report->cnt; i++) {
+        const char *entry_type = report->entries[i].core_type ? report->entries[i].core_type : "";
+        if(strcmp(report->entries[i].name, name) == 0 && strcmp(entry_type, core_type) == 0) {
+            return &report->entries[i];
+        }
+    }
+    return NULL;
+}
+
+//"name" or "name [core type]"
+static void entry_label(char *label, size_t size, const char *name, const char *core_type) {
+    if(core_type && core_type[0]) {
+        snprintf(label, size, "%s [%s]", name, core_type);
+    } else {
+        snprintf(label, size, "%s", name);
+    }
+}
+
+//compares every result against the baseline file written by report_write_json(); a change counts
+//if the medians differ by more than the combined 95% intervals of both runs and by at least
+//COMPARE_MIN_CHANGE, returns the number of regressions or -1 if the baseline can not be read
+int report_compare(const struct report *report, const char *path) {
+    char line[LINE_MAX_LEN];
+    char name[NAME_MAX_LEN];
+    char core_type[NAME_MAX_LEN];
+    char label[2 * NAME_MAX_LEN];
+    int regressions = 0;
+    bool *seen = calloc(report->cnt ? report->cnt : 1, sizeof(*seen));
+    FILE *file = fopen(path, "r");
+    if(file == NULL || seen == NULL) {
+        if(file) fclose(file);
+        free(seen);
+        return -1;
+    }
+
+    printf("Compared to %s (slower is a regression):\r\n", path);
+    printf("%-24s %12s %12s %10s  %s\r\n", "benchmark", "base ns/op", "ns/op", "change", "verdict");
+    while(fgets(line, sizeof(line), file) != NULL) {
+        double median, ci95;
+        if(!json_text(line, "name", name, sizeof(name)) || !json_number(line, "median_ns", &median) ||
+           !json_number(line, "ci95_ns", &ci95)) {
+            continue;
+        }
+        if(!json_text(line, "core_type", core_type, sizeof(core_type))) {
+            core_type[0] = '\0';
+        }
+        const bool emulated = strstr(line, "\"emulated\": true") != NULL;
+        const struct report_entry *entry = find_entry(report, name, core_type);
+        entry_label(label, sizeof(label), name, core_type);
+        if(entry == NULL) {
+            printf("%-24s %12.3f %12s %10s  %s\r\n", label, median, "-", "-", "not run");
+            continue;
+        }
+        seen[entry - report->entries] = true;
+
+        const struct measure_result *r = &entry->result;
+        const double change = median > 0.0 ? (r->median - median) / median : 0.0;
+        const double noise = sqrt(ci95 * ci95 + r->ci95 * r->ci95);
+        const char *verdict = "unchanged";
+        if(emulated != entry->emulated) {
+            verdict = "not comparable (emulation differs)";
+        } else if(fabs(r->median - median) > noise && fabs(change) >= COMPARE_MIN_CHANGE) {
+            verdict = change > 0.0 ? "REGRESSION" : "improvement";
+            regressions += change > 0.0;
+        }
+        printf("%-24s %12.3f %12.3f %+9.1f%%  %s\r\n", label, median, r->median, change * 100.0, verdict);
+    }
+    for(size_t i=0; i<report->cnt; i++) {
+        if(!seen[i]) {
+            entry_label(label, sizeof(label), report->entries[i].name, report->entries[i].core_type);
+            printf("%-24s %12s %12.3f %10s  %s\r\n", label, "-", report->entries[i].result.median, "-", "new");
+        }
+    }
+    printf("%d regression(s)\r\n", regressions);
+
+    fclose(file);
+    free(seen);
+    return regressions;
+}
@@ -0,0 +1,49 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef REPORT
+#define REPORT
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cpuinfo.h"
+#include "measure.h"
+
+#define REPORT_SCHEMA 1
+#define COMPARE_MIN_CHANGE 0.02 //changes below 2% are never flagged, however tight the intervals are
+
+//one measured benchmark of the registry
+struct report_entry {
+    const char *name;
+    const char *core_type;  //P-core/E-core on hybrid CPUs where every entry runs once per core type, else NULL
+    bool emulated;
+    struct measure_result result;
+};
+
+//results of one run together with what tells runs on different machines apart
+struct report {
+    const struct cpu_info *cpu_info;
+    const struct measure_config *config;
+    uint64_t seed;
+    struct report_entry *entries;
+    size_t cnt;
+    size_t capacity;
+};
+
+int report_init(struct report *report, const struct cpu_info *cpu_info, const struct measure_config *config,
+                uint64_t seed, size_t capacity);
+void report_add(struct report *report, const char *name, const char *core_type, bool emulated,
+                const struct measure_result *result);
+void report_free(struct report *report);
+int report_write_json(const struct report *report, const char *path);
+int report_write_csv(const struct report *report, const char *path);
+int report_compare(const struct report *report, const char *path);
+
+#endif
@@ -0,0 +1,291 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//text processing over a corpus of fixed length decimal records: CRC32C, strlen, memchr and integer
+//parsing, each as portable scalar code, through libc and with SSE4.2/AVX2
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cpuinfo.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "dispatch.h"
+#include "text.h"
+
+#define NAME_WIDTH 16
+#define COLUMN_WIDTH 12
+#define CRC32C_CHECK 0xe3069283 //CRC32C of "123456789"
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+static uint32_t crc_table[8][256]; //crc_table[k] advances a byte followed by k zero bytes
+static bool tables_ready;
+
+static void crc32c_init(void) {
+    if(tables_ready) {
+        return;
+    }
+    for(uint32_t b=0; b<256; b++) {
+        uint32_t crc = b;
+        for(int k=0; k<8; k++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0 - (crc & 1)));
+        }
+        crc_table[0][b] = crc;
+    }
+    for(uint32_t b=0; b<256; b++) {
+        for(int k=1; k<8; k++) {
+            crc_table[k][b] = (crc_table[k - 1][b] >> 8) ^ crc_table[0][crc_table[k - 1][b] & 0xff];
+        }
+    }
+    tables_ready = true;
+}
+
+static uint32_t crc32c_bytes(uint32_t crc, const char *buf, size_t len) {
+    for(size_t i=0; i<len; i++) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ (uint8_t) buf[i]) & 0xff];
+    }
+    return crc;
+}
+
+//one table lookup per byte, every lookup depends on the previous one
+uint64_t crc32c_table(const char *text, size_t cnt) {
+    return ~crc32c_bytes(0xffffffff, text, cnt * TEXT_STRIDE);
+}
+
+//slicing-by-8: eight independent lookups per 8 bytes, only the xor tree is serial
+uint64_t crc32c_slice8(const char *text, size_t cnt) {
+    const size_t bytes = cnt * TEXT_STRIDE;
+    uint32_t crc = 0xffffffff;
+    size_t i = 0;
+
+    for(; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        memcpy(&word, text + i, sizeof(word));
+        word ^= crc;
+        crc = crc_table[7][word & 0xff] ^ crc_table[6][(word >> 8) & 0xff] ^
+              crc_table[5][(word >> 16) & 0xff] ^ crc_table[4][(word >> 24) & 0xff] ^
+              crc_table[3][(word >> 32) & 0xff] ^ crc_table[2][(word >> 40) & 0xff] ^
+              crc_table[1][(word >> 48) & 0xff] ^ crc_table[0][word >> 56];
+    }
+    return ~crc32c_bytes(crc, text + i, bytes - i);
+}
+
+uint64_t strlen_scalar(const char *text, size_t cnt) {
+    uint64_t sum = 0;
+    for(size_t i=0; i<cnt; i++) {
+        const volatile char *str = text + i * TEXT_STRIDE; //keeps the compiler from calling strlen
+        size_t len = 0;
+        while(str[len]) {
+            len++;
+        }
+        sum += len;
+    }
+    return sum;
+}
+
+uint64_t strlen_libc(const char *text, size_t cnt) {
+    uint64_t sum = 0;
+    for(size_t i=0; i<cnt; i++) {
+        sum += strlen(text + i * TEXT_STRIDE);
+    }
+    return sum;
+}
+
+uint64_t memchr_scalar(const char *text, size_t cnt) {
+    const size_t bytes = cnt * TEXT_STRIDE;
+    const volatile char *str = text;
+    for(size_t i=0; i<bytes; i++) {
+        if(str[i] == TEXT_ABSENT) {
+            return i;
+        }
+    }
+    return bytes;
+}
+
+uint64_t memchr_libc(const char *text, size_t cnt) {
+    const size_t bytes = cnt * TEXT_STRIDE;
+    const char *hit = memchr(text, TEXT_ABSENT, bytes);
+    return hit ? (uint64_t) (hit - text) : bytes;
+}
+
+//general purpose parser: whitespace, sign, base and overflow handling, plus the locale lookups of isspace
+uint64_t parse_strtol(const char *text, size_t cnt) {
+    uint64_t sum = 0;
+    for(size_t i=0; i<cnt; i++) {
+        sum += (uint64_t) strtol(text + i * TEXT_STRIDE, NULL, 10);
+    }
+    return sum;
+}
+
+//one multiply-add per digit until the NUL, a serial chain through value
+uint64_t parse_scalar(const char *text, size_t cnt) {
+    uint64_t sum = 0;
+    for(size_t i=0; i<cnt; i++) {
+        const char *str = text + i * TEXT_STRIDE;
+        uint64_t value = 0;
+        while(*str) {
+            value = value * 10 + (uint64_t) (*str++ - '0');
+        }
+        sum += value;
+    }
+    return sum;
+}
+
+//eight digits in a register at once: each multiply combines neighbouring digits, pairs and quads
+static inline uint32_t parse_eight(const char *str) {
+    uint64_t val;
+    memcpy(&val, str, sizeof(val));
+    val = ((val & 0x0f0f0f0f0f0f0f0full) * 2561) >> 8;
+    val = ((val & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+    return (uint32_t) (((val & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32);
+}
+
+uint64_t parse_swar(const char *text, size_t cnt) {
+    uint64_t sum = 0;
+    for(size_t i=0; i<cnt; i++) {
+        const char *str = text + i * TEXT_STRIDE;
+        sum += (uint64_t) parse_eight(str) * 100000000 + parse_eight(str + 8);
+    }
+    return sum;
+}
+
+//***********************************************
+//**************EXTENSIONS_BENCHES***************
+//***********************************************
+
+static void text_run(void *arg) {
+    struct text_ctx *ctx = arg;
+    ctx->sink += ctx->fn(ctx->text, TEXT_RECORDS);
+}
+
+//CRC32C of the record corpus, one op is one byte
+void *text_setup(const struct bench_env *env, uint64_t *ops) {
+    struct text_ctx *ctx = arena_alloc(&env->corpus->arena, sizeof(*ctx));
+    const char *text = corpus_digits(env->corpus, TEXT_RECORDS, TEXT_DIGITS);
+    //arena allocations are consecutive, so the guard is readable right behind the records
+    const void *guard = arena_alloc(&env->corpus->arena, TEXT_GUARD);
+    if(ctx == NULL || text == NULL || guard == NULL) {
+        return NULL;
+    }
+    crc32c_init();
+    ctx->text = text;
+    ctx->fn = crc32c_sse42;
+    ctx->sink = 0;
+    *ops = TEXT_RECORDS * TEXT_STRIDE;
+    return ctx;
+}
+
+//instructions used: CRC32
+void crc32c_run(void *arg) {
+    struct text_ctx *ctx = arg;
+    ctx->sink += crc32c_sse42(ctx->text, TEXT_RECORDS);
+}
+
+void crc32c_run_emulated(void *arg) {
+    struct text_ctx *ctx = arg;
+    ctx->sink += crc32c_table(ctx->text, TEXT_RECORDS);
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+struct text_workload {
+    const char *name;
+    struct text_kernel kernels[4]; //the first one is the portable baseline the others are checked against
+};
+
+//compares every kernel's checksum with the baseline, a kernel that disagrees is excluded
+static void text_verify(struct text_workload *workload, const char *text) {
+    const uint64_t expected = workload->kernels[0].fn(text, TEXT_RECORDS);
+    for(size_t k=1; k<sizeof(workload->kernels) / sizeof(workload->kernels[0]); k++) {
+        struct text_kernel *kernel = &workload->kernels[k];
+        if(!kernel->supported) {
+            continue;
+        }
+        uint64_t got = kernel->fn(text, TEXT_RECORDS);
+        if(got != expected) {
+            printf("%s: wrong result (%llu instead of %llu), excluded\r\n", kernel->name,
+                   (unsigned long long) got, (unsigned long long) expected);
+            kernel->supported = false;
+        }
+    }
+}
+
+//median ns per record, 0 on failure
+static double text_measure(const struct bench_env *env, struct text_ctx *ctx, const struct text_kernel *kernel) {
+    struct measure_result result;
+    struct measure_kernel measured = {NULL, text_run, ctx, TEXT_RECORDS};
+    ctx->fn = kernel->fn;
+    return measure_run(&measured, env->config, &result) == 0 ? result.median : 0.0;
+}
+
+//CRC32C, strlen, memchr and decimal parsing of 16 digit records in every available implementation,
+//verified against the scalar baseline and reported in ns/record, Mrecords/s and GB/s of record bytes
+int text_suite(const struct bench_env *env) {
+    const bool sse42 = dispatch_supported(env->cpu_info, REQUIRES(ISA(SSE42), ISA(SSE41), ISA(SSSE3)));
+    const bool avx2 = dispatch_supported(env->cpu_info, REQUIRES(ISA(AVX2)));
+    struct text_workload workloads[] = {
+        {"crc32c", {{"crc32c-table", crc32c_table, true}, {"crc32c-slice8", crc32c_slice8, true},
+                    {"crc32c-sse42", crc32c_sse42, sse42}, {NULL, NULL, false}}},
+        {"strlen", {{"strlen-scalar", strlen_scalar, true}, {"strlen-libc", strlen_libc, true},
+                    {"strlen-pcmpistri", strlen_sse42, sse42}, {"strlen-avx2", strlen_avx2, avx2}}},
+        {"memchr", {{"memchr-scalar", memchr_scalar, true}, {"memchr-libc", memchr_libc, true},
+                    {"memchr-pcmpestri", memchr_sse42, sse42}, {"memchr-avx2", memchr_avx2, avx2}}},
+        {"parse", {{"parse-strtol", parse_strtol, true}, {"parse-scalar", parse_scalar, true},
+                   {"parse-swar", parse_swar, true}, {"parse-sse41", parse_sse41, sse42}}},
+    };
+    void *ctx_mem = text_setup(env, &(uint64_t) {0});
+    if(ctx_mem == NULL) {
+        return -1;
+    }
+    struct text_ctx *ctx = ctx_mem;
+    if(~crc32c_bytes(0xffffffff, "123456789", 9) != CRC32C_CHECK) {
+        printf("crc32c-table: does not match the check value, text suite skipped\r\n");
+        return -1;
+    }
+
+    printf("%u records of %u digits + NUL, GB/s counts every record byte\r\n", TEXT_RECORDS, TEXT_DIGITS);
+    printf("%-*s%*s%*s%*s%*s\r\n", NAME_WIDTH, "kernel", COLUMN_WIDTH, "ns/record", COLUMN_WIDTH, "Mrecords/s",
+           COLUMN_WIDTH, "GB/s", COLUMN_WIDTH, "speedup");
+    for(size_t w=0; w<sizeof(workloads) / sizeof(workloads[0]); w++) {
+        struct text_workload *workload = &workloads[w];
+        double baseline = 0.0;
+
+        text_verify(workload, ctx->text);
+        for(size_t k=0; k<sizeof(workload->kernels) / sizeof(workload->kernels[0]); k++) {
+            const struct text_kernel *kernel = &workload->kernels[k];
+            if(kernel->name == NULL) {
+                continue;
+            }
+            printf("%-*s", NAME_WIDTH, kernel->name);
+            if(!kernel->supported) {
+                printf("%*s%*s%*s%*s\r\n", COLUMN_WIDTH, "-", COLUMN_WIDTH, "-", COLUMN_WIDTH, "-", COLUMN_WIDTH, "-");
+                continue;
+            }
+            double ns = text_measure(env, ctx, kernel);
+            if(ns == 0.0) {
+                printf("\r\n");
+                return -1;
+            }
+            baseline = k == 0 ? ns : baseline;
+            printf("%*.2f%*.1f%*.2f%*.2fx\r\n", COLUMN_WIDTH, ns, COLUMN_WIDTH, 1e3 / ns,
+                   COLUMN_WIDTH, TEXT_STRIDE / ns, COLUMN_WIDTH - 1, baseline / ns);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef TEXT
+#define TEXT
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define TEXT_DIGITS 16                  //digits per record, the largest value still fits into a long
+#define TEXT_STRIDE (TEXT_DIGITS + 1)   //records are NUL terminated and stored back to back
+#define TEXT_RECORDS 8192               //records per timed call (136 KiB, L2 resident)
+#define TEXT_GUARD 64                   //readable bytes behind the corpus for vector loads that overshoot
+#define TEXT_ABSENT '\n'                //byte the memchr kernels search for, it never occurs in the corpus
+#define CRC32C_POLY 0x82f63b78          //reflected Castagnoli polynomial
+
+//kernel that processes cnt records of TEXT_STRIDE bytes starting at text and returns a checksum,
+//all kernels of one workload return the same checksum for the same input
+struct text_kernel {
+    const char *name;
+    uint64_t (*fn)(const char *text, size_t cnt);
+    bool supported;
+};
+
+//pcmpistri/pcmpestri, crc32 and the SSE4.1 parser (text_sse42.c, SSE4.2), nothing in there may be called
+//unless dispatch_supported() confirmed SSE4.2; the AVX2 kernels (text_avx2.c) need AVX2
+
+//CRC32C of all cnt * TEXT_STRIDE bytes as one message
+uint64_t crc32c_table(const char *text, size_t cnt);
+uint64_t crc32c_slice8(const char *text, size_t cnt);
+uint64_t crc32c_sse42(const char *text, size_t cnt);
+
+//sum of the lengths of all records
+uint64_t strlen_scalar(const char *text, size_t cnt);
+uint64_t strlen_libc(const char *text, size_t cnt);
+uint64_t strlen_sse42(const char *text, size_t cnt);
+uint64_t strlen_avx2(const char *text, size_t cnt);
+
+//offset of the first TEXT_ABSENT in all cnt * TEXT_STRIDE bytes, their number if there is none
+uint64_t memchr_scalar(const char *text, size_t cnt);
+uint64_t memchr_libc(const char *text, size_t cnt);
+uint64_t memchr_sse42(const char *text, size_t cnt);
+uint64_t memchr_avx2(const char *text, size_t cnt);
+
+//sum of the values of all records
+uint64_t parse_strtol(const char *text, size_t cnt);
+uint64_t parse_scalar(const char *text, size_t cnt);
+uint64_t parse_swar(const char *text, size_t cnt);
+uint64_t parse_sse41(const char *text, size_t cnt);
+
+struct text_ctx {
+    const char *text;           //TEXT_RECORDS records followed by TEXT_GUARD bytes
+    uint64_t (*fn)(const char *text, size_t cnt);
+    uint64_t sink;
+};
+
+//SSE4.2 registry entry: hardware CRC32C, the table-driven CRC as emulation
+struct bench_env;
+void *text_setup(const struct bench_env *env, uint64_t *ops);
+void crc32c_run(void *ctx);
+void crc32c_run_emulated(void *ctx);
+
+int text_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//AVX2 byte compares, this translation unit is compiled for AVX2
+//nothing in here may be called unless dispatch_supported() confirmed AVX2
+#pragma GCC target("avx2")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <immintrin.h>
+#include "text.h"
+
+//one 32 byte compare covers a whole record including its NUL
+uint64_t strlen_avx2(const char *text, size_t cnt) {
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t sum = 0;
+
+    for(size_t i=0; i<cnt; i++) {
+        const char *str = text + i * TEXT_STRIDE;
+        for(size_t len=0; ; len+=32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i *) (str + len));
+            uint32_t hits = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero));
+            if(hits) {
+                sum += len + (size_t) __builtin_ctz(hits);
+                break;
+            }
+        }
+    }
+    return sum;
+}
+
+//two vectors per iteration, the compares of 64 bytes are or'ed before the single branch
+uint64_t memchr_avx2(const char *text, size_t cnt) {
+    const size_t bytes = cnt * TEXT_STRIDE;
+    const __m256i needle = _mm256_set1_epi8(TEXT_ABSENT);
+    size_t i = 0;
+
+    for(; i + 64 <= bytes; i += 64) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (text + i)), needle);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (text + i + 32)), needle);
+        if(!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+            uint64_t hits = (uint32_t) _mm256_movemask_epi8(a) | (uint64_t) (uint32_t) _mm256_movemask_epi8(b) << 32;
+            return i + (size_t) __builtin_ctzll(hits);
+        }
+    }
+    for(; i < bytes; i++) {
+        if(text[i] == TEXT_ABSENT) {
+            return i;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//SSE4.2 string instructions and crc32, this translation unit is compiled for SSE4.2 (SSE4.1 and SSSE3 implied)
+//nothing in here may be called unless dispatch_supported() confirmed SSE4.2
+#pragma GCC target("sse4.2")
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <immintrin.h>
+#include "text.h"
+
+//eight bytes per crc32 instruction, a single dependency chain: bound by its 3 cycle latency
+uint64_t crc32c_sse42(const char *text, size_t cnt) {
+    const size_t bytes = cnt * TEXT_STRIDE;
+    uint64_t crc = 0xffffffff;
+    size_t i = 0;
+
+    for(; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        memcpy(&word, text + i, sizeof(word));
+        crc = _mm_crc32_u64(crc, word);
+    }
+    for(; i < bytes; i++) {
+        crc = _mm_crc32_u8((uint32_t) crc, (uint8_t) text[i]);
+    }
+    return (uint32_t) ~crc;
+}
+
+//pcmpistri with an empty first operand: in equal each mode only the positions past the end of the
+//second operand compare true, so the least significant match is the length of the chunk (16 without NUL)
+static inline size_t strlen_pcmpistri(const char *str) {
+    const __m128i empty = _mm_setzero_si128();
+    for(size_t len=0; ; len+=16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (str + len));
+        int idx = _mm_cmpistri(empty, chunk, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH | _SIDD_LEAST_SIGNIFICANT);
+        if(idx < 16) {
+            return len + (size_t) idx;
+        }
+    }
+}
+
+uint64_t strlen_sse42(const char *text, size_t cnt) {
+    uint64_t sum = 0;
+    for(size_t i=0; i<cnt; i++) {
+        sum += strlen_pcmpistri(text + i * TEXT_STRIDE);
+    }
+    return sum;
+}
+
+//pcmpestri with explicit lengths, the buffer holds NULs so the implicit length variant cannot be used
+uint64_t memchr_sse42(const char *text, size_t cnt) {
+    const size_t bytes = cnt * TEXT_STRIDE;
+    const __m128i needle = _mm_set1_epi8(TEXT_ABSENT);
+
+    for(size_t i=0; i<bytes; i+=16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (text + i));
+        int len = bytes - i < 16 ? (int) (bytes - i) : 16;
+        int idx = _mm_cmpestri(needle, 1, chunk, len, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if(idx < 16) {
+            return i + (size_t) idx;
+        }
+    }
+    return bytes;
+}
+
+//16 digits in three multiply-add steps: pairs (pmaddubsw), quads (pmaddwd), octets (pmaddwd after packusdw)
+uint64_t parse_sse41(const char *text, size_t cnt) {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i mul10 = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+    const __m128i mul100 = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+    const __m128i mul10000 = _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1);
+    uint64_t sum = 0;
+
+    for(size_t i=0; i<cnt; i++) {
+        __m128i digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i *) (text + i * TEXT_STRIDE)), zero);
+        __m128i pairs = _mm_maddubs_epi16(digits, mul10);
+        __m128i quads = _mm_madd_epi16(pairs, mul100);
+        __m128i octets = _mm_madd_epi16(_mm_packus_epi32(quads, quads), mul10000);
+        sum += (uint64_t) (uint32_t) _mm_cvtsi128_si32(octets) * 100000000 +
+               (uint32_t) _mm_extract_epi32(octets, 1);
+    }
+    return sum;
+}
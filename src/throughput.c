@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "throughput.h"
+
+#define COLUMN_WIDTH 24
+
+struct bulk_ctx {
+    uint64_t (*fn)(const uint64_t *data, size_t cnt);
+    const uint64_t *data;
+    size_t cnt;
+    uint64_t sink;
+};
+
+static void bulk_run(void *arg) {
+    struct bulk_ctx *ctx = arg;
+    ctx->sink += ctx->fn(ctx->data, ctx->cnt);
+}
+
+//measures one pass of kernel over cnt elements, result is in ns per element
+int throughput_measure(const struct bulk_kernel *kernel, const uint64_t *data, size_t cnt,
+                       const struct measure_config *config, struct measure_result *result) {
+    struct bulk_ctx ctx = {kernel->fn, data, cnt, 0};
+    struct measure_kernel measure_kernel = {NULL, bulk_run, &ctx, cnt};
+    return measure_run(&measure_kernel, config, result);
+}
+
+static void print_size(size_t bytes) {
+    if(bytes >= ((size_t) 1 << 20)) {
+        printf("%6zu MiB", bytes >> 20);
+    } else {
+        printf("%6zu KiB", bytes >> 10);
+    }
+}
+
+//runs every supported kernel over buffers from THROUGHPUT_MIN_BYTES to max_bytes
+//and prints ops per (TSC) cycle and GB/s for each size, returns -1 if a measurement failed
+int throughput_sweep(const struct bulk_kernel *kernels, size_t kernel_cnt, const uint64_t *data,
+                     size_t max_bytes, const struct measure_config *config) {
+    struct measure_result result;
+
+    printf("Throughput in ops/cycle | GB/s:\r\n%10s", "size");
+    for(size_t k=0; k<kernel_cnt; k++) {
+        printf("%*s", COLUMN_WIDTH, kernels[k].name);
+    }
+    printf("\r\n");
+
+    for(size_t bytes=THROUGHPUT_MIN_BYTES; bytes<=max_bytes; bytes*=THROUGHPUT_STEP) {
+        print_size(bytes);
+        for(size_t k=0; k<kernel_cnt; k++) {
+            if(!kernels[k].supported) {
+                printf("%*s", COLUMN_WIDTH, "unsupported");
+                continue;
+            }
+            if(throughput_measure(&kernels[k], data, bytes / sizeof(*data), config, &result) != 0) {
+                printf("\r\n");
+                return -1;
+            }
+            //ns per op equals bytes per ns divided by 8, and bytes per ns equals GB/s
+            printf("%*.3f | %7.2f", COLUMN_WIDTH - 10, 1.0 / (result.median * timer_info.cycles_per_ns),
+                   sizeof(*data) / result.median);
+        }
+        printf("\r\n");
+        fflush(stdout);
+    }
+    return 0;
+}
+
+//prints the latency of one link of each kernel's dependency chain in (TSC) cycles
+int latency_report(const struct bulk_kernel *kernels, size_t kernel_cnt, const uint64_t *data,
+                   const struct measure_config *config) {
+    struct measure_result result;
+
+    printf("Latency in cycles per dependent op (incl. 1 xor):\r\n");
+    for(size_t k=0; k<kernel_cnt; k++) {
+        if(!kernels[k].supported) {
+            printf("%-24s unsupported\r\n", kernels[k].name);
+            continue;
+        }
+        if(throughput_measure(&kernels[k], data, LATENCY_BYTES / sizeof(*data), config, &result) != 0) {
+            return -1;
+        }
+        printf("%-24s %.3f cycles (%.3f ns)\r\n", kernels[k].name,
+               result.median * timer_info.cycles_per_ns, result.median);
+    }
+    return 0;
+}
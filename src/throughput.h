@@ -0,0 +1,37 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef THROUGHPUT
+#define THROUGHPUT
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "measure.h"
+
+#define THROUGHPUT_MIN_BYTES ((size_t) 16 << 10)  //fits into every L1D
+#define THROUGHPUT_MAX_BYTES ((size_t) 256 << 20) //well beyond every LLC
+#define THROUGHPUT_STEP 4                         //growth factor between two buffer sizes
+#define LATENCY_BYTES ((size_t) 16 << 10)
+
+//kernel that processes cnt 64 bit elements and returns a checksum of its results
+struct bulk_kernel {
+    const char *name;
+    uint64_t (*fn)(const uint64_t *data, size_t cnt);
+    bool supported;
+};
+
+int throughput_measure(const struct bulk_kernel *kernel, const uint64_t *data, size_t cnt,
+                       const struct measure_config *config, struct measure_result *result);
+int throughput_sweep(const struct bulk_kernel *kernels, size_t kernel_cnt, const uint64_t *data,
+                     size_t max_bytes, const struct measure_config *config);
+int latency_report(const struct bulk_kernel *kernels, size_t kernel_cnt, const uint64_t *data,
+                   const struct measure_config *config);
+
+#endif
@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include "cpuinfo.h"
+#include "timing.h"
+
+#define CALIBRATION_ROUNDS 5
+#define CALIBRATION_NS 10000000 //10 ms per round
+#define OVERHEAD_ROUNDS 10000
+
+struct timer_info timer_info = {false, false, 0.0, 1.0, 0};
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+//returns TSC frequency in GHz measured against CLOCK_MONOTONIC_RAW (median of CALIBRATION_ROUNDS)
+static double calibrate_tsc(void) {
+    double rates[CALIBRATION_ROUNDS];
+
+    for(uint32_t i=0; i<CALIBRATION_ROUNDS; i++) {
+        uint64_t start_ns = clock_ns();
+        uint64_t start_tsc = rdtsc_serialized();
+        uint64_t end_ns;
+        do {
+            end_ns = clock_ns();
+        } while(end_ns - start_ns < CALIBRATION_NS);
+        uint64_t end_tsc = rdtsc_serialized();
+        rates[i] = (double) (end_tsc - start_tsc) / (double) (end_ns - start_ns);
+    }
+
+    qsort(rates, CALIBRATION_ROUNDS, sizeof(rates[0]), compare_double);
+    return rates[CALIBRATION_ROUNDS / 2];
+}
+
+//returns the smallest number of ticks an empty timed region takes
+static uint64_t measure_overhead(void) {
+    uint64_t min = UINT64_MAX;
+
+    for(uint32_t i=0; i<OVERHEAD_ROUNDS; i++) {
+        uint64_t start = timing_start();
+        uint64_t stop = timing_stop();
+        if(stop - start < min) {
+            min = stop - start;
+        }
+    }
+    return min;
+}
+
+//selects the clock source, calibrates it and measures its overhead
+//the TSC is only used if it ticks at a constant rate in all P-/C-states (invariant TSC)
+void timing_init(const struct cpu_info *info) {
+    timer_info.cycles_per_ns = calibrate_tsc();
+    timer_info.tsc = info->INVARIANT_TSC;
+    timer_info.rdtscp = info->RDTSCP;
+    timer_info.ticks_per_ns = timer_info.tsc ? timer_info.cycles_per_ns : 1.0;
+    timer_info.overhead = 0;
+    timer_info.overhead = measure_overhead();
+}
@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef TIMING
+#define TIMING
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "cpuinfo.h"
+
+//clock source shared by all benches, filled once by timing_init()
+struct timer_info {
+    bool tsc;              //true if the invariant TSC is used, false if clock_gettime is used
+    bool rdtscp;           //stop timestamps are taken with rdtscp instead of lfence;rdtsc
+    double cycles_per_ns;  //calibrated TSC frequency in GHz
+    double ticks_per_ns;   //ticks returned by timing_start/timing_stop per nanosecond
+    uint64_t overhead;     //ticks of an empty timing_start/timing_stop pair
+};
+
+extern struct timer_info timer_info;
+
+static inline uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static inline uint64_t rdtsc_serialized(void) {
+    uint32_t lo, hi;
+    //lfence keeps earlier instructions from completing after the read and later ones from starting before
+    __asm__ volatile ("lfence \n\t"
+                      "rdtsc \n\t"
+                      "lfence"
+        :"=a"(lo), "=d"(hi)
+        :
+        :"memory"
+    );
+    return ((uint64_t) hi << 32) | lo;
+}
+
+static inline uint64_t rdtscp_serialized(void) {
+    uint32_t lo, hi, aux;
+    //rdtscp waits for all previous instructions, lfence keeps later ones from starting early
+    __asm__ volatile ("rdtscp \n\t"
+                      "lfence"
+        :"=a"(lo), "=d"(hi), "=c"(aux)
+        :
+        :"memory"
+    );
+    return ((uint64_t) hi << 32) | lo;
+}
+
+//timestamp at the beginning of a timed region
+static inline uint64_t timing_start(void) {
+    if(timer_info.tsc) {
+        return rdtsc_serialized();
+    }
+    return clock_ns();
+}
+
+//timestamp at the end of a timed region
+static inline uint64_t timing_stop(void) {
+    if(timer_info.tsc) {
+        return timer_info.rdtscp ? rdtscp_serialized() : rdtsc_serialized();
+    }
+    return clock_ns();
+}
+
+//ticks between start and stop without the overhead of the timer itself
+static inline uint64_t timing_elapsed(uint64_t start, uint64_t stop) {
+    uint64_t ticks = stop - start;
+    return ticks > timer_info.overhead ? ticks - timer_info.overhead : 0;
+}
+
+static inline double timing_to_ns(double ticks) {
+    return ticks / timer_info.ticks_per_ns;
+}
+
+static inline double timing_to_cycles(double ticks) {
+    return timing_to_ns(ticks) * timer_info.cycles_per_ns;
+}
+
+void timing_init(const struct cpu_info *info);
+
+#endif
@@ -0,0 +1,407 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+//paging: dependent loads with one node per 4 KiB page over working sets from TLB_MIN_BYTES up, backed by
+//base pages, transparent huge pages and hugetlbfs pages; the same node layout in every backing makes the
+//cache footprint identical, so the latency difference between backings is the cost of the page walks
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+#include "cpuinfo.h"
+#include "timing.h"
+#include "measure.h"
+#include "corpus.h"
+#include "registry.h"
+#include "memory.h"
+#include "tlb.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#define MAP_HUGE_2M (21 << MAP_HUGE_SHIFT)
+#define MAP_HUGE_1G (30 << MAP_HUGE_SHIFT)
+#define HUGE_2M ((size_t) 2 << 20)
+#define HUGE_1G ((size_t) 1 << 30)
+#define SIZE_CNT 16 //TLB_MIN_BYTES doubled up to TLB_MAX_BYTES and one spare
+
+static const char *const backing_names[TLB_BACKING_CNT] = {"4K", "THP", "2M", "1G"};
+static const size_t page_sizes[TLB_BACKING_CNT] = {TLB_PAGE, HUGE_2M, HUGE_2M, HUGE_1G};
+static const char *const pattern_names[TLB_PATTERN_CNT] = {"Random page order", "Strided, one page after the other"};
+
+//***********************************************
+//*******************MAPPINGS********************
+//***********************************************
+
+//maps bytes rounded up to the page size of backing, 0 on success, -1 if the kernel refuses
+int tlb_map(struct tlb_mapping *mapping, enum tlb_backing backing, size_t bytes) {
+    const size_t page = page_sizes[backing];
+    const size_t size = (bytes + page - 1) & ~(page - 1);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t mapped = size;
+
+    if(backing == TLB_HUGETLB_2M || backing == TLB_HUGETLB_1G) {
+        flags |= MAP_HUGETLB | (backing == TLB_HUGETLB_2M ? MAP_HUGE_2M : MAP_HUGE_1G);
+    } else {
+        //NORESERVE like the corpus arena, the caller checked MemAvailable
+        flags |= MAP_NORESERVE;
+        mapped += backing == TLB_THP ? HUGE_2M : 0; //room to align the start to a huge page
+    }
+    void *base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(base == MAP_FAILED) {
+        return -1;
+    }
+    mapping->base = base;
+    mapping->mapped = mapped;
+    mapping->size = size;
+    mapping->start = base;
+    if(backing == TLB_THP) {
+        mapping->start = (uint8_t *) (((uintptr_t) base + HUGE_2M - 1) & ~(uintptr_t) (HUGE_2M - 1));
+        if(madvise(mapping->start, size, MADV_HUGEPAGE) != 0) {
+            tlb_unmap(mapping);
+            return -1;
+        }
+    } else if(backing == TLB_4K) {
+        //fails on kernels without THP, which back everything with base pages anyway
+        madvise(base, size, MADV_NOHUGEPAGE);
+    }
+    return 0;
+}
+
+void tlb_unmap(struct tlb_mapping *mapping) {
+    munmap(mapping->base, mapping->mapped);
+    mapping->base = NULL;
+}
+
+//MemAvailable from /proc/meminfo in bytes, 0 if unknown
+static size_t mem_available(void) {
+    FILE *file = fopen("/proc/meminfo", "r");
+    char line[128];
+    unsigned long long kib = 0;
+    if(file == NULL) {
+        return 0;
+    }
+    while(fgets(line, sizeof(line), file)) {
+        if(sscanf(line, "MemAvailable: %llu kB", &kib) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return (size_t) kib << 10;
+}
+
+//share of the mapping the kernel backed with transparent huge pages (AnonHugePages in smaps), -1 if unknown
+static double thp_share(const struct tlb_mapping *mapping) {
+    FILE *file = fopen("/proc/self/smaps", "r");
+    char line[256];
+    bool inside = false;
+    double share = -1.0;
+    if(file == NULL) {
+        return -1.0;
+    }
+    while(fgets(line, sizeof(line), file)) {
+        unsigned long long lo, hi, kib;
+        //mapping headers start with the address range, no key (AnonHugePages, FilePmdMapped, ...) parses as one
+        if(sscanf(line, "%llx-%llx ", &lo, &hi) == 2) {
+            inside = lo <= (uintptr_t) mapping->start && (uintptr_t) mapping->start < hi;
+        } else if(inside && sscanf(line, "AnonHugePages: %llu kB", &kib) == 1) {
+            share = (double) (kib << 10) / mapping->size;
+            break;
+        }
+    }
+    fclose(file);
+    return share > 1.0 ? 1.0 : share;
+}
+
+//***********************************************
+//*******************KERNELS*********************
+//***********************************************
+
+//links one line per TLB_PAGE of the first bytes of buf into a cycle; the line within the page is random
+//for TLB_RANDOM and advances by one per page for TLB_STRIDED, so no two nodes compete for one L1 set
+static void *tlb_chase_build(uint8_t *buf, size_t bytes, enum tlb_pattern pattern, uint32_t *order,
+                             struct rng *rng) {
+    const size_t nodes = bytes / TLB_PAGE;
+    const size_t lines = TLB_PAGE / MEMORY_LINE;
+
+    for(size_t i=0; i<nodes; i++) {
+        order[i] = (uint32_t) i;
+    }
+    if(pattern == TLB_RANDOM) {
+        for(size_t i=nodes - 1; i>0; i--) {
+            size_t k = rng_below(rng, i + 1);
+            uint32_t tmp = order[i];
+            order[i] = order[k];
+            order[k] = tmp;
+        }
+    }
+    void **first = NULL, **prev = NULL;
+    for(size_t i=0; i<nodes; i++) {
+        size_t line = pattern == TLB_RANDOM ? rng_below(rng, lines) : i % lines;
+        void **node = (void **) (buf + (size_t) order[i] * TLB_PAGE + line * MEMORY_LINE);
+        if(prev) {
+            *prev = node;
+        } else {
+            first = node;
+        }
+        prev = node;
+    }
+    *prev = first;
+    return first;
+}
+
+//median ns of a dependent load, dTLB misses per load in *misses if counted (-1 otherwise), 0 on failure
+static double tlb_measure(const struct measure_config *config, void *first, double *misses) {
+    struct chase_ctx ctx = {first};
+    struct measure_kernel kernel = {NULL, chase_run, &ctx, CHASE_STEPS};
+    struct measure_result result;
+
+    *misses = -1.0;
+    if(measure_run(&kernel, config, &result) != 0) {
+        return 0.0;
+    }
+    if(result.counted && result.counters.valid[COUNTER_DTLB_MISSES] && result.counters.ops > 0) {
+        *misses = result.counters.count[COUNTER_DTLB_MISSES] / result.counters.ops;
+    }
+    return result.median;
+}
+
+//median ns to fault in one page of a fresh mapping, the first write also zeroes it; 0 if unavailable,
+//-1 if THP fell back to base pages (one write per 2 MiB would then only fault a single 4 KiB page)
+static double first_touch(enum tlb_backing backing) {
+    const size_t page = page_sizes[backing];
+    const size_t bytes = TLB_FAULT_BYTES > page ? TLB_FAULT_BYTES : page;
+    double ns[TLB_FAULT_ROUNDS];
+
+    for(uint32_t r=0; r<TLB_FAULT_ROUNDS; r++) {
+        struct tlb_mapping mapping;
+        if(tlb_map(&mapping, backing, bytes) != 0) {
+            return 0.0;
+        }
+        volatile uint8_t *p = mapping.start;
+        uint64_t start = timing_start();
+        for(size_t off=0; off<mapping.size; off+=page) {
+            p[off] = 1;
+        }
+        uint64_t stop = timing_stop();
+        const double share = backing == TLB_THP ? thp_share(&mapping) : 1.0;
+        tlb_unmap(&mapping);
+        if(share < TLB_THP_FULL) {
+            return -1.0;
+        }
+        ns[r] = timing_to_ns((double) timing_elapsed(start, stop)) / (mapping.size / page);
+        for(uint32_t k=r; k>0 && ns[k] < ns[k - 1]; k--) {
+            double tmp = ns[k];
+            ns[k] = ns[k - 1];
+            ns[k - 1] = tmp;
+        }
+    }
+    return ns[TLB_FAULT_ROUNDS / 2];
+}
+
+//***********************************************
+//*********************SUITE*********************
+//***********************************************
+
+struct tlb_results {
+    size_t sizes[SIZE_CNT];
+    uint32_t size_cnt;
+    bool measured[TLB_BACKING_CNT][SIZE_CNT];
+    double ns[TLB_BACKING_CNT][TLB_PATTERN_CNT][SIZE_CNT];
+    double misses[TLB_BACKING_CNT][TLB_PATTERN_CNT][SIZE_CNT];
+};
+
+static void print_size(size_t bytes, int width) {
+    printf("%*zu %s", width, bytes >= HUGE_1G ? bytes >> 30 : bytes >> 20, bytes >= HUGE_1G ? "GiB" : "MiB");
+}
+
+//maps the largest working set that fits into backing and measures every size up to it in both patterns
+static int measure_backing(const struct bench_env *env, const struct measure_config *config,
+                           enum tlb_backing backing, size_t max_bytes, uint32_t *order, struct tlb_results *results) {
+    struct tlb_mapping mapping;
+    size_t bytes = max_bytes;
+
+    //the hugetlb pools hold what the administrator reserved, take the largest size they can back
+    while(tlb_map(&mapping, backing, bytes) != 0) {
+        bytes /= 2;
+        if(bytes < TLB_MIN_BYTES || bytes < page_sizes[backing]) {
+            printf("%-4s not available%s\r\n", backing_names[backing], backing == TLB_4K || backing == TLB_THP ? "" :
+                   backing == TLB_HUGETLB_2M ? ", reserve pages in /sys/kernel/mm/hugepages/hugepages-2048kB/nr_hugepages"
+                                             : ", reserve pages in /sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages");
+            return 0;
+        }
+    }
+    //commit every page before timing, THP gets its huge pages on this first fault if any are free
+    memset(mapping.start, 0, bytes);
+    printf("%-4s %zu MiB mapped", backing_names[backing], bytes >> 20);
+    if(backing == TLB_4K || backing == TLB_THP) {
+        double share = thp_share(&mapping);
+        if(share >= 0.0) {
+            printf(", %.0f%% in transparent huge pages", share * 100.0);
+        }
+    }
+    printf("\r\n");
+    fflush(stdout);
+
+    for(uint32_t s=0; s<results->size_cnt && results->sizes[s]<=bytes; s++) {
+        for(int p=0; p<TLB_PATTERN_CNT; p++) {
+            void *first = tlb_chase_build(mapping.start, results->sizes[s], p, order, &env->corpus->rng);
+            double ns = tlb_measure(config, first, &results->misses[backing][p][s]);
+            if(ns == 0.0) {
+                tlb_unmap(&mapping);
+                return -1;
+            }
+            results->ns[backing][p][s] = ns;
+        }
+        results->measured[backing][s] = true;
+    }
+    tlb_unmap(&mapping);
+    return 0;
+}
+
+//lowest latency of all backings at one size, the reference without (or with the fewest) page walks
+static double best_ns(const struct tlb_results *results, int pattern, uint32_t s) {
+    double best = 0.0;
+    for(int b=0; b<TLB_BACKING_CNT; b++) {
+        if(results->measured[b][s] && (best == 0.0 || results->ns[b][pattern][s] < best)) {
+            best = results->ns[b][pattern][s];
+        }
+    }
+    return best;
+}
+
+//one table per pattern: latency of every backing, its extra cost over the best backing (the page walks)
+//and with --counters the dTLB misses per load
+static void print_pattern(const struct tlb_results *results, int pattern, bool counted) {
+    printf("%s, ns per dependent load, +walk: ns over the best backing\r\n%10s", pattern_names[pattern], "size");
+    for(int b=0; b<TLB_BACKING_CNT; b++) {
+        printf(" %8s %7s", backing_names[b], "+walk");
+    }
+    if(counted) {
+        for(int b=0; b<TLB_BACKING_CNT; b++) {
+            printf(" %6s%-3s", "miss/", backing_names[b]);
+        }
+    }
+    printf("\r\n");
+    for(uint32_t s=0; s<results->size_cnt; s++) {
+        const double best = best_ns(results, pattern, s);
+        print_size(results->sizes[s], 6);
+        for(int b=0; b<TLB_BACKING_CNT; b++) {
+            if(results->measured[b][s]) {
+                printf(" %8.1f %7.1f", results->ns[b][pattern][s], results->ns[b][pattern][s] - best);
+            } else {
+                printf(" %8s %7s", "-", "-");
+            }
+        }
+        for(int b=0; b<TLB_BACKING_CNT && counted; b++) {
+            if(results->measured[b][s] && results->misses[b][pattern][s] >= 0.0) {
+                printf(" %9.2f", results->misses[b][pattern][s]);
+            } else {
+                printf(" %9s", "-");
+            }
+        }
+        printf("\r\n");
+    }
+}
+
+//TLB reach: the largest working set a backing covers in random order without paying for page walks
+static void print_reach(const struct tlb_results *results) {
+    printf("TLB reach (random order within %.0f%% or %.0f ns of the best backing):\r\n",
+           (TLB_WALK_SLACK - 1.0) * 100.0, TLB_WALK_NS);
+    for(int b=0; b<TLB_BACKING_CNT; b++) {
+        uint32_t last = UINT32_MAX, measured = 0;
+        bool walked = false;
+        for(uint32_t s=0; s<results->size_cnt && results->measured[b][s]; s++) {
+            measured = s + 1;
+            const double best = best_ns(results, TLB_RANDOM, s);
+            const double ns = results->ns[b][TLB_RANDOM][s];
+            if(!walked && (ns <= best * TLB_WALK_SLACK || ns <= best + TLB_WALK_NS)) {
+                last = s;
+            } else {
+                walked = true;
+            }
+        }
+        if(measured == 0) {
+            continue;
+        }
+        printf("%-4s ", backing_names[b]);
+        if(last == UINT32_MAX) {
+            printf("below %zu MiB\r\n", results->sizes[0] >> 20);
+        } else if(!walked) {
+            printf("at least ");
+            print_size(results->sizes[last], 0);
+            printf(", no walks up to the largest working set\r\n");
+        } else {
+            print_size(results->sizes[last], 0);
+            printf("\r\n");
+        }
+    }
+}
+
+//random and strided dependent loads over 1 MiB to several GiB in every page size the kernel provides,
+//the page walk cost and TLB reach derived from them, and the first touch cost of every page size
+int tlb_suite(const struct bench_env *env) {
+    struct measure_config config = *env->config;
+    struct tlb_results *results = calloc(1, sizeof(*results));
+    size_t max_bytes = TLB_MAX_BYTES;
+    const size_t available = mem_available();
+    int status = 0;
+
+    if(available > 0 && max_bytes > available / 2) {
+        max_bytes = available / 2;
+    }
+    //node order of the largest working set, one entry per TLB_PAGE
+    uint32_t *order = malloc(max_bytes / TLB_PAGE * sizeof(*order));
+    if(results == NULL || order == NULL || max_bytes < TLB_MIN_BYTES) {
+        status = -1;
+        goto out;
+    }
+    for(size_t bytes=TLB_MIN_BYTES; bytes<=max_bytes && results->size_cnt<SIZE_CNT; bytes*=2) {
+        results->sizes[results->size_cnt++] = bytes;
+    }
+    max_bytes = results->sizes[results->size_cnt - 1];
+    config.max_seconds = config.max_seconds < TLB_POINT_SECONDS ? config.max_seconds : TLB_POINT_SECONDS;
+
+    printf("One line per 4 KiB page in every backing, working sets up to %zu MiB (half of MemAvailable at most)\r\n",
+           max_bytes >> 20);
+    for(int b=0; b<TLB_BACKING_CNT && status==0; b++) {
+        status = measure_backing(env, &config, b, max_bytes, order, results);
+    }
+    if(status != 0) {
+        goto out;
+    }
+    for(int p=0; p<TLB_PATTERN_CNT; p++) {
+        print_pattern(results, p, config.counters != NULL);
+    }
+    print_reach(results);
+
+    printf("First touch of a fresh mapping (page fault and zeroing):\r\n%-4s %12s %12s %10s\r\n",
+           "", "us/page", "ns/4 KiB", "GB/s");
+    for(int b=0; b<TLB_BACKING_CNT; b++) {
+        double ns = first_touch(b);
+        if(ns <= 0.0) {
+            printf("%-4s %12s %12s %10s%s\r\n", backing_names[b], "-", "-", "-",
+                   ns < 0.0 ? "  kernel did not grant transparent huge pages" : "");
+            continue;
+        }
+        printf("%-4s %12.2f %12.1f %10.2f\r\n", backing_names[b], ns / 1e3, ns * TLB_PAGE / page_sizes[b],
+               page_sizes[b] / ns);
+        fflush(stdout);
+    }
+
+out:
+    free(results);
+    free(order);
+    return status;
+}
@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef TLB
+#define TLB
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define TLB_MIN_BYTES ((size_t) 1 << 20)
+#define TLB_MAX_BYTES ((size_t) 4 << 30)    //capped at half of MemAvailable
+#define TLB_PAGE 4096                       //one chase node per base page, whatever the backing
+#define TLB_FAULT_BYTES ((size_t) 64 << 20) //first touch region, at least one page of the backing
+#define TLB_FAULT_ROUNDS 3                  //map/touch/unmap rounds, the median is reported
+#define TLB_POINT_SECONDS 0.5               //time budget per working set, pattern and backing
+#define TLB_WALK_SLACK 1.10                 //latency over the best backing that still counts as TLB hits,
+#define TLB_WALK_NS 2.0                     //or this many ns over it, small working sets are noise dominated
+#define TLB_THP_FULL 0.99                   //THP share of the first touch region below which its fault cost is not shown
+
+//how the working set is backed
+enum tlb_backing {
+    TLB_4K,         //MADV_NOHUGEPAGE, base pages even with THP set to always
+    TLB_THP,        //2 MiB aligned and MADV_HUGEPAGE, whether huge pages are used is up to khugepaged and the fault path
+    TLB_HUGETLB_2M, //MAP_HUGETLB from the reserved 2 MiB pool
+    TLB_HUGETLB_1G, //MAP_HUGETLB from the reserved 1 GiB pool
+    TLB_BACKING_CNT
+};
+
+enum tlb_pattern {
+    TLB_RANDOM,     //pages in random order
+    TLB_STRIDED,    //pages in address order, the line within the page advances by one per page
+    TLB_PATTERN_CNT
+};
+
+struct tlb_mapping {
+    uint8_t *base;  //returned by mmap, passed to munmap
+    uint8_t *start; //page aligned start of the working set
+    size_t size;    //usable bytes from start
+    size_t mapped;  //bytes passed to munmap
+};
+
+int tlb_map(struct tlb_mapping *mapping, enum tlb_backing backing, size_t bytes);
+void tlb_unmap(struct tlb_mapping *mapping);
+
+struct bench_env;
+int tlb_suite(const struct bench_env *env);
+
+#endif
@@ -0,0 +1,351 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <cpuid.h>
+#include "topology.h"
+
+#define LEVEL_TYPE_SMT 1
+#define SYSFS_CORE_CPUS "/sys/devices/cpu_core/cpus"  //perf PMU of the P-cores, only present on hybrid CPUs
+#define SYSFS_ATOM_CPUS "/sys/devices/cpu_atom/cpus"
+#define SYSFS_NODE "/sys/devices/system/node"
+
+static uint32_t ceil_log2(uint32_t val) {
+    uint32_t shift = 0;
+    while(((uint32_t) 1 << shift) < val) shift++;
+    return shift;
+}
+
+//reads the x2APIC id and level shifts of the current CPU from leaf 0x1F or 0x0B
+//returns false if neither leaf enumerates a topology
+static bool read_extended_topology(uint32_t *apic_id, uint32_t *smt_shift, uint32_t *package_shift) {
+    uint32_t values[4];
+    uint32_t max_leaf = __get_cpuid_max(0, NULL);
+    *apic_id = 0;
+    uint32_t leaf = 0;
+
+    if(max_leaf >= 0x1F) {
+        __cpuid_count(0x1F, 0, values[0], values[1], values[2], values[3]);
+        if(values[1] != 0) leaf = 0x1F;
+    }
+    if(leaf == 0 && max_leaf >= 0x0B) {
+        __cpuid_count(0x0B, 0, values[0], values[1], values[2], values[3]);
+        if(values[1] != 0) leaf = 0x0B;
+    }
+    if(leaf == 0) {
+        return false;
+    }
+
+    *smt_shift = 0;
+    *package_shift = 0;
+    for(uint32_t sub=0; ; sub++) {
+        __cpuid_count(leaf, sub, values[0], values[1], values[2], values[3]);
+        uint32_t type = (values[2] >> 8) & 0xff;
+        if(type == 0) break;
+        if(type == LEVEL_TYPE_SMT) *smt_shift = values[0] & 0x1f;
+        *package_shift = values[0] & 0x1f; //the last level decides what is left for the package id
+        *apic_id = values[3];
+    }
+    return true;
+}
+
+//legacy enumeration from leaf 1/4 (Intel) or 0x80000008 (AMD) with 8 bit APIC ids
+static void read_legacy_topology(uint32_t *apic_id, uint32_t *smt_shift, uint32_t *package_shift) {
+    uint32_t values[4];
+    uint32_t logical = 1, cores = 1;
+
+    __cpuid(1, values[0], values[1], values[2], values[3]);
+    *apic_id = values[1] >> 24;
+    if(values[3] & ((uint32_t)1 << 28)) {
+        logical = (values[1] >> 16) & 0xff;
+    }
+    if(__get_cpuid_max(0, NULL) >= 4) {
+        __cpuid_count(4, 0, values[0], values[1], values[2], values[3]);
+        if((values[0] & 0x1f) != 0) cores = (values[0] >> 26) + 1;
+    }
+    if(cores == 1 && __get_cpuid(0x80000008, &values[0], &values[1], &values[2], &values[3])) {
+        cores = (values[2] & 0xff) + 1;
+    }
+    if(logical < cores) logical = cores;
+    *smt_shift = ceil_log2(logical / cores);
+    *package_shift = ceil_log2(logical);
+}
+
+//deterministic cache parameters, leaf 4 on Intel and 0x8000001D with the same layout on AMD
+static void read_caches(struct cpu_topology *topology) {
+    uint32_t values[4];
+    uint32_t leaf = 4;
+
+    topology->cache_cnt = 0;
+    if(__get_cpuid_max(0, NULL) < 4) {
+        leaf = 0x8000001D;
+    } else {
+        __cpuid_count(4, 0, values[0], values[1], values[2], values[3]);
+        if((values[0] & 0x1f) == 0) leaf = 0x8000001D;
+    }
+    if(leaf == 0x8000001D && __get_cpuid_max(0x80000000, NULL) < 0x8000001D) {
+        return;
+    }
+
+    for(uint32_t sub=0; topology->cache_cnt<TOPOLOGY_MAX_CACHES; sub++) {
+        __cpuid_count(leaf, sub, values[0], values[1], values[2], values[3]);
+        uint8_t type = values[0] & 0x1f;
+        if(type == 0) break;
+        struct cache_info *cache = &topology->caches[topology->cache_cnt++];
+        cache->type = type;
+        cache->level = (values[0] >> 5) & 0x7;
+        cache->shared_by = ((values[0] >> 14) & 0xfff) + 1;
+        cache->ways = ((values[1] >> 22) & 0x3ff) + 1;
+        cache->line = (values[1] & 0xfff) + 1;
+        cache->sets = values[2] + 1;
+        cache->size = cache->ways * (((values[1] >> 12) & 0x3ff) + 1) * cache->line * cache->sets;
+    }
+}
+
+//CPUID.7.EDX[15], leaf 0x1A is only meaningful on hybrid CPUs
+static bool read_hybrid(void) {
+    uint32_t values[4];
+    if(__get_cpuid_max(0, NULL) < 0x1A) {
+        return false;
+    }
+    __cpuid_count(7, 0, values[0], values[1], values[2], values[3]);
+    return (values[3] & ((uint32_t)1 << 15)) != 0;
+}
+
+//reads a sysfs list ("0-15,24,26-27") of cpu or node numbers into set, false if the file is missing
+static bool read_sysfs_list(const char *path, cpu_set_t *set) {
+    uint32_t first, last;
+    FILE *file = fopen(path, "r");
+    CPU_ZERO(set);
+    if(file == NULL) {
+        return false;
+    }
+    while(fscanf(file, "%u", &first) == 1) {
+        int next = fgetc(file);
+        last = first;
+        if(next == '-') {
+            if(fscanf(file, "%u", &last) != 1) break;
+            next = fgetc(file);
+        }
+        for(uint32_t i=first; i<=last && i<CPU_SETSIZE; i++) {
+            CPU_SET(i, set);
+        }
+        if(next != ',') break;
+    }
+    fclose(file);
+    return true;
+}
+
+//assigns type to the CPUs of a sysfs cpulist whose type CPUID did not report,
+//hypervisors often hide leaf 0x1A while the kernel still knows the core types
+static void read_sysfs_core_type(struct cpu_topology *topology, const char *path, uint8_t type) {
+    cpu_set_t set;
+    if(!read_sysfs_list(path, &set)) {
+        return;
+    }
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        struct logical_cpu *entry = &topology->cpus[i];
+        if(entry->cpu < CPU_SETSIZE && CPU_ISSET(entry->cpu, &set) && entry->core_type == CORE_TYPE_UNKNOWN) {
+            entry->core_type = type;
+        }
+    }
+}
+
+//online NUMA nodes with their CPUs, memory and distances from /sys/devices/system/node; without that
+//directory (kernels built without NUMA) everything is one node at the local distance
+static void read_numa(struct cpu_topology *topology) {
+    cpu_set_t online, memory, cpus;
+    char path[96];
+
+    if(!read_sysfs_list(SYSFS_NODE "/online", &online)) {
+        CPU_ZERO(&online);
+        CPU_SET(0, &online);
+    }
+    bool known = read_sysfs_list(SYSFS_NODE "/has_memory", &memory);
+    topology->node_cnt = 0;
+    for(uint32_t id=0; id<CPU_SETSIZE && topology->node_cnt<TOPOLOGY_MAX_NODES; id++) {
+        if(!CPU_ISSET(id, &online)) continue;
+        struct numa_node *node = &topology->nodes[topology->node_cnt++];
+        node->id = id;
+        node->memory = !known || CPU_ISSET(id, &memory);
+        node->cpu_cnt = 0;
+        snprintf(path, sizeof(path), SYSFS_NODE "/node%u/cpulist", id);
+        if(!read_sysfs_list(path, &cpus)) {
+            //single node fallback: every CPU is local
+            CPU_ZERO(&cpus);
+            for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+                if(topology->cpus[i].cpu < CPU_SETSIZE) CPU_SET(topology->cpus[i].cpu, &cpus);
+            }
+        }
+        for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+            if(topology->cpus[i].cpu < CPU_SETSIZE && CPU_ISSET(topology->cpus[i].cpu, &cpus)) {
+                topology->cpus[i].node = id;
+                node->cpu_cnt++;
+            }
+        }
+    }
+    //one distance per online node in the order of the online list, 10 is local
+    for(uint32_t n=0; n<topology->node_cnt; n++) {
+        struct numa_node *node = &topology->nodes[n];
+        snprintf(path, sizeof(path), SYSFS_NODE "/node%u/distance", node->id);
+        FILE *file = fopen(path, "r");
+        for(uint32_t k=0; k<topology->node_cnt; k++) {
+            uint32_t distance = 0;
+            if(file == NULL || fscanf(file, "%u", &distance) != 1) {
+                distance = n == k ? 10 : 20;
+            }
+            node->distance[k] = distance;
+        }
+        if(file) fclose(file);
+    }
+}
+
+//distinct core types among the enumerated CPUs, P-cores first
+static void collect_core_types(struct cpu_topology *topology) {
+    static const uint8_t order[TOPOLOGY_MAX_CORE_TYPES] = {CORE_TYPE_CORE, CORE_TYPE_ATOM};
+    topology->core_type_cnt = 0;
+    for(uint32_t t=0; t<TOPOLOGY_MAX_CORE_TYPES; t++) {
+        if(topology_core_type_cpus(topology, order[t]) > 0) {
+            topology->core_types[topology->core_type_cnt++] = order[t];
+        }
+    }
+}
+
+//pins the calling thread to every CPU it may run on in turn and decodes that CPU's APIC id and core type
+//the original affinity is restored afterwards
+void set_topology(struct cpu_topology *topology) {
+    cpu_set_t allowed, single;
+    uint32_t apic_id, smt_shift, package_shift;
+    uint32_t values[4];
+    const bool hybrid = read_hybrid();
+
+    memset(topology, 0, sizeof(*topology));
+    read_caches(topology);
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(sched_getcpu(), &allowed);
+    }
+
+    for(uint32_t cpu=0; cpu<CPU_SETSIZE && topology->cpu_cnt<TOPOLOGY_MAX_CPUS; cpu++) {
+        if(!CPU_ISSET(cpu, &allowed)) continue;
+        CPU_ZERO(&single);
+        CPU_SET(cpu, &single);
+        if(sched_setaffinity(0, sizeof(single), &single) != 0) continue;
+
+        if(!read_extended_topology(&apic_id, &smt_shift, &package_shift)) {
+            read_legacy_topology(&apic_id, &smt_shift, &package_shift);
+        }
+        struct logical_cpu *entry = &topology->cpus[topology->cpu_cnt++];
+        entry->cpu = cpu;
+        entry->apic_id = apic_id;
+        entry->smt = apic_id & (((uint32_t) 1 << smt_shift) - 1);
+        entry->core = (apic_id & (((uint32_t) 1 << package_shift) - 1)) >> smt_shift;
+        entry->package = apic_id >> package_shift;
+        if(hybrid) {
+            __cpuid_count(0x1A, 0, values[0], values[1], values[2], values[3]);
+            entry->core_type = values[0] >> 24;
+        }
+        topology->smt_shift = smt_shift;
+        topology->package_shift = package_shift;
+    }
+    sched_setaffinity(0, sizeof(allowed), &allowed);
+    read_sysfs_core_type(topology, SYSFS_CORE_CPUS, CORE_TYPE_CORE);
+    read_sysfs_core_type(topology, SYSFS_ATOM_CPUS, CORE_TYPE_ATOM);
+    collect_core_types(topology);
+    read_numa(topology);
+}
+
+//number of distinct physical cores among the enumerated CPUs
+uint32_t topology_cores(const struct cpu_topology *topology) {
+    uint32_t cores = 0;
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        bool first = true;
+        for(uint32_t k=0; k<i && first; k++) {
+            first = topology->cpus[k].package != topology->cpus[i].package
+                 || topology->cpus[k].core != topology->cpus[i].core;
+        }
+        cores += first;
+    }
+    return cores;
+}
+
+uint32_t topology_packages(const struct cpu_topology *topology) {
+    uint32_t packages = 0;
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        bool first = true;
+        for(uint32_t k=0; k<i && first; k++) {
+            first = topology->cpus[k].package != topology->cpus[i].package;
+        }
+        packages += first;
+    }
+    return packages;
+}
+
+//returns the data or unified cache of the given level, NULL if there is none
+const struct cache_info *topology_cache(const struct cpu_topology *topology, uint8_t level) {
+    for(uint32_t i=0; i<topology->cache_cnt; i++) {
+        if(topology->caches[i].level == level && topology->caches[i].type != 2) {
+            return &topology->caches[i];
+        }
+    }
+    return NULL;
+}
+
+//id shared by all logical CPUs behind the same cache of the given level (e.g. one L3 slice group or CCX),
+//derived from the x2APIC id like the package id; UINT32_MAX if the level is unknown
+uint32_t topology_cache_domain(const struct cpu_topology *topology, const struct logical_cpu *cpu, uint8_t level) {
+    const struct cache_info *cache = topology_cache(topology, level);
+    if(cache == NULL || cache->shared_by == 0) {
+        return UINT32_MAX;
+    }
+    return cpu->apic_id >> ceil_log2(cache->shared_by);
+}
+
+const char *topology_core_type_name(uint8_t core_type) {
+    switch(core_type) {
+        case CORE_TYPE_CORE: return "P-core";
+        case CORE_TYPE_ATOM: return "E-core";
+        default: return "unknown";
+    }
+}
+
+//OS cpu number of the first CPU of the given core type, preferring the first thread of a core; -1 if there is none
+int topology_core_type_cpu(const struct cpu_topology *topology, uint8_t core_type) {
+    int found = -1;
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        if(topology->cpus[i].core_type != core_type) continue;
+        if(topology->cpus[i].smt == 0) return (int) topology->cpus[i].cpu;
+        if(found < 0) found = (int) topology->cpus[i].cpu;
+    }
+    return found;
+}
+
+uint32_t topology_core_type_cpus(const struct cpu_topology *topology, uint8_t core_type) {
+    uint32_t cnt = 0;
+    for(uint32_t i=0; i<topology->cpu_cnt; i++) {
+        cnt += topology->cpus[i].core_type == core_type;
+    }
+    return cnt;
+}
+
+//index of the NUMA node with OS number id in topology->nodes, -1 if it is not online
+int topology_node(const struct cpu_topology *topology, uint32_t id) {
+    for(uint32_t n=0; n<topology->node_cnt; n++) {
+        if(topology->nodes[n].id == id) {
+            return (int) n;
+        }
+    }
+    return -1;
+}
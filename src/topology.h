@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2019 Johannes Bonk and Maximilian Ley
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+
+#ifndef TOPOLOGY
+#define TOPOLOGY
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TOPOLOGY_MAX_CPUS 1024
+#define TOPOLOGY_MAX_CACHES 8
+#define TOPOLOGY_MAX_CORE_TYPES 2
+#define TOPOLOGY_MAX_NODES 64
+
+//core type of a hybrid CPU as reported in CPUID leaf 0x1A EAX[31:24], 0 on CPUs that are not hybrid
+enum core_type {
+    CORE_TYPE_UNKNOWN = 0x00,
+    CORE_TYPE_ATOM = 0x20,    //E-core
+    CORE_TYPE_CORE = 0x40     //P-core
+};
+
+//one logical CPU this process may run on, ids are decoded from its x2APIC id
+struct logical_cpu {
+    uint32_t cpu;      //OS cpu number as used by sched_setaffinity
+    uint32_t apic_id;
+    uint32_t package;
+    uint32_t core;     //unique within its package
+    uint32_t smt;      //thread index within its core
+    uint8_t core_type; //enum core_type
+    uint32_t node;     //OS number of its NUMA node
+};
+
+//one cache level as reported by CPUID leaf 4 (Intel) or 0x8000001D (AMD)
+struct cache_info {
+    uint8_t level;
+    uint8_t type;        //1 data, 2 instruction, 3 unified
+    uint32_t size;       //bytes
+    uint32_t ways;
+    uint32_t line;       //bytes
+    uint32_t sets;
+    uint32_t shared_by;  //max. logical CPUs sharing this cache
+};
+
+//one online NUMA node as listed in /sys/devices/system/node
+struct numa_node {
+    uint32_t id;                              //OS node number as used by mbind
+    bool memory;                              //has memory of its own, CPU-only nodes do not
+    uint32_t cpu_cnt;                         //CPUs of this node the process may run on
+    uint32_t distance[TOPOLOGY_MAX_NODES];    //SLIT distance to every node in topology order, 10 is local
+};
+
+struct cpu_topology {
+    uint32_t cpu_cnt;
+    uint32_t smt_shift;      //x2APIC id bits below the core id
+    uint32_t package_shift;  //x2APIC id bits below the package id
+    struct logical_cpu cpus[TOPOLOGY_MAX_CPUS];
+    uint32_t cache_cnt;
+    struct cache_info caches[TOPOLOGY_MAX_CACHES];
+    uint32_t core_type_cnt;  //distinct core types, P-cores first; 0 if the CPU is not hybrid
+    uint8_t core_types[TOPOLOGY_MAX_CORE_TYPES];
+    uint32_t node_cnt;       //online NUMA nodes, 1 without NUMA
+    struct numa_node nodes[TOPOLOGY_MAX_NODES];
+};
+
+void set_topology(struct cpu_topology *topology);
+uint32_t topology_cores(const struct cpu_topology *topology);
+uint32_t topology_packages(const struct cpu_topology *topology);
+const struct cache_info *topology_cache(const struct cpu_topology *topology, uint8_t level);
+const char *topology_core_type_name(uint8_t core_type);
+int topology_core_type_cpu(const struct cpu_topology *topology, uint8_t core_type);
+uint32_t topology_core_type_cpus(const struct cpu_topology *topology, uint8_t core_type);
+int topology_node(const struct cpu_topology *topology, uint32_t id);
+uint32_t topology_cache_domain(const struct cpu_topology *topology, const struct logical_cpu *cpu, uint8_t level);
+
+#endif